@@ -0,0 +1,144 @@
+﻿//-----------------------------------------------------------------------------
+// File : AnimationConverter.h
+// Desc : Skeleton And Animation Converter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asdxResModel.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+struct aiScene;
+struct aiAnimation;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Joint structure
+///////////////////////////////////////////////////////////////////////////////
+struct Joint
+{
+    std::string     Name;               //!< ノード名です.
+    uint32_t        Hash;               //!< ノード名ハッシュです.
+    int32_t         Parent;             //!< 親関節番号です. ルートの場合は -1.
+    asdx::Vector3   BindTranslation;    //!< バインドポーズの平行移動成分です(親空間).
+    asdx::Vector4   BindRotation;       //!< バインドポーズの回転成分です(親空間, xyzw).
+    asdx::Vector3   BindScale;          //!< バインドポーズの拡大縮小成分です(親空間).
+    asdx::Vector4   InvBindPose[3];     //!< 逆バインド行列の上3行です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Skeleton structure
+///////////////////////////////////////////////////////////////////////////////
+struct Skeleton
+{
+    std::vector<Joint>  Joints;         //!< 関節です. 親は必ず子より前に格納されます.
+
+    //-------------------------------------------------------------------------
+    //! @brief      関節番号を検索します.
+    //!
+    //! @param[in]      hash        ノード名ハッシュです.
+    //! @return     関節番号を返却します. 見つからない場合は -1 を返却します.
+    //-------------------------------------------------------------------------
+    int32_t Find(uint32_t hash) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AnimationTrack structure
+///////////////////////////////////////////////////////////////////////////////
+struct AnimationTrack
+{
+    uint16_t                JointIndex;         //!< 関節番号です.
+    asdx::Vector3           PositionMin;        //!< 平行移動の最小値です.
+    asdx::Vector3           PositionExtent;     //!< 平行移動の範囲です.
+    asdx::Vector3           ScaleMin;           //!< 拡大縮小の最小値です.
+    asdx::Vector3           ScaleExtent;        //!< 拡大縮小の範囲です.
+    std::vector<uint16_t>   PositionKeys;       //!< 平行移動キーです [時刻, x, y, z] x キー数.
+    std::vector<uint16_t>   RotationKeys;       //!< 回転キーです [時刻, 最小3成分(48bit)] x キー数.
+    std::vector<uint16_t>   ScaleKeys;          //!< 拡大縮小キーです [時刻, x, y, z] x キー数.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AnimationClip structure
+///////////////////////////////////////////////////////////////////////////////
+struct AnimationClip
+{
+    std::string                 Name;           //!< クリップ名です.
+    uint32_t                    Hash;           //!< クリップ名ハッシュです.
+    float                       Duration;       //!< 長さ(秒)です.
+    std::vector<AnimationTrack> Tracks;         //!< トラックです.
+    size_t                      SourceKeyCount; //!< 削減前のキー数です.
+    size_t                      KeyCount;       //!< 削減後のキー数です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AnimationCompressOption structure
+///////////////////////////////////////////////////////////////////////////////
+struct AnimationCompressOption
+{
+    float   PositionTolerance   = 1e-3f;    //!< 平行移動の許容誤差です.
+    float   RotationTolerance   = 1e-3f;    //!< 回転の許容誤差(ラジアン)です.
+    float   ScaleTolerance      = 1e-3f;    //!< 拡大縮小の許容誤差です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      スケルトンを構築します.
+//!
+//! @details    メッシュのボーンが参照するノードとその祖先を関節として抽出します.
+//!
+//! @param[in]      pScene      入力シーンです.
+//! @param[out]     skeleton    スケルトンの格納先です.
+//! @retval true    構築に成功.
+//! @retval false   ボーンが無いかノードが見つからない.
+//-----------------------------------------------------------------------------
+bool BuildSkeleton(const aiScene* pScene, Skeleton& skeleton);
+
+//-----------------------------------------------------------------------------
+//! @brief      アニメーションを変換します.
+//!
+//! @details    キーフレームを線形補間で再現できる範囲で削減し，
+//!             回転は最小3成分の48bit，平行移動と拡大縮小はトラック範囲で16bitに量子化します.
+//!
+//! @param[in]      pSrcAnimation   入力アニメーションです.
+//! @param[in]      skeleton        スケルトンです.
+//! @param[in]      option          圧縮オプションです.
+//! @param[out]     clip            変換結果の格納先です.
+//-----------------------------------------------------------------------------
+void ConvertAnimation(
+    const aiAnimation*              pSrcAnimation,
+    const Skeleton&                 skeleton,
+    const AnimationCompressOption&  option,
+    AnimationClip&                  clip);
+
+//-----------------------------------------------------------------------------
+//! @brief      スケルトンとアニメーションをバイナリデータに変換します.
+//!
+//! @param[in]      skeleton    スケルトンです.
+//! @param[in]      clips       アニメーションクリップです.
+//! @param[out]     data        変換結果の格納先です. ExportAnimation() の出力と同じ内容です.
+//-----------------------------------------------------------------------------
+void BuildAnimationData(
+    const Skeleton&                     skeleton,
+    const std::vector<AnimationClip>&   clips,
+    std::vector<uint8_t>&               data);
+
+//-----------------------------------------------------------------------------
+//! @brief      スケルトンとアニメーションをバイナリファイルに出力します.
+//!
+//! @param[in]      path        出力ファイルパスです.
+//! @param[in]      skeleton    スケルトンです.
+//! @param[in]      clips       アニメーションクリップです.
+//! @retval true    出力に成功.
+//! @retval false   出力に失敗.
+//-----------------------------------------------------------------------------
+bool ExportAnimation(
+    const char*                         path,
+    const Skeleton&                     skeleton,
+    const std::vector<AnimationClip>&   clips);
\ No newline at end of file
@@ -0,0 +1,123 @@
+﻿//-----------------------------------------------------------------------------
+// File : ConvertCache.h
+// Desc : Conversion Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ConvertCache class
+///////////////////////////////////////////////////////////////////////////////
+class ConvertCache
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ConvertCache() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュファイルを読み込みます.
+    //!
+    //! @details    ファイルが存在しない場合は空のキャッシュとして成功します.
+    //!
+    //! @param[in]      path        キャッシュファイルパスです.
+    //! @retval true    読み込みに成功.
+    //! @retval false   読み込みに失敗.
+    //-------------------------------------------------------------------------
+    bool Load(const char* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュファイルに書き出します.
+    //!
+    //! @param[in]      path        キャッシュファイルパスです.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    bool Save(const char* path) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      前回の変換結果が有効かどうかチェックします.
+    //!
+    //! @param[in]      key         入力ファイルを識別するキーです.
+    //! @param[in]      fileHash    入力ファイルの内容のハッシュです.
+    //! @param[in]      optionHash  変換オプションのハッシュです.
+    //! @retval true    前回と同じ入力とオプションで変換済み.
+    //! @retval false   再変換が必要.
+    //-------------------------------------------------------------------------
+    bool IsUpToDate(const std::string& key, uint64_t fileHash, uint64_t optionHash) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      変換結果を記録します.
+    //!
+    //! @param[in]      key         入力ファイルを識別するキーです.
+    //! @param[in]      fileHash    入力ファイルの内容のハッシュです.
+    //! @param[in]      optionHash  変換オプションのハッシュです.
+    //-------------------------------------------------------------------------
+    void Update(const std::string& key, uint64_t fileHash, uint64_t optionHash);
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        uint64_t    FileHash;       //!< 入力ファイルの内容のハッシュです.
+        uint64_t    OptionHash;     //!< 変換オプションのハッシュです.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    mutable std::mutex                      m_Mutex;        //!< ミューテックスです.
+    std::unordered_map<std::string, Entry>  m_Entries;      //!< 変換済みのエントリーです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    ConvertCache    (const ConvertCache&) = delete;
+    void operator = (const ConvertCache&) = delete;
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      ファイルの内容のハッシュを計算します.
+//!
+//! @param[in]      path        ファイルパスです.
+//! @param[out]     hash        ハッシュの格納先です.
+//! @retval true    計算に成功.
+//! @retval false   ファイルを開けなかった.
+//-----------------------------------------------------------------------------
+bool CalcFileHash(const char* path, uint64_t& hash);
+
+//-----------------------------------------------------------------------------
+//! @brief      変換オプションのハッシュを計算します.
+//!
+//! @param[in]      argc        引数の数です.
+//! @param[in]      argv        引数です.
+//! @return     ハッシュを返却します.
+//-----------------------------------------------------------------------------
+uint64_t CalcOptionHash(int argc, const char* const* argv);
\ No newline at end of file
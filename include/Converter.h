@@ -0,0 +1,186 @@
+﻿//-----------------------------------------------------------------------------
+// File : Converter.h
+// Desc : Model Converter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <MappedModel.h>
+#include <MeshLoader.h>
+#include <TextureConverter.h>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CONVERT_RESULT
+///////////////////////////////////////////////////////////////////////////////
+enum CONVERT_RESULT
+{
+    CONVERT_RESULT_OK,          //!< 変換に成功しました.
+    CONVERT_RESULT_FAILED,      //!< 変換に失敗しました.
+    CONVERT_RESULT_CANCELED,    //!< 進捗コールバックにより中断されました.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ConvertArgs structure
+///////////////////////////////////////////////////////////////////////////////
+struct ConvertArgs
+{
+    std::string             Input;              //!< 入力ファイルパスです(-i).
+    std::string             Output;             //!< 出力ファイルパスです(-o).
+    std::string             MaterialYaml;       //!< マテリアルYAMLの出力パスです(-m).
+    std::string             MaterialTable;      //!< マテリアルテーブルの出力パスです(-mb).
+    std::string             TextureIndex;       //!< テクスチャ依存関係の出力パスです(-tdep).
+    std::string             Skin;               //!< スキニングデータの出力パスです(-skin).
+    std::string             Animation;          //!< アニメーションの出力パスです(-anim).
+    std::string             Mapped;             //!< メモリマップ可能な形式の出力パスです(-mapped).
+    std::string             Shadow;             //!< シャドウメッシュの出力パスです(-shadow).
+    bool                    Stream = false;     //!< メッシュを構築するたびにメモリマップ形式へ追記するならtrue(-stream).
+    MeshLoaderOption        Option;             //!< ロードオプションです.
+    MappedModelOption       MappedOption;       //!< メモリマップ形式の出力オプションです.
+    TextureConvertOption    TexOption;          //!< テクスチャ変換オプションです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ConvertStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct ConvertStats
+{
+    double      ElapsedMsec         = 0.0;  //!< 変換にかかった時間(ミリ秒)です.
+    uint32_t    MeshCount           = 0;    //!< 出力メッシュ数です.
+    uint32_t    MaterialCount       = 0;    //!< マテリアル数です.
+    uint32_t    TextureCount        = 0;    //!< テクスチャ数です.
+    uint32_t    FailedTextureCount  = 0;    //!< 変換に失敗したテクスチャ数です.
+    uint64_t    VertexCount         = 0;    //!< 出力頂点数です.
+    uint64_t    PrimitiveCount      = 0;    //!< 出力三角形数です.
+    uint32_t    MeshletCount        = 0;    //!< 出力メッシュレット数です.
+    uint64_t    ShadowVertexCount   = 0;    //!< シャドウメッシュの頂点数です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ConvertOutput structure
+///////////////////////////////////////////////////////////////////////////////
+struct ConvertOutput
+{
+    asdx::ResModel              Model;          //!< モデルです.
+    std::vector<Material>       Materials;      //!< マテリアルです.
+    std::vector<TextureEntry>   Textures;       //!< テクスチャです. 埋め込みテクスチャはファイルイメージを保持します.
+    std::vector<SkinStream>     Skins;          //!< スキニングデータです.
+    Skeleton                    Bones;          //!< スケルトンです.
+    std::vector<AnimationClip>  Animations;     //!< アニメーションクリップです.
+    std::vector<ShadowMesh>     ShadowMeshes;   //!< シャドウメッシュです.
+    std::vector<uint8_t>        MaterialTable;  //!< マテリアルテーブル(-mb の出力と同じ内容)です.
+    std::vector<uint8_t>        SkinData;       //!< スキニングデータ(-skin の出力と同じ内容)です.
+    std::vector<uint8_t>        AnimationData;  //!< アニメーションデータ(-anim の出力と同じ内容)です.
+    std::vector<uint8_t>        ShadowData;     //!< シャドウメッシュ(-shadow の出力と同じ内容)です.
+    ConvertStats                Stats;          //!< 統計情報です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      スキニングデータをバイナリデータに変換します.
+//!
+//! @param[in]      skins       スキニングデータです.
+//! @param[out]     data        変換結果の格納先です.
+//-----------------------------------------------------------------------------
+void BuildSkinData(const std::vector<SkinStream>& skins, std::vector<uint8_t>& data);
+
+//-----------------------------------------------------------------------------
+//! @brief      シャドウメッシュをバイナリデータに変換します.
+//!
+//! @param[in]      shadows     シャドウメッシュです.
+//! @param[out]     data        変換結果の格納先です.
+//-----------------------------------------------------------------------------
+void BuildShadowData(const std::vector<ShadowMesh>& shadows, std::vector<uint8_t>& data);
+
+//-----------------------------------------------------------------------------
+//! @brief      コマンドライン引数を解析します.
+//!
+//! @param[in]      argc        引数の数です.
+//! @param[in]      argv        引数です.
+//! @param[out]     args        解析結果の格納先です.
+//! @retval true    解析に成功.
+//! @retval false   不正な引数が含まれている.
+//-----------------------------------------------------------------------------
+bool ParseArgs(int argc, const char* const* argv, ConvertArgs& args);
+
+//-----------------------------------------------------------------------------
+//! @brief      相対パスを基準ディレクトリからのパスに変換します.
+//!
+//! @details    変換サーバーはクライアントと作業ディレクトリが異なるため，
+//!             リクエストを処理する前に全ての入出力パスを絶対パスにします.
+//!
+//! @param[in]      baseDir     基準ディレクトリです.
+//! @param[in,out]  args        変換するパスを含む引数です.
+//-----------------------------------------------------------------------------
+void ResolvePaths(const std::string& baseDir, ConvertArgs& args);
+
+//-----------------------------------------------------------------------------
+//! @brief      出力パスの "{name}" を置換します.
+//!
+//! @details    複数のモデルを同じ引数で変換する場合に，モデルごとの出力先を決めるために使います.
+//!
+//! @param[in]      name        置換する名前です.
+//! @param[in,out]  args        置換するパスを含む引数です.
+//-----------------------------------------------------------------------------
+void ExpandPaths(const std::string& name, ConvertArgs& args);
+
+//-----------------------------------------------------------------------------
+//! @brief      モデルごとの出力ファイルパスを取得します.
+//!
+//! @details    指定されているものだけを -o, -mapped, その他の順に格納します.
+//!             テクスチャなどのディレクトリ指定は含みません.
+//!
+//! @param[in]      args        変換引数です.
+//! @param[out]     paths       出力ファイルパスの格納先です.
+//-----------------------------------------------------------------------------
+void GetOutputPaths(const ConvertArgs& args, std::vector<std::string>& paths);
+
+//-----------------------------------------------------------------------------
+//! @brief      複数のモデルを変換できる出力パスかどうかチェックします.
+//!
+//! @details    モデルごとに出力先を分けるため，出力ファイルパスが1つ以上あり，
+//!             全てに "{name}" が含まれている必要があります. 不正な場合はエラーを出力します.
+//!
+//! @param[in]      args        変換引数です.
+//! @retval true    全ての出力ファイルパスに "{name}" が含まれている.
+//! @retval false   出力ファイルパスが無い または "{name}" を含まないものがある.
+//-----------------------------------------------------------------------------
+bool ValidateNamedOutputs(const ConvertArgs& args);
+
+//-----------------------------------------------------------------------------
+//! @brief      モデルを変換します.
+//!
+//! @details    ロード, テクスチャ変換, 各種ファイル出力を行います.
+//!             呼び出しごとに独立した状態を使うため，複数スレッドから同時に呼び出せます.
+//!
+//! @param[in]      args        変換引数です.
+//! @param[out]     pStats      統計情報の格納先です. nullptr の場合は格納しません.
+//! @retval true    変換に成功.
+//! @retval false   変換に失敗.
+//-----------------------------------------------------------------------------
+bool Convert(const ConvertArgs& args, ConvertStats* pStats = nullptr);
+
+//-----------------------------------------------------------------------------
+//! @brief      メモリ上のファイルイメージを変換します.
+//!
+//! @details    ファイルの入出力を行わずに変換結果をメモリ上に返却します.
+//!             テクスチャの変換は行わず，参照情報と埋め込みテクスチャのファイルイメージのみ返却します.
+//!             呼び出しごとに独立した状態を使うため，複数スレッドから同時に呼び出せます.
+//!
+//! @param[in]      pData       ファイルイメージです.
+//! @param[in]      size        ファイルイメージのサイズです.
+//! @param[in]      name        仮のファイル名です. 拡張子をフォーマットの判定に使います.
+//! @param[in]      option      ロードオプションです. Progress で進捗の通知と中断ができます.
+//! @param[out]     output      変換結果の格納先です.
+//! @return     変換結果を返却します.
+//-----------------------------------------------------------------------------
+CONVERT_RESULT ConvertMemory(
+    const void*             pData,
+    size_t                  size,
+    const char*             name,
+    const MeshLoaderOption& option,
+    ConvertOutput&          output);
\ No newline at end of file
@@ -0,0 +1,110 @@
+﻿//-----------------------------------------------------------------------------
+// File : ImporterPool.h
+// Desc : Assimp Importer Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+namespace Assimp {
+class Importer;
+} // namespace Assimp
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ImporterPool class
+///////////////////////////////////////////////////////////////////////////////
+class ImporterPool
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ImporterPool();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ImporterPool();
+
+    //-------------------------------------------------------------------------
+    //! @brief      インポーターを取得します.
+    //!
+    //! @details    空きが無い場合は新たに生成します. 同時に使うワーカー数だけ生成され，
+    //!             以降はローダーとポストプロセスの登録済みのものを使い回します.
+    //!
+    //! @return     インポーターを返却します.
+    //-------------------------------------------------------------------------
+    Assimp::Importer* Acquire();
+
+    //-------------------------------------------------------------------------
+    //! @brief      インポーターを返却します.
+    //!
+    //! @details    シーンを解放し，進捗コールバックを外してから再利用できる状態に戻します.
+    //!
+    //! @param[in]      pImporter   Acquire() で取得したインポーターです.
+    //-------------------------------------------------------------------------
+    void Release(Assimp::Importer* pImporter);
+
+    //-------------------------------------------------------------------------
+    //! @brief      進捗コールバックを設定します.
+    //!
+    //! @details    インポーターごとに生成時に登録した進捗ハンドラーから呼び出します.
+    //!             Assimp 4.1 の SetProgressHandler() は差し替え前のハンドラーを解放しないため，
+    //!             プールのインポーターには進捗ハンドラーを設定し直さないでください.
+    //!
+    //! @param[in]      pImporter   Acquire() で取得したインポーターです.
+    //! @param[in]      callback    進捗(0.0～1.0)を受け取るコールバックです. false を返却すると読み込みを中断します.
+    //-------------------------------------------------------------------------
+    void SetProgress(Assimp::Importer* pImporter, std::function<bool(float)> callback);
+
+    //-------------------------------------------------------------------------
+    //! @brief      生成したインポーター数を取得します.
+    //!
+    //! @return     生成したインポーター数を返却します.
+    //-------------------------------------------------------------------------
+    size_t GetCount() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    class Progress;
+
+    std::vector<std::unique_ptr<Assimp::Importer>>  m_Importers;    //!< 生成したインポーターです.
+    std::vector<Assimp::Importer*>                  m_Free;         //!< 空いているインポーターです.
+    std::unordered_map<Assimp::Importer*, Progress*> m_Progress;    //!< インポーターが所有する進捗ハンドラーです.
+    mutable std::mutex                              m_Mutex;        //!< ミューテックスです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    ImporterPool    (const ImporterPool&) = delete;
+    void operator = (const ImporterPool&) = delete;
+};
\ No newline at end of file
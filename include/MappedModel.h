@@ -0,0 +1,325 @@
+﻿//-----------------------------------------------------------------------------
+// File : MappedModel.h
+// Desc : Memory Mappable Model Format.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <VertexLayout.h>
+#include <asdxResModel.h>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MAPPED_STREAM
+///////////////////////////////////////////////////////////////////////////////
+enum MAPPED_STREAM
+{
+    MAPPED_STREAM_POSITION,         //!< 位置座標(asdx::Vector3)です.
+    MAPPED_STREAM_TANGENT_SPACE,    //!< 圧縮済みの接線空間(uint32_t)です.
+    MAPPED_STREAM_COLOR,            //!< 頂点カラー(uint32_t)です.
+    MAPPED_STREAM_TEXCOORD0,        //!< テクスチャ座標0(uint32_t)です.
+    MAPPED_STREAM_TEXCOORD1,        //!< テクスチャ座標1(uint32_t)です.
+    MAPPED_STREAM_TEXCOORD2,        //!< テクスチャ座標2(uint32_t)です.
+    MAPPED_STREAM_TEXCOORD3,        //!< テクスチャ座標3(uint32_t)です.
+    MAPPED_STREAM_BONE_INDEX,       //!< ボーン番号(asdx::ResBoneIndex)です.
+    MAPPED_STREAM_BONE_WEIGHT,      //!< ボーンの重み(asdx::Vector4)です.
+    MAPPED_STREAM_INDEX,            //!< 頂点番号(uint32_t)です.
+    MAPPED_STREAM_PRIMITIVE,        //!< プリミティブ(asdx::ResPrimitive)です.
+    MAPPED_STREAM_MESHLET,          //!< メッシュレット(asdx::ResMeshlet)です.
+    MAPPED_STREAM_CULLING_INFO,     //!< カリング情報(asdx::ResCullingInfo)です.
+    MAPPED_STREAM_VERTEX,           //!< 位置座標以外の属性をインターリーブした頂点データです.
+    MAPPED_STREAM_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedModelHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedModelHeader
+{
+    uint8_t     Magic[4];           //!< マジックです('M', 'M', 'D', '\0').
+    uint32_t    Version;            //!< ファイルバージョンです.
+    uint32_t    MeshCount;          //!< メッシュ数です.
+    uint32_t    Alignment;          //!< ストリームの配置境界(バイト)です.
+    uint64_t    MeshOffset;         //!< ファイル先頭からメッシュレコードまでのオフセットです.
+    uint64_t    FileSize;           //!< ファイルサイズです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedStream structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedStream
+{
+    uint64_t    Offset;             //!< ファイル先頭からのオフセットです. 空の場合は 0 です.
+    uint64_t    Size;               //!< サイズ(バイト)です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedMeshRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedMeshRecord
+{
+    uint32_t        MeshHash;                       //!< メッシュハッシュです.
+    uint32_t        MaterialHash;                   //!< マテリアルハッシュです.
+    uint32_t        VertexCount;                    //!< 頂点数です.
+    uint32_t        StreamMask;                     //!< データを持つストリームのビットマスクです.
+    uint32_t        VertexStride;                   //!< インターリーブした頂点の1頂点あたりのバイト数です.
+    uint32_t        VertexMask;                     //!< インターリーブした属性(VERTEX_ATTRIBUTE)のビットマスクです.
+    uint8_t         VertexOffsets[VERTEX_ATTRIBUTE_COUNT];  //!< インターリーブした属性の頂点先頭からのオフセットです.
+    MappedStream    Streams[MAPPED_STREAM_COUNT];   //!< ストリームです.
+};
+
+static const uint32_t kMappedModelVersion   = 2;
+static const uint32_t kMappedModelAlignment = 256;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedModelOption structure
+///////////////////////////////////////////////////////////////////////////////
+struct MappedModelOption
+{
+    uint32_t                        Alignment       = kMappedModelAlignment;    //!< ストリームの配置境界です. 2の累乗である必要があります.
+    std::vector<VERTEX_ATTRIBUTE>   VertexLayout;                               //!< インターリーブする属性の並び順です. 空の場合はインターリーブしません.
+    bool                            SeparateStreams = true;                     //!< インターリーブした属性も個別ストリームで出力するならtrue.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+///////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    MappedFile() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~MappedFile();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルを読み取り専用でメモリにマップします.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @retval true    マップに成功.
+    //! @retval false   マップに失敗.
+    //-------------------------------------------------------------------------
+    bool Open(const char* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マップを解除します.
+    //-------------------------------------------------------------------------
+    void Close();
+
+    //-------------------------------------------------------------------------
+    //! @brief      先頭アドレスを取得します.
+    //!
+    //! @return     マップした領域の先頭アドレスを返却します.
+    //-------------------------------------------------------------------------
+    const void* GetData() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      サイズを取得します.
+    //!
+    //! @return     ファイルサイズを返却します.
+    //-------------------------------------------------------------------------
+    size_t GetSize() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    void*       m_hFile     = nullptr;      //!< ファイルハンドルです.
+    void*       m_hMapping  = nullptr;      //!< ファイルマッピングハンドルです.
+    const void* m_pData     = nullptr;      //!< マップした領域です.
+    size_t      m_Size      = 0;            //!< ファイルサイズです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    MappedFile      (const MappedFile&) = delete;
+    void operator = (const MappedFile&) = delete;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedModelWriter class
+///////////////////////////////////////////////////////////////////////////////
+class MappedModelWriter
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    MappedModelWriter() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //!
+    //! @details    Close() せずに破棄した場合，ファイルのヘッダは無効なままになります.
+    //-------------------------------------------------------------------------
+    ~MappedModelWriter();
+
+    //-------------------------------------------------------------------------
+    //! @brief      出力ファイルを開きます.
+    //!
+    //! @param[in]      path        出力ファイルパスです.
+    //! @param[in]      option      出力オプションです.
+    //! @retval true    オープンに成功.
+    //! @retval false   オープンに失敗.
+    //-------------------------------------------------------------------------
+    bool Open(const char* path, const MappedModelOption& option = MappedModelOption());
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュのストリームを追記します.
+    //!
+    //! @details    ストリームはすぐにファイルへ書き出すので，呼び出し後にメッシュを破棄できます.
+    //!
+    //! @param[in]      mesh        メッシュです.
+    //! @retval true    追記に成功.
+    //! @retval false   追記に失敗.
+    //-------------------------------------------------------------------------
+    bool Append(const asdx::ResMesh& mesh);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュレコードを末尾に書き出し，ヘッダを確定させて閉じます.
+    //!
+    //! @retval true    出力に成功.
+    //! @retval false   出力に失敗.
+    //-------------------------------------------------------------------------
+    bool Close();
+
+    //-------------------------------------------------------------------------
+    //! @brief      追記したメッシュ数を取得します.
+    //!
+    //! @return     追記したメッシュ数を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t GetMeshCount() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    FILE*                           m_pFile     = nullptr;  //!< 出力ファイルです.
+    MappedModelOption               m_Option;               //!< 出力オプションです.
+    uint32_t                        m_Alignment = kMappedModelAlignment;    //!< ストリームの配置境界です.
+    uint64_t                        m_Offset    = 0;        //!< 次に書き込むファイル先頭からのオフセットです.
+    std::vector<MappedMeshRecord>   m_Records;              //!< 末尾に書き出すメッシュレコードです.
+    bool                            m_Failed    = false;    //!< 書き込みに失敗したらtrue.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      データを書き込みます.
+    //!
+    //! @param[in]      pData       データです. nullptr の場合はゼロで埋めます.
+    //! @param[in]      size        サイズです.
+    //! @retval true    書き込みに成功.
+    //! @retval false   書き込みに失敗.
+    //-------------------------------------------------------------------------
+    bool Write(const void* pData, uint64_t size);
+
+    MappedModelWriter   (const MappedModelWriter&) = delete;
+    void operator =     (const MappedModelWriter&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      モデルをメモリマップ可能な形式に変換します.
+//!
+//! @details    [ヘッダ][メッシュレコード][ストリーム...] の順に並び，
+//!             各ストリームは配置境界に揃えられます.
+//!             マップしたままオフセットで参照でき，読み込み時の解析やコピーが不要です.
+//!             位置座標は深度パス用に常に個別ストリームで出力します.
+//!
+//! @param[in]      model       モデルです.
+//! @param[in]      option      出力オプションです.
+//! @param[out]     data        変換結果の格納先です.
+//-----------------------------------------------------------------------------
+void BuildMappedModel(
+    const asdx::ResModel&       model,
+    const MappedModelOption&    option,
+    std::vector<uint8_t>&       data);
+
+//-----------------------------------------------------------------------------
+//! @brief      モデルをメモリマップ可能な形式でファイルに出力します.
+//!
+//! @param[in]      path        出力ファイルパスです.
+//! @param[in]      model       モデルです.
+//! @param[in]      option      出力オプションです.
+//! @retval true    出力に成功.
+//! @retval false   出力に失敗.
+//-----------------------------------------------------------------------------
+bool ExportMappedModel(
+    const char*                 path,
+    const asdx::ResModel&       model,
+    const MappedModelOption&    option = MappedModelOption());
+
+//-----------------------------------------------------------------------------
+//! @brief      メモリマップ可能なモデルを検証します.
+//!
+//! @details    全てのストリームがファイル内に収まり，配置境界に揃っていることを確認します.
+//!
+//! @param[in]      pData       先頭アドレスです.
+//! @param[in]      size        サイズです.
+//! @return     有効な場合はヘッダを返却します. 無効な場合は nullptr を返却します.
+//-----------------------------------------------------------------------------
+const MappedModelHeader* GetMappedModel(const void* pData, size_t size);
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュレコードを取得します.
+//!
+//! @param[in]      pHeader     検証済みのヘッダです.
+//! @return     先頭のメッシュレコードを返却します.
+//-----------------------------------------------------------------------------
+const MappedMeshRecord* GetMappedMeshes(const MappedModelHeader* pHeader);
+
+//-----------------------------------------------------------------------------
+//! @brief      ストリームの先頭アドレスを取得します.
+//!
+//! @param[in]      pHeader     検証済みのヘッダです.
+//! @param[in]      pMesh       メッシュレコードです.
+//! @param[in]      stream      ストリームの種類です.
+//! @return     ストリームの先頭アドレスを返却します. 空の場合は nullptr を返却します.
+//-----------------------------------------------------------------------------
+const void* GetMappedStream(
+    const MappedModelHeader*    pHeader,
+    const MappedMeshRecord*     pMesh,
+    MAPPED_STREAM               stream);
\ No newline at end of file
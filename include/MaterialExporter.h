@@ -0,0 +1,215 @@
+﻿//-----------------------------------------------------------------------------
+// File : MaterialExporter.h
+// Desc : Material Table Exporter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <MeshLoader.h>
+#include <cstdint>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MaterialTableHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct MaterialTableHeader
+{
+    uint8_t     Magic[4];           //!< マジックです('M', 'T', 'B', '\0').
+    uint32_t    Version;            //!< ファイルバージョンです.
+    uint32_t    MaterialCount;      //!< マテリアル数です.
+    uint32_t    TextureCount;       //!< テクスチャ参照数です.
+    uint32_t    PathCount;          //!< テクスチャパス数です.
+    uint32_t    MaterialOffset;     //!< ファイル先頭からマテリアルレコードまでのオフセットです.
+    uint32_t    TextureOffset;      //!< ファイル先頭からテクスチャレコードまでのオフセットです.
+    uint32_t    PathOffset;         //!< ファイル先頭からテクスチャパスレコードまでのオフセットです.
+    uint32_t    StringOffset;       //!< ファイル先頭から文字列テーブルまでのオフセットです.
+    uint32_t    StringSize;         //!< 文字列テーブルのサイズです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MaterialRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct MaterialRecord
+{
+    uint32_t    Hash;               //!< マテリアル名ハッシュです.
+    uint32_t    NameOffset;         //!< 文字列テーブル内のマテリアル名のオフセットです.
+    uint32_t    TextureIndex;       //!< 先頭のテクスチャレコード番号です.
+    uint32_t    TextureCount;       //!< テクスチャレコード数です.
+    uint32_t    Features;           //!< MATERIAL_FEATURE の組み合わせです.
+    uint32_t    AlphaMode;          //!< アルファモード(ALPHA_MODE)です.
+    float       BaseColor[4];       //!< ベースカラー(RGBA)です.
+    float       Emissive[3];        //!< 自己発光色です.
+    float       Metallic;           //!< 金属度です.
+    float       Roughness;          //!< 粗さです.
+    float       AlphaCutoff;        //!< アルファテストの閾値です.
+    float       UVScale[2];         //!< UVの拡大率です.
+    float       UVOffset[2];        //!< UVの平行移動量です.
+    float       UVRotation;         //!< UVの回転角(ラジアン)です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MaterialTextureRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct MaterialTextureRecord
+{
+    uint32_t    Usage;              //!< 使用用途(TEXTURE_USAGE)です.
+    uint32_t    PathId;             //!< ファイルパスハッシュです.
+    uint32_t    PathOffset;         //!< 文字列テーブル内のファイルパスのオフセットです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TexturePathRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct TexturePathRecord
+{
+    uint32_t    Id;                 //!< ファイルパスハッシュです.
+    uint32_t    PathOffset;         //!< 文字列テーブル内のファイルパスのオフセットです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureIndexHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct TextureIndexHeader
+{
+    uint8_t     Magic[4];           //!< マジックです('T', 'D', 'X', '\0').
+    uint32_t    Version;            //!< ファイルバージョンです.
+    uint32_t    TextureCount;       //!< テクスチャ数です.
+    uint32_t    ReferenceCount;     //!< 参照元ハッシュの総数です.
+    uint32_t    TextureOffset;      //!< ファイル先頭からテクスチャレコードまでのオフセットです.
+    uint32_t    ReferenceOffset;    //!< ファイル先頭から参照元ハッシュまでのオフセットです.
+    uint32_t    StringOffset;       //!< ファイル先頭から文字列テーブルまでのオフセットです.
+    uint32_t    StringSize;         //!< 文字列テーブルのサイズです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureIndexRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct TextureIndexRecord
+{
+    uint32_t    Id;                 //!< ファイルパスハッシュです.
+    uint32_t    PathOffset;         //!< 文字列テーブル内のファイルパスのオフセットです.
+    uint32_t    MaterialIndex;      //!< 参照元マテリアルハッシュの先頭番号です.
+    uint32_t    MaterialCount;      //!< 参照元マテリアル数です.
+    uint32_t    MeshIndex;          //!< 参照元メッシュハッシュの先頭番号です.
+    uint32_t    MeshCount;          //!< 参照元メッシュ数です.
+};
+
+static const uint32_t kMaterialTableVersion = 3;
+static const uint32_t kTextureIndexVersion  = 1;
+
+
+//-----------------------------------------------------------------------------
+//! @brief      テクスチャ用途を文字列にします.
+//!
+//! @param[in]      usage       テクスチャ用途です.
+//! @return     用途名を返却します.
+//-----------------------------------------------------------------------------
+const char* ToString(TEXTURE_USAGE usage);
+
+//-----------------------------------------------------------------------------
+//! @brief      アルファモードを文字列にします.
+//!
+//! @param[in]      mode        アルファモードです.
+//! @return     モード名を返却します.
+//-----------------------------------------------------------------------------
+const char* ToString(ALPHA_MODE mode);
+
+//-----------------------------------------------------------------------------
+//! @brief      マテリアル情報をバイナリテーブルに変換します.
+//!
+//! @details    [ヘッダ][マテリアルレコード][テクスチャレコード][テクスチャパスレコード][文字列テーブル]
+//!             の順に並び，マテリアルレコードとテクスチャパスレコードはハッシュの昇順に並びます.
+//!             文字列は重複を除いて終端文字付きで格納するため，
+//!             メモリマップしたままオフセットで参照できます.
+//!
+//! @param[in]      materials   マテリアル情報です.
+//! @param[in]      textures    テクスチャ情報です.
+//! @param[out]     data        変換結果の格納先です.
+//-----------------------------------------------------------------------------
+void BuildMaterialTable(
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures,
+    std::vector<uint8_t>&               data);
+
+//-----------------------------------------------------------------------------
+//! @brief      マテリアル情報をバイナリファイルに出力します.
+//!
+//! @param[in]      path        出力ファイルパスです.
+//! @param[in]      materials   マテリアル情報です.
+//! @param[in]      textures    テクスチャ情報です.
+//! @retval true    出力に成功.
+//! @retval false   出力に失敗.
+//-----------------------------------------------------------------------------
+bool ExportMaterialTable(
+    const char*                         path,
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures);
+
+//-----------------------------------------------------------------------------
+//! @brief      マテリアル情報をYAMLファイルに出力します.
+//!
+//! @details    デバッグ用の出力です. 全体をメモリ上で組み立ててから一括で書き込みます.
+//!
+//! @param[in]      path        出力ファイルパスです.
+//! @param[in]      materials   マテリアル情報です.
+//! @param[in]      textures    テクスチャ情報です.
+//! @retval true    出力に成功.
+//! @retval false   出力に失敗.
+//-----------------------------------------------------------------------------
+bool ExportMaterialYaml(
+    const char*                         path,
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures);
+
+//-----------------------------------------------------------------------------
+//! @brief      テクスチャの依存関係をバイナリファイルに出力します.
+//!
+//! @details    テクスチャごとに参照元のマテリアルとメッシュのハッシュを格納します.
+//!             メッシュ変換と並行してテクスチャ変換をスケジュールするために使います.
+//!
+//! @param[in]      path        出力ファイルパスです.
+//! @param[in]      textures    テクスチャ情報です.
+//! @retval true    出力に成功.
+//! @retval false   出力に失敗.
+//-----------------------------------------------------------------------------
+bool ExportTextureIndex(const char* path, const std::vector<TextureEntry>& textures);
+
+//-----------------------------------------------------------------------------
+//! @brief      マテリアルテーブルを検証します.
+//!
+//! @param[in]      pData       テーブルの先頭アドレスです.
+//! @param[in]      size        テーブルのサイズです.
+//! @return     有効な場合はヘッダを返却します. 無効な場合は nullptr を返却します.
+//-----------------------------------------------------------------------------
+const MaterialTableHeader* GetMaterialTable(const void* pData, size_t size);
+
+//-----------------------------------------------------------------------------
+//! @brief      マテリアルレコードを二分探索します.
+//!
+//! @param[in]      pHeader     マテリアルテーブルです.
+//! @param[in]      hash        マテリアル名ハッシュです.
+//! @return     見つかった場合はレコードを返却します. 見つからない場合は nullptr を返却します.
+//-----------------------------------------------------------------------------
+const MaterialRecord* FindMaterialRecord(const MaterialTableHeader* pHeader, uint32_t hash);
+
+//-----------------------------------------------------------------------------
+//! @brief      テクスチャレコードを取得します.
+//!
+//! @param[in]      pHeader     マテリアルテーブルです.
+//! @param[in]      pRecord     マテリアルレコードです.
+//! @return     先頭のテクスチャレコードを返却します.
+//-----------------------------------------------------------------------------
+const MaterialTextureRecord* GetTextureRecords(const MaterialTableHeader* pHeader, const MaterialRecord* pRecord);
+
+//-----------------------------------------------------------------------------
+//! @brief      文字列テーブルから文字列を取得します.
+//!
+//! @param[in]      pHeader     マテリアルテーブルです.
+//! @param[in]      offset      文字列テーブル内のオフセットです.
+//! @return     終端文字付きの文字列を返却します.
+//-----------------------------------------------------------------------------
+const char* GetTableString(const MaterialTableHeader* pHeader, uint32_t offset);
\ No newline at end of file
@@ -0,0 +1,205 @@
+﻿//-----------------------------------------------------------------------------
+// File : MeshConverterC.h
+// Desc : C Interface.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Macros
+//-----------------------------------------------------------------------------
+#if defined(MC_EXPORTS)
+    #define MC_API  __declspec(dllexport)
+#elif defined(MC_IMPORTS)
+    #define MC_API  __declspec(dllimport)
+#else
+    #define MC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+typedef struct MC_RESULT MC_RESULT;     //!< 変換結果です.
+
+//-----------------------------------------------------------------------------
+//! @brief      進捗コールバックです.
+//!
+//! @param[in]      pUser       MC_CONVERT_DESC::pUser です.
+//! @param[in]      stage       処理段階(MC_STAGE)です.
+//! @param[in]      done        完了数です.
+//! @param[in]      total       総数です.
+//! @return     0 を返却すると変換を中断します.
+//-----------------------------------------------------------------------------
+typedef int (*MC_PROGRESS_CALLBACK)(void* pUser, uint32_t stage, uint32_t done, uint32_t total);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MC_STATUS
+///////////////////////////////////////////////////////////////////////////////
+enum MC_STATUS
+{
+    MC_OK                   = 0,    //!< 成功です.
+    MC_ERROR_INVALID_ARG    = -1,   //!< 引数が不正です.
+    MC_ERROR_FAILED         = -2,   //!< 変換に失敗しました.
+    MC_ERROR_CANCELED       = -3,   //!< 進捗コールバックにより中断されました.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MC_STAGE
+///////////////////////////////////////////////////////////////////////////////
+enum MC_STAGE
+{
+    MC_STAGE_IMPORT,                //!< ファイルの読み込みとポストプロセスです.
+    MC_STAGE_ANIMATION,             //!< スケルトンとアニメーションの変換です.
+    MC_STAGE_MESH,                  //!< メッシュの変換です.
+    MC_STAGE_MATERIAL,              //!< マテリアルの変換です.
+    MC_STAGE_EXPORT,                //!< 出力データの構築です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MC_BLOB
+///////////////////////////////////////////////////////////////////////////////
+enum MC_BLOB
+{
+    MC_BLOB_MATERIAL_TABLE,         //!< マテリアルテーブル(-mb の出力と同じ内容)です.
+    MC_BLOB_SKIN,                   //!< スキニングデータ(-skin の出力と同じ内容)です.
+    MC_BLOB_ANIMATION,              //!< アニメーションデータ(-anim の出力と同じ内容)です.
+    MC_BLOB_SHADOW,                 //!< シャドウメッシュ(-shadow の出力と同じ内容)です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MC_CONVERT_DESC structure
+///////////////////////////////////////////////////////////////////////////////
+typedef struct MC_CONVERT_DESC
+{
+    uint32_t                Profile;            //!< インポートプロファイル(IMPORT_PROFILE)です. ParseAnimation 指定時の既定値は skinned に切り替えます.
+    uint32_t                EnableFlags;        //!< 追加で有効にするポストプロセスフラグです.
+    uint32_t                DisableFlags;       //!< 無効にするポストプロセスフラグです.
+    uint32_t                SkinInfluenceCount; //!< スキニングの1頂点あたりの影響数です(1～8).
+    uint32_t                SkinWeightFormat;   //!< スキニングの重みのフォーマット(SKIN_WEIGHT_FORMAT)です.
+    uint32_t                BonePaletteSize;    //!< ボーンパレットのサイズです. 0 の場合は分割しません.
+    uint32_t                MaxFaceCount;       //!< 1メッシュの最大三角形数です. 0 の場合は無制限.
+    int                     ParseAnimation;     //!< 0 以外の場合はスケルトンとアニメーションを変換します. PreTransformVertices を含む設定とは併用できません.
+    int                     MergeMeshes;        //!< 0 以外の場合はメッシュを統合します.
+    int                     MergeMaterials;     //!< 0 以外の場合はマテリアルを統合します.
+    int                     GenerateShadowMesh; //!< 0 以外の場合は位置座標のみのシャドウメッシュを生成します.
+    MC_PROGRESS_CALLBACK    pProgress;          //!< 進捗コールバックです. NULL の場合は通知しません.
+    void*                   pUser;              //!< 進捗コールバックに渡すユーザーデータです.
+} MC_CONVERT_DESC;
+
+///////////////////////////////////////////////////////////////////////////////
+// MC_MESH_VIEW structure
+///////////////////////////////////////////////////////////////////////////////
+typedef struct MC_MESH_VIEW
+{
+    uint32_t        MeshHash;           //!< メッシュハッシュです.
+    uint32_t        MaterialHash;       //!< マテリアルハッシュです.
+    uint32_t        VertexCount;        //!< 頂点数です.
+    uint32_t        IndexCount;         //!< 頂点番号数です.
+    uint32_t        PrimitiveCount;     //!< プリミティブ数です.
+    uint32_t        MeshletCount;       //!< メッシュレット数です.
+    uint32_t        PrimitiveStride;    //!< プリミティブ1つあたりのバイト数です.
+    uint32_t        MeshletStride;      //!< メッシュレット1つあたりのバイト数です.
+    uint32_t        CullingInfoStride;  //!< カリング情報1つあたりのバイト数です.
+    const float*    pPositions;         //!< 位置座標(XYZ)です.
+    const uint32_t* pTangentSpaces;     //!< 圧縮済みの接線空間です. 無い場合は NULL.
+    const uint32_t* pColors;            //!< 頂点カラーです. 無い場合は NULL.
+    const uint32_t* pTexCoords[4];      //!< テクスチャ座標です. 無い場合は NULL.
+    const uint16_t* pBoneIndices;       //!< ボーン番号(4個/頂点)です. 無い場合は NULL.
+    const float*    pBoneWeights;       //!< ボーンの重み(4個/頂点)です. 無い場合は NULL.
+    const uint32_t* pIndices;           //!< 頂点番号です.
+    const void*     pPrimitives;        //!< プリミティブです.
+    const void*     pMeshlets;          //!< メッシュレットです.
+    const void*     pCullingInfos;      //!< メッシュレットのカリング情報です.
+} MC_MESH_VIEW;
+
+
+//-----------------------------------------------------------------------------
+//! @brief      変換設定を既定値で初期化します.
+//!
+//! @param[out]     pDesc       初期化する変換設定です.
+//-----------------------------------------------------------------------------
+MC_API void mcGetDefaultConvertDesc(MC_CONVERT_DESC* pDesc);
+
+//-----------------------------------------------------------------------------
+//! @brief      メモリ上のファイルイメージを変換します.
+//!
+//! @details    ファイルの入出力は行いません. 呼び出しごとに独立した状態を使うため，
+//!             複数スレッドから同時に呼び出せます. 結果は mcReleaseResult() で解放してください.
+//!
+//! @param[in]      pData       ファイルイメージです.
+//! @param[in]      size        ファイルイメージのサイズです.
+//! @param[in]      name        仮のファイル名です. 拡張子をフォーマットの判定に使います.
+//! @param[in]      pDesc       変換設定です. NULL の場合は既定値を使います.
+//! @param[out]     ppResult    変換結果の格納先です.
+//! @return     MC_STATUS を返却します.
+//-----------------------------------------------------------------------------
+MC_API int mcConvertMemory(
+    const void*             pData,
+    size_t                  size,
+    const char*             name,
+    const MC_CONVERT_DESC*  pDesc,
+    MC_RESULT**             ppResult);
+
+//-----------------------------------------------------------------------------
+//! @brief      変換結果を解放します.
+//!
+//! @param[in]      pResult     解放する変換結果です. NULL の場合は何もしません.
+//-----------------------------------------------------------------------------
+MC_API void mcReleaseResult(MC_RESULT* pResult);
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュ数を取得します.
+//!
+//! @param[in]      pResult     変換結果です.
+//! @return     メッシュ数を返却します.
+//-----------------------------------------------------------------------------
+MC_API uint32_t mcGetMeshCount(const MC_RESULT* pResult);
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュデータを参照します.
+//!
+//! @details    ポインタは変換結果を解放するまで有効です.
+//!
+//! @param[in]      pResult     変換結果です.
+//! @param[in]      index       メッシュ番号です.
+//! @param[out]     pView       メッシュデータの格納先です.
+//! @return     MC_STATUS を返却します.
+//-----------------------------------------------------------------------------
+MC_API int mcGetMesh(const MC_RESULT* pResult, uint32_t index, MC_MESH_VIEW* pView);
+
+//-----------------------------------------------------------------------------
+//! @brief      バイナリデータを参照します.
+//!
+//! @details    ポインタは変換結果を解放するまで有効です.
+//!
+//! @param[in]      pResult     変換結果です.
+//! @param[in]      type        データの種類(MC_BLOB)です.
+//! @param[out]     ppData      データの先頭アドレスの格納先です.
+//! @param[out]     pSize       データサイズの格納先です.
+//! @return     MC_STATUS を返却します.
+//-----------------------------------------------------------------------------
+MC_API int mcGetBlob(const MC_RESULT* pResult, uint32_t type, const void** ppData, size_t* pSize);
+
+//-----------------------------------------------------------------------------
+//! @brief      モデルをファイルに保存します.
+//!
+//! @param[in]      pResult     変換結果です.
+//! @param[in]      path        出力ファイルパスです.
+//! @return     MC_STATUS を返却します.
+//-----------------------------------------------------------------------------
+MC_API int mcSaveModel(const MC_RESULT* pResult, const char* path);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
\ No newline at end of file
@@ -9,6 +9,11 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <asdxResModel.h>
+#include <SkinPacker.h>
+#include <AnimationConverter.h>
+#include <unordered_map>
+#include <functional>
+#include <memory>
 
 //-----------------------------------------------------------------------------
 // Forward Declarations.
@@ -16,6 +21,7 @@
 struct aiScene;
 struct aiMesh;
 struct aiMaterial;
+class ImporterPool;
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,6 +41,102 @@ enum TEXTURE_USAGE
     TEXTURE_USAGE_DISPLACEMENT,
     TEXTURE_USAGE_LIGHTMAP,
     TEXTURE_USAGE_REFLECTION,
+    TEXTURE_USAGE_UNKNOWN,          // glTF の metallicRoughness テクスチャはここに格納されます.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ALPHA_MODE
+///////////////////////////////////////////////////////////////////////////////
+enum ALPHA_MODE
+{
+    ALPHA_MODE_OPAQUE,      //!< 不透明です.
+    ALPHA_MODE_MASK,        //!< アルファテストです.
+    ALPHA_MODE_BLEND,       //!< 半透明です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MATERIAL_FEATURE
+///////////////////////////////////////////////////////////////////////////////
+enum MATERIAL_FEATURE
+{
+    MATERIAL_FEATURE_BASE_COLOR_MAP         = 0x1 << 0,     //!< ベースカラーテクスチャを持ちます.
+    MATERIAL_FEATURE_NORMAL_MAP             = 0x1 << 1,     //!< 法線テクスチャを持ちます.
+    MATERIAL_FEATURE_METALLIC_ROUGHNESS_MAP = 0x1 << 2,     //!< メタリック・ラフネステクスチャを持ちます.
+    MATERIAL_FEATURE_SPECULAR_MAP           = 0x1 << 3,     //!< スペキュラーテクスチャを持ちます.
+    MATERIAL_FEATURE_OCCLUSION_MAP          = 0x1 << 4,     //!< 遮蔽(ライトマップ)テクスチャを持ちます.
+    MATERIAL_FEATURE_EMISSIVE               = 0x1 << 5,     //!< 自己発光します.
+    MATERIAL_FEATURE_EMISSIVE_MAP           = 0x1 << 6,     //!< 自己発光テクスチャを持ちます.
+    MATERIAL_FEATURE_OPACITY_MAP            = 0x1 << 7,     //!< 不透明度テクスチャを持ちます.
+    MATERIAL_FEATURE_ALPHA_TEST             = 0x1 << 8,     //!< アルファテストを行います.
+    MATERIAL_FEATURE_ALPHA_BLEND            = 0x1 << 9,     //!< 半透明描画を行います.
+    MATERIAL_FEATURE_TWO_SIDED              = 0x1 << 10,    //!< 両面描画を行います.
+    MATERIAL_FEATURE_UV_TRANSFORM           = 0x1 << 11,    //!< UV変換を行います.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// IMPORT_PROFILE
+///////////////////////////////////////////////////////////////////////////////
+enum IMPORT_PROFILE
+{
+    IMPORT_PROFILE_DEFAULT,     //!< 従来と同じ設定です.
+    IMPORT_PROFILE_FAST,        //!< 必要最低限の処理のみ行う設定です.
+    IMPORT_PROFILE_QUALITY,     //!< 不正データの除去も行う高品質設定です.
+    IMPORT_PROFILE_SKINNED,     //!< スキンメッシュ向けの設定です.
+    IMPORT_PROFILE_SCAN,        //!< スキャンデータ向けの設定です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PROGRESS_STAGE
+///////////////////////////////////////////////////////////////////////////////
+enum PROGRESS_STAGE
+{
+    PROGRESS_STAGE_IMPORT,      //!< ファイルの読み込みとポストプロセスです.
+    PROGRESS_STAGE_ANIMATION,   //!< スケルトンとアニメーションの変換です.
+    PROGRESS_STAGE_MESH,        //!< メッシュの変換です.
+    PROGRESS_STAGE_MATERIAL,    //!< マテリアルの変換です.
+    PROGRESS_STAGE_EXPORT,      //!< 出力データの構築です.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      進捗コールバックです.
+//!
+//! @details    done / total が段階ごとの進捗を表します. false を返却すると変換を中断します.
+//!             変換を実行しているスレッドから呼び出されます.
+//-----------------------------------------------------------------------------
+using ProgressCallback = std::function<bool(PROGRESS_STAGE stage, uint32_t done, uint32_t total)>;
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュ出力コールバックです.
+//!
+//! @details    メッシュを1つ構築するたびに呼び出されます. 設定した場合メッシュは
+//!             asdx::ResModel に格納されず，呼び出し後に破棄されます.
+//!             false を返却するとロードを中断します.
+//-----------------------------------------------------------------------------
+using MeshCallback = std::function<bool(asdx::ResMesh& mesh)>;
+
+///////////////////////////////////////////////////////////////////////////////
+// MeshLoaderOption structure
+///////////////////////////////////////////////////////////////////////////////
+struct MeshLoaderOption
+{
+    IMPORT_PROFILE      Profile             = IMPORT_PROFILE_DEFAULT;       //!< インポートプロファイルです.
+    uint32_t            EnableFlags         = 0;                            //!< 追加で有効にするポストプロセスフラグです.
+    uint32_t            DisableFlags        = 0;                            //!< 無効にするポストプロセスフラグです.
+    bool                MeasureTime         = false;                        //!< 処理時間を出力するならtrue.
+    size_t              WorkingSetBudget    = 0;                            //!< 1メッシュの構築に使う作業メモリの目安(バイト)です. 超える場合は分割します. 入力シーンと出力は含みません. 0 の場合は無制限.
+    uint32_t            SkinInfluenceCount  = 4;                            //!< スキニングの1頂点あたりの影響数です(1～8).
+    SKIN_WEIGHT_FORMAT  SkinWeightFormat    = SKIN_WEIGHT_FORMAT_FLOAT;     //!< スキニングの重みのフォーマットです.
+    uint32_t            BonePaletteSize     = 0;                            //!< ボーンパレットのサイズです(最大256). 0 の場合は分割しません. パレット内の番号になるのはスキニングデータのみです.
+    bool                ParseAnimation      = false;                        //!< スケルトンとアニメーションを変換するならtrue.
+    AnimationCompressOption AnimationCompress;                              //!< アニメーションの圧縮オプションです.
+    std::string         EmbeddedTextureDir;                                 //!< 埋め込みテクスチャの出力先です. 空の場合はメモリ上にのみ保持します.
+    bool                MergeMeshes         = false;                        //!< マテリアルと頂点属性が同じメッシュを統合するならtrue.
+    uint32_t            MaxFaceCount        = 0;                            //!< 1メッシュの最大三角形数です. 超える場合は空間分割します. 0 の場合は無制限.
+    bool                MergeMaterials      = false;                        //!< 内容が同じマテリアルを統合するならtrue. マテリアルハッシュは内容ハッシュになります.
+    ProgressCallback    Progress;                                           //!< 進捗コールバックです. 空の場合は通知しません.
+    bool                GenerateShadowMesh  = false;                        //!< 位置座標のみのシャドウメッシュを生成するならtrue.
+    MeshCallback        MeshOutput;                                         //!< メッシュ出力コールバックです. 空の場合は asdx::ResModel に格納します. シャドウメッシュとスキニングデータは保持されます.
+    ImporterPool*       pImporterPool       = nullptr;                      //!< インポーターの取得元です. nullptr の場合はロードのたびに生成します.
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -43,7 +145,19 @@ enum TEXTURE_USAGE
 struct TextureInfo
 {
     TEXTURE_USAGE   Usage;      //!< 使用用途です.
-    std::string     Path;       //!< ファイルパスです.
+    uint32_t        PathId;     //!< ファイルパスハッシュです(TextureEntry::Id).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureEntry structure
+///////////////////////////////////////////////////////////////////////////////
+struct TextureEntry
+{
+    uint32_t                Id;         //!< ファイルパスハッシュです.
+    std::string             Path;       //!< ファイルパスです.
+    std::vector<uint32_t>   Materials;  //!< 参照しているマテリアルのハッシュです.
+    std::vector<uint32_t>   Meshes;     //!< 参照しているメッシュのハッシュです.
+    std::shared_ptr<const std::vector<uint8_t>> Embedded;   //!< 埋め込みテクスチャのファイルイメージです. 外部ファイルの場合は nullptr.
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -51,9 +165,50 @@ struct TextureInfo
 ///////////////////////////////////////////////////////////////////////////////
 struct Material
 {
-    std::string                 Name;           //!< マテリアル名です.
-    uint32_t                    Hash;           //!< マテリアル名ハッシュです.
-    std::vector<TextureInfo>    Textures;       //!< テクスチャ情報です.
+    std::string                 Name;                                       //!< マテリアル名です.
+    uint32_t                    Hash        = 0;                            //!< マテリアル名ハッシュです.
+    std::vector<TextureInfo>    Textures;                                   //!< テクスチャ情報です.
+    asdx::Vector4               BaseColor   = asdx::Vector4(1.0f, 1.0f, 1.0f, 1.0f);  //!< ベースカラー(RGBA)です.
+    asdx::Vector3               Emissive    = asdx::Vector3(0.0f, 0.0f, 0.0f);        //!< 自己発光色です.
+    float                       Metallic    = 0.0f;                         //!< 金属度です.
+    float                       Roughness   = 1.0f;                         //!< 粗さです.
+    ALPHA_MODE                  AlphaMode   = ALPHA_MODE_OPAQUE;            //!< アルファモードです.
+    float                       AlphaCutoff = 0.5f;                         //!< アルファテストの閾値です.
+    bool                        TwoSided    = false;                        //!< 両面描画するならtrue.
+    asdx::Vector2               UVScale     = asdx::Vector2(1.0f, 1.0f);    //!< UVの拡大率です.
+    asdx::Vector2               UVOffset    = asdx::Vector2(0.0f, 0.0f);    //!< UVの平行移動量です.
+    float                       UVRotation  = 0.0f;                         //!< UVの回転角(ラジアン)です.
+    uint32_t                    Features    = 0;                            //!< MATERIAL_FEATURE の組み合わせです.
+    uint32_t                    ContentHash = 0;                            //!< パラメータとテクスチャから求めた内容ハッシュです.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SkinStream structure
+///////////////////////////////////////////////////////////////////////////////
+struct SkinStream
+{
+    uint32_t                MeshHash        = 0;                            //!< 対応するメッシュのハッシュです.
+    uint32_t                InfluenceCount  = 0;                            //!< 1頂点あたりの影響数です.
+    SKIN_WEIGHT_FORMAT      WeightFormat    = SKIN_WEIGHT_FORMAT_FLOAT;     //!< 重みのフォーマットです.
+    uint32_t                IndexSize       = sizeof(uint16_t);             //!< ボーン番号1つあたりのバイト数です.
+    uint32_t                Stride          = 0;                            //!< 1頂点あたりのバイト数です.
+    std::vector<uint16_t>   BonePalette;                                    //!< ボーンパレットです. 空でない場合ボーン番号はパレット内の番号です.
+    std::vector<uint8_t>    Data;                                           //!< 頂点データです(ResMeshの頂点順).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ShadowMesh structure
+///////////////////////////////////////////////////////////////////////////////
+struct ShadowMesh
+{
+    uint32_t                            MeshHash = 0;   //!< 対応するメッシュのハッシュです.
+    std::vector<asdx::Vector3>          Positions;      //!< 位置座標が同じ頂点を統合した頂点座標です.
+    std::vector<uint32_t>               TriangleIndices;//!< 頂点キャッシュ最適化済みの三角形リストです.
+    std::vector<uint32_t>               Indices;        //!< メッシュレットの頂点番号です.
+    std::vector<asdx::ResPrimitive>     Primitives;     //!< メッシュレットのプリミティブです.
+    std::vector<asdx::ResMeshlet>       Meshlets;       //!< メッシュレットです.
+    std::vector<asdx::ResCullingInfo>   CullingInfos;   //!< カリング情報です.
 };
 
 
@@ -92,10 +247,40 @@ public:
     //!
     //! @param[in]      filename        ファイル名です.
     //! @param[out]     model           モデルの格納先です.
+    //! @param[in]      option          ロードオプションです.
+    //! @retval true    ロードに成功.
+    //! @retval false   ロードに失敗.
+    //-------------------------------------------------------------------------
+    bool Load(
+        const char*             filename,
+        asdx::ResModel&         model,
+        const MeshLoaderOption& option = MeshLoaderOption());
+
+    //-------------------------------------------------------------------------
+    //! @brief      メモリ上のファイルイメージからモデルをロードします.
+    //!
+    //! @param[in]      pData           ファイルイメージです.
+    //! @param[in]      size            ファイルイメージのサイズです.
+    //! @param[in]      name            仮のファイル名です. 拡張子をフォーマットの判定に使います.
+    //! @param[out]     model           モデルの格納先です.
+    //! @param[in]      option          ロードオプションです.
     //! @retval true    ロードに成功.
     //! @retval false   ロードに失敗.
     //-------------------------------------------------------------------------
-    bool Load(const char* filename, asdx::ResModel& mode);
+    bool Load(
+        const void*             pData,
+        size_t                  size,
+        const char*             name,
+        asdx::ResModel&         model,
+        const MeshLoaderOption& option = MeshLoaderOption());
+
+    //-------------------------------------------------------------------------
+    //! @brief      進捗コールバックにより中断されたかどうかチェックします.
+    //!
+    //! @retval true    中断された.
+    //! @retval false   中断されていない.
+    //-------------------------------------------------------------------------
+    bool IsCanceled() const;
 
     //-------------------------------------------------------------------------
     //! @brief      マテリアルを取得します.
@@ -104,24 +289,190 @@ public:
     //-------------------------------------------------------------------------
     const std::vector<Material>& GetMaterials() const;
 
+    //-------------------------------------------------------------------------
+    //! @brief      スキニングデータを取得します.
+    //!
+    //! @return     影響数と重みのフォーマットを指定してパッキングしたスキニングデータを返却します.
+    //-------------------------------------------------------------------------
+    const std::vector<SkinStream>& GetSkins() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      シャドウメッシュを取得します.
+    //!
+    //! @return     深度・シャドウパス用に位置座標のみで溶接したメッシュを返却します.
+    //!             MeshLoaderOption::GenerateShadowMesh が false の場合は空です.
+    //-------------------------------------------------------------------------
+    const std::vector<ShadowMesh>& GetShadowMeshes() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      テクスチャを取得します.
+    //!
+    //! @return     モデル全体で参照されるテクスチャと，その参照元を返却します.
+    //-------------------------------------------------------------------------
+    const std::vector<TextureEntry>& GetTextures() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      テクスチャを検索します.
+    //!
+    //! @param[in]      id          ファイルパスハッシュです.
+    //! @return     見つかった場合はテクスチャを返却します. 見つからない場合は nullptr を返却します.
+    //-------------------------------------------------------------------------
+    const TextureEntry* FindTexture(uint32_t id) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      スケルトンを取得します.
+    //!
+    //! @return     スケルトンを返却します. スキンのボーン番号は関節番号と一致します.
+    //-------------------------------------------------------------------------
+    const Skeleton& GetSkeleton() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      アニメーションクリップを取得します.
+    //!
+    //! @return     圧縮済みのアニメーションクリップを返却します.
+    //-------------------------------------------------------------------------
+    const std::vector<AnimationClip>& GetAnimations() const;
+
 private:
+    ///////////////////////////////////////////////////////////////////////////
+    // SkinSource structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct SkinSource
+    {
+        PackedSkin                          Packed;         //!< 頂点優先に並べたスキニング情報です.
+        std::vector<asdx::ResBoneIndex>     BoneIndices;    //!< ResMesh用のボーン番号です.
+        std::vector<asdx::Vector4>          BoneWeights;    //!< ResMesh用のボーンの重みです.
+        SkinStream                          Stream;         //!< エンコード済みのスキニングデータです.
+        size_t                              BoneCount = 0;  //!< ボーン番号の取り得る範囲です.
+    };
+
     //=========================================================================
     // private variables.
     //=========================================================================
     const aiScene*          m_pScene    = nullptr;  //!< シーンデータ.
     std::vector<Material>   m_Materials;            //!< マテリアルデータです.
+    MeshLoaderOption        m_Option;               //!< ロードオプションです.
+    std::vector<SkinStream> m_Skins;                //!< スキニングデータです.
+    std::vector<ShadowMesh> m_ShadowMeshes;         //!< シャドウメッシュです.
+    std::vector<TextureEntry> m_Textures;           //!< テクスチャです.
+    std::unordered_map<uint32_t, uint32_t> m_TextureIndices;    //!< ファイルパスハッシュからテクスチャ番号への対応表です.
+    std::unordered_map<uint32_t, uint32_t> m_EmbeddedIds;       //!< 埋め込みテクスチャ番号からファイルパスハッシュへの対応表です.
+    std::string             m_ModelName;            //!< 拡張子を除いた入力ファイル名です.
+    Skeleton                m_Skeleton;             //!< スケルトンです.
+    std::vector<AnimationClip> m_Animations;        //!< アニメーションクリップです.
+    bool                    m_Canceled  = false;    //!< 中断されたらtrue.
+    std::vector<uint32_t>   m_MaterialRemap;        //!< シーン内のマテリアル番号から統合後のマテリアルハッシュへの対応表です.
+    std::vector<std::pair<uint32_t, uint32_t>> m_MeshMaterials; //!< 出力したメッシュとマテリアルのハッシュです.
 
     //=========================================================================
     // private methods.
     //=========================================================================
 
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルまたはメモリからモデルをロードします.
+    //!
+    //! @param[in]      name            ファイル名です.
+    //! @param[in]      pData           ファイルイメージです. nullptrの場合は name から読み込みます.
+    //! @param[in]      size            ファイルイメージのサイズです.
+    //! @param[out]     model           モデルの格納先です.
+    //! @param[in]      option          ロードオプションです.
+    //! @retval true    ロードに成功.
+    //! @retval false   ロードに失敗.
+    //-------------------------------------------------------------------------
+    bool LoadCore(
+        const char*             name,
+        const void*             pData,
+        size_t                  size,
+        asdx::ResModel&         model,
+        const MeshLoaderOption& option);
+
+    //-------------------------------------------------------------------------
+    //! @brief      進捗を通知します.
+    //!
+    //! @param[in]      stage       処理段階です.
+    //! @param[in]      done        完了数です.
+    //! @param[in]      total       総数です.
+    //! @retval true    処理を継続.
+    //! @retval false   中断要求あり.
+    //-------------------------------------------------------------------------
+    bool Report(PROGRESS_STAGE stage, uint32_t done, uint32_t total);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マテリアル単位でメッシュを統合して解析します.
+    //!
+    //! @param[out]     model       モデルの格納先です.
+    //! @retval true    解析に成功.
+    //! @retval false   解析に失敗.
+    //-------------------------------------------------------------------------
+    bool ParseMergedMeshes(asdx::ResModel& model);
+
     //-------------------------------------------------------------------------
     //! @brief      メッシュを解析します.
     //!
     //! @param[out]     model       モデルの格納先です.
     //! @param[in]      pSrcMesh    入力メッシュです.
+    //! @retval true    解析に成功.
+    //! @retval false   解析に失敗.
+    //-------------------------------------------------------------------------
+    bool ParseMesh(asdx::ResModel& model, const aiMesh* pSrcMesh);
+
+    //-------------------------------------------------------------------------
+    //! @brief      出力するマテリアルハッシュを取得します.
+    //!
+    //! @param[in]      matId       シーン内のマテリアル番号です.
+    //! @return     マテリアルを統合した場合は内容ハッシュ，それ以外は名前のハッシュを返却します.
+    //-------------------------------------------------------------------------
+    uint32_t GetMaterialHash(uint32_t matId) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      スケルトンとアニメーションを解析します.
+    //!
+    //! @retval true    解析に成功.
+    //! @retval false   スケルトンが見つからない.
+    //-------------------------------------------------------------------------
+    bool ParseAnimation();
+
+    //-------------------------------------------------------------------------
+    //! @brief      スキニング情報を解析します.
+    //!
+    //! @param[in]      pSrcMesh        入力メッシュです.
+    //! @param[out]     skin            スキニング情報の格納先です.
+    //! @retval true    解析に成功.
+    //! @retval false   スケルトンに含まれないボーンがある.
+    //-------------------------------------------------------------------------
+    bool ParseSkin(const aiMesh* pSrcMesh, SkinSource& skin);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッシュを構築します.
+    //!
+    //! @param[out]     model           モデルの格納先です.
+    //! @param[in]      pSrcMesh        入力メッシュです.
+    //! @param[in]      pFaces          処理する三角形番号です. nullptrの場合は全三角形を処理します.
+    //! @param[in]      faceCount       処理する三角形数です.
+    //! @param[in]      meshHash        メッシュハッシュです.
+    //! @param[in]      matHash         マテリアルハッシュです.
+    //! @param[in]      skin            入力メッシュ全体のスキニング情報です.
+    //! @param[in]      pPalette        ボーンパレットです. nullptrの場合はボーン番号を変換しません.
+    //! @param[in]      pTangentSpaces  入力メッシュ全体で生成した接線空間です. nullptrの場合は構築時に生成します.
+    //-------------------------------------------------------------------------
+    void BuildMesh(
+        asdx::ResModel&                         model,
+        const aiMesh*                           pSrcMesh,
+        const uint32_t*                         pFaces,
+        size_t                                  faceCount,
+        uint32_t                                meshHash,
+        uint32_t                                matHash,
+        const SkinSource&                       skin,
+        const std::vector<uint16_t>*            pPalette,
+        const std::vector<uint32_t>*            pTangentSpaces);
+
+    //-------------------------------------------------------------------------
+    //! @brief      位置座標のみで溶接したシャドウメッシュを構築します.
+    //!
+    //! @param[in]      mesh            構築済みのメッシュです.
+    //! @param[in]      triangles       メッシュの三角形リストです.
     //-------------------------------------------------------------------------
-    void ParseMesh(asdx::ResModel& model, const aiMesh* pSrcMesh);
+    void BuildShadowMesh(const asdx::ResMesh& mesh, const std::vector<uint32_t>& triangles);
 
     //-------------------------------------------------------------------------
     //! @brief      マテリアルを解析します.
@@ -129,4 +480,94 @@ private:
     //! @param[in]      pSrcMaterial    入力マテリアルです.
     //-------------------------------------------------------------------------
     void ParseMaterial(const aiMaterial* pSrcMaterial);
-};
\ No newline at end of file
+
+    //-------------------------------------------------------------------------
+    //! @brief      マテリアルパラメータを解析します.
+    //!
+    //! @param[in]      pSrcMaterial    入力マテリアルです.
+    //! @param[in,out]  dstMaterial     テクスチャ情報を設定済みの出力マテリアルです.
+    //-------------------------------------------------------------------------
+    void ParseMaterialParam(const aiMaterial* pSrcMaterial, Material& dstMaterial);
+
+    //-------------------------------------------------------------------------
+    //! @brief      内容が同じマテリアルを統合します.
+    //!
+    //! @details    メッシュより先に呼び出し，メッシュ構築時にマテリアルハッシュを付け替えます.
+    //-------------------------------------------------------------------------
+    void MergeMaterials();
+
+    //-------------------------------------------------------------------------
+    //! @brief      テクスチャパスを登録します.
+    //!
+    //! @param[in]      path        ファイルパスです. "*N" の場合は埋め込みテクスチャとして扱います.
+    //! @param[in]      pEmbedded   埋め込みテクスチャのファイルイメージです.
+    //! @return     ファイルパスハッシュを返却します.
+    //-------------------------------------------------------------------------
+    uint32_t AddTexture(
+        const char*                                         path,
+        const std::shared_ptr<const std::vector<uint8_t>>&  pEmbedded = nullptr);
+
+    //-------------------------------------------------------------------------
+    //! @brief      埋め込みテクスチャを登録します.
+    //!
+    //! @param[in]      index       aiScene::mTextures の番号です.
+    //! @return     ファイルパスハッシュを返却します.
+    //-------------------------------------------------------------------------
+    uint32_t AddEmbeddedTexture(uint32_t index);
+
+    //-------------------------------------------------------------------------
+    //! @brief      テクスチャの参照元を構築します.
+    //-------------------------------------------------------------------------
+    void BuildTextureDependencies();
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      インポートプロファイルに対応するポストプロセスフラグを取得します.
+//!
+//! @param[in]      profile     インポートプロファイルです.
+//! @return     aiPostProcessStepsの組み合わせを返却します.
+//-----------------------------------------------------------------------------
+uint32_t GetImportFlags(IMPORT_PROFILE profile);
+
+//-----------------------------------------------------------------------------
+//! @brief      文字列からインポートプロファイルを検索します.
+//!
+//! @param[in]      name        プロファイル名です(fast, quality, skinned, scan).
+//! @param[out]     profile     プロファイルの格納先です.
+//! @retval true    検索に成功.
+//! @retval false   検索に失敗.
+//-----------------------------------------------------------------------------
+bool FindImportProfile(const char* name, IMPORT_PROFILE& profile);
+
+//-----------------------------------------------------------------------------
+//! @brief      1チャンクあたりの最大三角形数を求めます.
+//!
+//! @details    頂点インデックス数が32bitに収まるように UINT32_MAX / 3 でも制限します.
+//!
+//! @param[in]      workingSetLimit     作業メモリの目安から見積もった三角形数です.
+//! @param[in]      maxFaceCount        指定された最大三角形数です. 0 の場合は無制限.
+//! @return     1以上の最大三角形数を返却します.
+//-----------------------------------------------------------------------------
+size_t GetFaceLimit(size_t workingSetLimit, uint32_t maxFaceCount);
+
+//-----------------------------------------------------------------------------
+//! @brief      セル毎の三角形数の累積からチャンクの区切りを求めます.
+//!
+//! @param[in]      cellOffsets     セル毎の三角形の開始位置です(末尾は総数).
+//! @param[in]      faceLimit       1チャンクあたりの最大三角形数です.
+//! @param[out]     offsets         チャンクの開始位置の格納先です(末尾は総数).
+//-----------------------------------------------------------------------------
+void BuildChunkOffsets(
+    const std::vector<size_t>&  cellOffsets,
+    size_t                      faceLimit,
+    std::vector<size_t>&        offsets);
+
+//-----------------------------------------------------------------------------
+//! @brief      文字列からポストプロセスフラグを検索します.
+//!
+//! @param[in]      name        フラグ名です(aiProcess_の接頭辞は省略可).
+//! @param[out]     flag        フラグの格納先です.
+//! @retval true    検索に成功.
+//! @retval false   検索に失敗.
+//-----------------------------------------------------------------------------
+bool FindPostProcessFlag(const char* name, uint32_t& flag);
\ No newline at end of file
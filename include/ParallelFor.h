@@ -0,0 +1,60 @@
+﻿//-----------------------------------------------------------------------------
+// File : ParallelFor.h
+// Desc : Parallel For Utility.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+
+//-----------------------------------------------------------------------------
+//! @brief      範囲を分割して並列に処理します.
+//!
+//! @param[in]      count       要素数です.
+//! @param[in]      grain       1スレッドが最低限処理する要素数です.
+//! @param[in]      func        処理関数です. func(begin, end) の形式で呼び出されます.
+//-----------------------------------------------------------------------------
+template<typename Func>
+inline void ParallelFor(size_t count, size_t grain, Func func)
+{
+    if (count == 0)
+    { return; }
+
+    grain = std::max<size_t>(grain, 1);
+
+    auto threadCount = size_t(std::thread::hardware_concurrency());
+    threadCount = std::max<size_t>(threadCount, 1);
+    threadCount = std::min<size_t>(threadCount, (count + grain - 1) / grain);
+
+    // 分割するほどの量が無い場合はそのまま実行.
+    if (threadCount <= 1)
+    {
+        func(size_t(0), count);
+        return;
+    }
+
+    auto chunk = (count + threadCount - 1) / threadCount;
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+
+    for(auto i=1u; i<threadCount; ++i)
+    {
+        auto begin = std::min(count, i * chunk);
+        auto end   = std::min(count, begin + chunk);
+        threads.emplace_back([=]() { func(begin, end); });
+    }
+
+    // 先頭はこのスレッドで処理する.
+    func(size_t(0), std::min(count, chunk));
+
+    for(auto& thread : threads)
+    { thread.join(); }
+}
\ No newline at end of file
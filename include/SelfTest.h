@@ -0,0 +1,18 @@
+﻿//-----------------------------------------------------------------------------
+// File : SelfTest.h
+// Desc : Self Test.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+
+//-----------------------------------------------------------------------------
+//! @brief      自己テストを実行します.
+//!
+//! @details    合成したメッシュをメモリから変換し，分割やメッシュレットの結果を検証します.
+//!             巨大な入力を用意しなくても確認できるように，上限値を小さく設定して実行します.
+//!             三角形数とオフセットの計算は，メモリを確保せずに32bitを超える個数で検証します.
+//!
+//! @return     全て成功した場合は 0 を返却します.
+//-----------------------------------------------------------------------------
+int RunSelfTest();
\ No newline at end of file
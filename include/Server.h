@@ -0,0 +1,38 @@
+﻿//-----------------------------------------------------------------------------
+// File : Server.h
+// Desc : Conversion Server.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+
+
+//-----------------------------------------------------------------------------
+//! @brief      変換サーバーを実行します.
+//!
+//! @details    ローカルソケットで変換リクエストを待ち受け，スレッドプールで並列に変換します.
+//!             プロセスを常駐させることで起動やDLLロードのコストを変換ごとに払わずに済みます.
+//!             "-shutdown" のリクエストを受け取ると処理中の変換を終えてから戻ります.
+//!
+//! @param[in]      socketPath      ソケットファイルのパスです.
+//! @param[in]      threadCount     同時に変換するリクエスト数です. 0 の場合はハードウェアスレッド数.
+//! @return     終了コードを返却します.
+//-----------------------------------------------------------------------------
+int RunServer(const char* socketPath, uint32_t threadCount);
+
+//-----------------------------------------------------------------------------
+//! @brief      変換サーバーにリクエストを送信します.
+//!
+//! @details    コマンドライン引数はそのまま転送するので，通常の実行と同じ引数で使えます.
+//!             相対パスはクライアントの作業ディレクトリを基準に解決されます.
+//!
+//! @param[in]      socketPath      ソケットファイルのパスです.
+//! @param[in]      argc            転送する引数の数です.
+//! @param[in]      argv            転送する引数です.
+//! @return     終了コードを返却します.
+//-----------------------------------------------------------------------------
+int RunClient(const char* socketPath, int argc, const char* const* argv);
\ No newline at end of file
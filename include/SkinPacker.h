@@ -0,0 +1,97 @@
+﻿//-----------------------------------------------------------------------------
+// File : SkinPacker.h
+// Desc : Skin Weight Packer.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+struct aiMesh;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SKIN_WEIGHT_FORMAT
+///////////////////////////////////////////////////////////////////////////////
+enum SKIN_WEIGHT_FORMAT
+{
+    SKIN_WEIGHT_FORMAT_FLOAT,       //!< 32bit浮動小数です.
+    SKIN_WEIGHT_FORMAT_UNORM16,     //!< 16bit正規化整数です.
+    SKIN_WEIGHT_FORMAT_UNORM8,      //!< 8bit正規化整数です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PackedSkin structure
+///////////////////////////////////////////////////////////////////////////////
+struct PackedSkin
+{
+    uint32_t                InfluenceCount       = 0;       //!< 1頂点あたりの影響数です.
+    std::vector<uint16_t>   BoneIndices;                    //!< ボーン番号です(頂点数 x 影響数).
+    std::vector<float>      BoneWeights;                    //!< 正規化済みの重みです(頂点数 x 影響数).
+    size_t                  TruncatedVertexCount = 0;       //!< 影響数を超えたため切り捨てが発生した頂点数です.
+    float                   MaxDroppedWeight     = 0.0f;    //!< 切り捨てた重みの割合の最大値です.
+    double                  SumDroppedWeight     = 0.0;     //!< 切り捨てた重みの割合の合計です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      スキニング情報を頂点優先に並べ替えてパッキングします.
+//!
+//! @details    ボーン優先で格納されている aiBone の重みを頂点番号で計数ソートし，
+//!             頂点ごとに重みの大きい順に上位 influenceCount 個を選んで正規化します.
+//!             選択と書き込みは頂点範囲ごとに並列に処理します.
+//!
+//! @param[in]      pSrcMesh        入力メッシュです.
+//! @param[in]      influenceCount  1頂点あたりの影響数です.
+//! @param[out]     result          パッキング結果の格納先です.
+//! @param[in]      pBoneMap        メッシュのボーン番号から出力するボーン番号への変換表です. nullptrの場合は変換しません.
+//-----------------------------------------------------------------------------
+void PackSkinWeights(
+    const aiMesh*   pSrcMesh,
+    uint32_t        influenceCount,
+    PackedSkin&     result,
+    const uint16_t* pBoneMap = nullptr);
+
+//-----------------------------------------------------------------------------
+//! @brief      重み1つあたりのバイト数を取得します.
+//!
+//! @param[in]      format          重みのフォーマットです.
+//! @return     バイト数を返却します.
+//-----------------------------------------------------------------------------
+uint32_t GetSkinWeightSize(SKIN_WEIGHT_FORMAT format);
+
+//-----------------------------------------------------------------------------
+//! @brief      1頂点あたりのバイト数を取得します.
+//!
+//! @param[in]      influenceCount  1頂点あたりの影響数です.
+//! @param[in]      format          重みのフォーマットです.
+//! @param[in]      indexSize       ボーン番号1つあたりのバイト数です.
+//! @return     4バイト境界に揃えたバイト数を返却します.
+//-----------------------------------------------------------------------------
+uint32_t GetSkinStride(
+    uint32_t            influenceCount,
+    SKIN_WEIGHT_FORMAT  format,
+    uint32_t            indexSize = sizeof(uint16_t));
+
+//-----------------------------------------------------------------------------
+//! @brief      パッキング結果を頂点単位のバイナリにエンコードします.
+//!
+//! @details    1頂点は [ボーン番号(uint16) x 影響数][重み x 影響数] の順に並び，
+//!             正規化整数の場合は量子化後の合計が最大値と一致するように補正します.
+//!
+//! @param[in]      skin            パッキング結果です.
+//! @param[in]      format          重みのフォーマットです.
+//! @param[out]     data            エンコード結果の格納先です.
+//! @return     量子化による重みの最大誤差を返却します.
+//-----------------------------------------------------------------------------
+float EncodeSkin(
+    const PackedSkin&       skin,
+    SKIN_WEIGHT_FORMAT      format,
+    std::vector<uint8_t>&   data);
\ No newline at end of file
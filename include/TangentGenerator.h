@@ -0,0 +1,104 @@
+﻿//-----------------------------------------------------------------------------
+// File : TangentGenerator.h
+// Desc : Tangent Space Generator.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asdxResModel.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+//! @brief      接線空間を生成します.
+//!
+//! @details    MikkTSpace と同様に面接線を頂点法線の接平面へ射影し，
+//!             コーナー角で重み付けして累積します. 重複除去済みの頂点に対して
+//!             実行することを想定しており，頂点単位で並列に処理します.
+//!
+//! @param[in]      vertexCount     頂点数です.
+//! @param[in]      pPositions      位置座標です.
+//! @param[in]      pNormals        法線ベクトルです.
+//! @param[in]      pTexCoords      テクスチャ座標です.
+//! @param[in]      indexCount      頂点インデックス数です.
+//! @param[in]      pIndices        頂点インデックスです.
+//! @param[out]     pTangentSpaces  エンコード済み接線空間の格納先です.
+//-----------------------------------------------------------------------------
+void GenerateTangentSpaces(
+    size_t                  vertexCount,
+    const asdx::Vector3*    pPositions,
+    const asdx::Vector3*    pNormals,
+    const asdx::Vector2*    pTexCoords,
+    size_t                  indexCount,
+    const uint32_t*         pIndices,
+    uint32_t*               pTangentSpaces);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TangentAccumulator class
+///////////////////////////////////////////////////////////////////////////////
+class TangentAccumulator
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      累積先を確保します.
+    //!
+    //! @details    GenerateTangentSpaces() と同じ重み付けで，三角形を1つずつ累積します.
+    //!             インデックスや頂点ストリームの複製を作らずに済むので，巨大なメッシュ向けです.
+    //!
+    //! @param[in]      slotCount       累積先の数です. 重複除去後の頂点数を指定します.
+    //-------------------------------------------------------------------------
+    void Init(size_t slotCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      三角形の寄与を累積します.
+    //!
+    //! @param[in]      slots           各頂点の累積先です.
+    //! @param[in]      positions       各頂点の位置座標です.
+    //! @param[in]      normals         各頂点の法線ベクトルです.
+    //! @param[in]      texcoords       各頂点のテクスチャ座標です.
+    //-------------------------------------------------------------------------
+    void AddFace(
+        const uint32_t          slots    [3],
+        const asdx::Vector3     positions[3],
+        const asdx::Vector3     normals  [3],
+        const asdx::Vector2     texcoords[3]);
+
+    //-------------------------------------------------------------------------
+    //! @brief      累積結果からエンコード済み接線空間を求めます.
+    //!
+    //! @param[in]      slot            累積先です.
+    //! @param[in]      normal          頂点の法線ベクトルです.
+    //! @return     エンコード済み接線空間を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t Resolve(uint32_t slot, const asdx::Vector3& normal) const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<asdx::Vector3>  m_Tangents;     //!< 累積した接線です.
+    std::vector<asdx::Vector3>  m_Binormals;    //!< 累積した従法線です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+﻿//-----------------------------------------------------------------------------
+// File : TextureConverter.h
+// Desc : Texture Converter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <MeshLoader.h>
+#include <ThreadPool.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureConvertOption structure
+///////////////////////////////////////////////////////////////////////////////
+struct TextureConvertOption
+{
+    std::string     InputDir;               //!< テクスチャの相対パスの基準ディレクトリです.
+    std::string     OutputDir;              //!< 変換結果の出力ディレクトリです.
+    uint32_t        ThreadCount     = 0;    //!< ワーカースレッド数です. 0 の場合はハードウェアスレッド数.
+    bool            GenerateMips    = true; //!< ミップマップを生成するならtrue.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureConverter class
+///////////////////////////////////////////////////////////////////////////////
+class TextureConverter
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    TextureConverter() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~TextureConverter();
+
+    //-------------------------------------------------------------------------
+    //! @brief      変換を開始します.
+    //!
+    //! @details    テクスチャごとの変換ジョブをスレッドプールに追加して直ちに戻ります.
+    //!             出力パスは開始時点で確定するため，GetTextures() はすぐに参照できます.
+    //!
+    //! @param[in]      materials   マテリアル情報です. 用途の判定に使います.
+    //! @param[in]      textures    変換するテクスチャです.
+    //! @param[in]      option      変換オプションです.
+    //! @retval true    開始に成功.
+    //! @retval false   開始に失敗.
+    //-------------------------------------------------------------------------
+    bool Begin(
+        const std::vector<Material>&        materials,
+        const std::vector<TextureEntry>&    textures,
+        const TextureConvertOption&         option);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全ての変換が完了するまで待機します.
+    //!
+    //! @return     失敗したテクスチャ数を返却します.
+    //-------------------------------------------------------------------------
+    size_t End();
+
+    //-------------------------------------------------------------------------
+    //! @brief      出力パスに書き換えたテクスチャを取得します.
+    //!
+    //! @details    ID は元のファイルパスのハッシュのまま維持します.
+    //!             End() 後に変換に失敗したテクスチャは元のパスに戻ります.
+    //!
+    //! @return     テクスチャを返却します.
+    //-------------------------------------------------------------------------
+    const std::vector<TextureEntry>& GetTextures() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Job structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Job
+    {
+        TEXTURE_USAGE   Usage;          //!< 用途です.
+        std::string     SrcPath;        //!< 入力ファイルパスです.
+        std::string     DstPath;        //!< 出力ファイルパスです.
+        std::shared_ptr<const std::vector<uint8_t>> Embedded;  //!< 埋め込みテクスチャのファイルイメージです.
+        bool            Success;        //!< 変換に成功したらtrue.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ThreadPool                  m_Pool;             //!< スレッドプールです.
+    TextureConvertOption        m_Option;           //!< 変換オプションです.
+    std::vector<TextureEntry>   m_Textures;         //!< 出力パスに書き換えたテクスチャです.
+    std::vector<Job>            m_Jobs;             //!< 変換ジョブです(m_Texturesと同じ順番).
+    std::atomic<size_t>         m_FailedCount;      //!< 失敗したテクスチャ数です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    TextureConverter    (const TextureConverter&) = delete;
+    void operator =     (const TextureConverter&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      1つのテクスチャを変換します.
+    //!
+    //! @param[in,out]  job         変換ジョブです.
+    //-------------------------------------------------------------------------
+    void Convert(Job& job);
+};
\ No newline at end of file
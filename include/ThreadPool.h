@@ -0,0 +1,119 @@
+﻿//-----------------------------------------------------------------------------
+// File : ThreadPool.h
+// Desc : Thread Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ThreadPool class
+///////////////////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ThreadPool() = default;
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ThreadPool();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      threadCount     ワーカースレッド数です. 0 の場合はハードウェアスレッド数を使います.
+    //! @param[in]      maxQueueSize    待機できるジョブ数の上限です. 0 の場合は無制限.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(uint32_t threadCount = 0, size_t maxQueueSize = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 待機中のジョブは全て実行してから終了します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ジョブを追加します. 待機数が上限に達している場合は空くまでブロックします.
+    //!
+    //! @param[in]      job         ジョブです.
+    //! @retval true    追加に成功.
+    //! @retval false   終了処理中のため追加できない.
+    //-------------------------------------------------------------------------
+    bool Push(std::function<void()> job);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ジョブを追加します. 待機数が上限に達している場合はブロックせずに失敗します.
+    //!
+    //! @param[in]      job         ジョブです.
+    //! @retval true    追加に成功.
+    //! @retval false   待機数が上限に達しているか，終了処理中.
+    //-------------------------------------------------------------------------
+    bool TryPush(std::function<void()> job);
+
+    //-------------------------------------------------------------------------
+    //! @brief      追加済みのジョブが全て完了するまで待機します.
+    //-------------------------------------------------------------------------
+    void Wait();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ワーカースレッド数を取得します.
+    //!
+    //! @return     ワーカースレッド数を返却します.
+    //-------------------------------------------------------------------------
+    size_t GetThreadCount() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<std::thread>            m_Threads;              //!< ワーカースレッドです.
+    std::deque<std::function<void()>>   m_Jobs;                 //!< 待機中のジョブです.
+    std::mutex                          m_Mutex;                //!< ミューテックスです.
+    std::condition_variable             m_PushCond;             //!< ジョブ追加の通知です.
+    std::condition_variable             m_PopCond;              //!< ジョブ取り出しの通知です.
+    std::condition_variable             m_IdleCond;             //!< 全ジョブ完了の通知です.
+    size_t                              m_MaxQueueSize  = 0;    //!< 待機できるジョブ数の上限です.
+    size_t                              m_RunningCount  = 0;    //!< 実行中のジョブ数です.
+    bool                                m_Terminate     = false;//!< 終了要求フラグです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    ThreadPool      (const ThreadPool&) = delete;
+    void operator = (const ThreadPool&) = delete;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ワーカースレッドの処理です.
+    //-------------------------------------------------------------------------
+    void Run();
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+﻿//-----------------------------------------------------------------------------
+// File : VertexLayout.h
+// Desc : Interleaved Vertex Layout.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <asdxResModel.h>
+#include <cstdint>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// VERTEX_ATTRIBUTE
+///////////////////////////////////////////////////////////////////////////////
+enum VERTEX_ATTRIBUTE
+{
+    VERTEX_ATTRIBUTE_TANGENT_SPACE,     //!< 圧縮済みの接線空間(4byte)です.
+    VERTEX_ATTRIBUTE_COLOR,             //!< 頂点カラー(4byte)です.
+    VERTEX_ATTRIBUTE_TEXCOORD0,         //!< テクスチャ座標0(4byte)です.
+    VERTEX_ATTRIBUTE_TEXCOORD1,         //!< テクスチャ座標1(4byte)です.
+    VERTEX_ATTRIBUTE_TEXCOORD2,         //!< テクスチャ座標2(4byte)です.
+    VERTEX_ATTRIBUTE_TEXCOORD3,         //!< テクスチャ座標3(4byte)です.
+    VERTEX_ATTRIBUTE_BONE_INDEX,        //!< ボーン番号(8byte)です.
+    VERTEX_ATTRIBUTE_BONE_WEIGHT,       //!< ボーンの重み(16byte)です.
+    VERTEX_ATTRIBUTE_COUNT,
+};
+
+static const uint8_t kInvalidAttributeOffset = 0xff;
+
+///////////////////////////////////////////////////////////////////////////////
+// VertexLayout structure
+///////////////////////////////////////////////////////////////////////////////
+struct VertexLayout
+{
+    uint32_t    Stride      = 0;                                //!< 1頂点あたりのバイト数です. 0 の場合はインターリーブしません.
+    uint32_t    Mask        = 0;                                //!< 含まれる属性のビットマスクです.
+    uint8_t     Offsets[VERTEX_ATTRIBUTE_COUNT] = {             //!< 頂点先頭からのオフセットです. 含まれない属性は kInvalidAttributeOffset.
+        kInvalidAttributeOffset, kInvalidAttributeOffset, kInvalidAttributeOffset, kInvalidAttributeOffset,
+        kInvalidAttributeOffset, kInvalidAttributeOffset, kInvalidAttributeOffset, kInvalidAttributeOffset,
+    };
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      属性の並び順を解析します.
+//!
+//! @details    "tangent,uv0,color" のようにカンマ区切りで指定します.
+//!             使用できる名前は tangent, color, uv0～uv3, bone_index, bone_weight です.
+//!             "all" は全属性を既定の順番で指定します.
+//!
+//! @param[in]      value       指定文字列です.
+//! @param[out]     order       属性の並び順の格納先です.
+//! @retval true    解析に成功.
+//! @retval false   不明な属性名が含まれている.
+//-----------------------------------------------------------------------------
+bool ParseVertexLayout(const char* value, std::vector<VERTEX_ATTRIBUTE>& order);
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュに合わせて頂点レイアウトを決定します.
+//!
+//! @details    メッシュが持たない属性は除外し，指定順に詰めて配置します.
+//!
+//! @param[in]      mesh        メッシュです.
+//! @param[in]      order       属性の並び順です.
+//! @return     頂点レイアウトを返却します.
+//-----------------------------------------------------------------------------
+VertexLayout GetVertexLayout(const asdx::ResMesh& mesh, const std::vector<VERTEX_ATTRIBUTE>& order);
+
+//-----------------------------------------------------------------------------
+//! @brief      インターリーブした頂点データを構築します.
+//!
+//! @details    頂点順はメッシュと同じです. 頂点フェッチ最適化済みの順番がそのまま維持されます.
+//!
+//! @param[in]      mesh        メッシュです.
+//! @param[in]      layout      頂点レイアウトです.
+//! @param[out]     data        頂点データの格納先です.
+//-----------------------------------------------------------------------------
+void BuildInterleavedVertices(
+    const asdx::ResMesh&    mesh,
+    const VertexLayout&     layout,
+    std::vector<uint8_t>&   data);
+
+//-----------------------------------------------------------------------------
+//! @brief      メッシュレットの頂点順で頂点フェッチの過剰読み込み率を求めます.
+//!
+//! @param[in]      mesh        メッシュです.
+//! @param[in]      stride      1頂点あたりのバイト数です.
+//! @return     過剰読み込み率(1.0 が最小)を返却します.
+//-----------------------------------------------------------------------------
+float AnalyzeVertexFetch(const asdx::ResMesh& mesh, uint32_t stride);
\ No newline at end of file
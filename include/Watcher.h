@@ -0,0 +1,42 @@
+﻿//-----------------------------------------------------------------------------
+// File : Watcher.h
+// Desc : Source Directory Watcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WatchOption structure
+///////////////////////////////////////////////////////////////////////////////
+struct WatchOption
+{
+    std::string     SourceDir;                  //!< 監視するディレクトリです.
+    std::string     CachePath;                  //!< 変換キャッシュのファイルパスです. 空の場合はメモリ上のみで保持します.
+    uint32_t        DelayMsec       = 300;      //!< 最後の変更から変換を開始するまでの待ち時間(ミリ秒)です.
+    uint32_t        ThreadCount     = 0;        //!< 同時に変換するファイル数です. 0 の場合はハードウェアスレッド数.
+    uint32_t        MaxQueueSize    = 16;       //!< 変換待ちジョブ数の上限です.
+};
+
+
+//-----------------------------------------------------------------------------
+//! @brief      ディレクトリを監視して変更されたモデルを変換します.
+//!
+//! @details    起動時に全てのモデルを走査し，以降は変更通知を受けたモデルのみ変換します.
+//!             短時間に連続した書き込みは DelayMsec の間まとめてから1回だけ変換し，
+//!             内容と変換オプションが前回と同じ場合は変換キャッシュにより省略します.
+//!             出力パスには "{name}" を含め，監視ディレクトリからの相対パス(拡張子なし)に置換します.
+//!             Ctrl+C で処理中の変換を終えてから戻ります.
+//!
+//! @param[in]      option      監視オプションです.
+//! @param[in]      argc        変換引数の数です.
+//! @param[in]      argv        変換引数です.
+//! @return     終了コードを返却します.
+//-----------------------------------------------------------------------------
+int RunWatch(const WatchOption& option, int argc, const char* const* argv);
\ No newline at end of file
@@ -0,0 +1,614 @@
+﻿//-----------------------------------------------------------------------------
+// File : AnimationConverter.cpp
+// Desc : Skeleton And Animation Converter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <AnimationConverter.h>
+#include <ParallelFor.h>
+#include <assimp/scene.h>
+#include <asdxHash.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const double kDefaultTicksPerSecond = 25.0;  // Assimpで未設定時に使われる値.
+static const float  kInvSqrt2 = 0.70710678f;        // 最小3成分の取り得る範囲.
+
+///////////////////////////////////////////////////////////////////////////////
+// Float3 structure
+///////////////////////////////////////////////////////////////////////////////
+struct Float3
+{
+    float v[3];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Float4 structure
+///////////////////////////////////////////////////////////////////////////////
+struct Float4
+{
+    float v[4];     // 回転の場合は xyzw.
+};
+
+//-----------------------------------------------------------------------------
+//      3成分を線形補間します.
+//-----------------------------------------------------------------------------
+inline Float3 Lerp(const Float3& a, const Float3& b, float t)
+{
+    Float3 result;
+    for(auto i=0; i<3; ++i)
+    { result.v[i] = a.v[i] + (b.v[i] - a.v[i]) * t; }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      3成分の誤差を求めます.
+//-----------------------------------------------------------------------------
+inline float Error(const Float3& a, const Float3& b)
+{
+    auto result = 0.0f;
+    for(auto i=0; i<3; ++i)
+    { result = std::max(result, fabsf(a.v[i] - b.v[i])); }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      四元数の内積を求めます.
+//-----------------------------------------------------------------------------
+inline float Dot(const Float4& a, const Float4& b)
+{ return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3]; }
+
+//-----------------------------------------------------------------------------
+//      四元数を正規化線形補間します.
+//-----------------------------------------------------------------------------
+inline Float4 Lerp(const Float4& a, const Float4& b, float t)
+{
+    Float4 result;
+    for(auto i=0; i<4; ++i)
+    { result.v[i] = a.v[i] + (b.v[i] - a.v[i]) * t; }
+
+    auto len = sqrtf(Dot(result, result));
+    if (len > 0.0f)
+    {
+        for(auto i=0; i<4; ++i)
+        { result.v[i] /= len; }
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      四元数間の角度誤差を求めます.
+//-----------------------------------------------------------------------------
+inline float Error(const Float4& a, const Float4& b)
+{
+    auto d = std::min(1.0f, fabsf(Dot(a, b)));
+    return 2.0f * acosf(d);
+}
+
+//-----------------------------------------------------------------------------
+//      線形補間で再現できるキーを削減します.
+//-----------------------------------------------------------------------------
+template<typename T>
+void ReduceKeys
+(
+    const std::vector<double>&  times,
+    const std::vector<T>&       values,
+    float                       tolerance,
+    std::vector<uint32_t>&      kept
+)
+{
+    kept.clear();
+
+    auto count = values.size();
+    if (count == 0)
+    { return; }
+
+    kept.push_back(0);
+
+    // 端点間の補間で間のキーを全て許容誤差内に再現できる限り延長する.
+    size_t anchor = 0;
+    for(size_t i=2; i<count; ++i)
+    {
+        auto span = times[i] - times[anchor];
+        auto valid = true;
+        for(auto j=anchor + 1; j<i && valid; ++j)
+        {
+            auto t = (span > 0.0) ? float((times[j] - times[anchor]) / span) : 0.0f;
+            valid = Error(Lerp(values[anchor], values[i], t), values[j]) <= tolerance;
+        }
+
+        if (!valid)
+        {
+            anchor = i - 1;
+            kept.push_back(uint32_t(anchor));
+        }
+    }
+
+    if (count > 1)
+    { kept.push_back(uint32_t(count - 1)); }
+
+    // 全区間で一定なら1キーにする.
+    if (kept.size() == 2 && Error(values[kept[0]], values[kept[1]]) <= tolerance)
+    { kept.pop_back(); }
+}
+
+//-----------------------------------------------------------------------------
+//      時刻を16bitに量子化します.
+//-----------------------------------------------------------------------------
+inline uint16_t QuantizeTime(double time, double duration)
+{
+    if (duration <= 0.0)
+    { return 0; }
+
+    auto t = std::max(0.0, std::min(1.0, time / duration));
+    return uint16_t(t * 65535.0 + 0.5);
+}
+
+//-----------------------------------------------------------------------------
+//      範囲を指定して16bitに量子化します.
+//-----------------------------------------------------------------------------
+inline uint16_t QuantizeRange(float value, float mini, float extent)
+{
+    if (extent <= 0.0f)
+    { return 0; }
+
+    auto t = std::max(0.0f, std::min(1.0f, (value - mini) / extent));
+    return uint16_t(t * 65535.0f + 0.5f);
+}
+
+//-----------------------------------------------------------------------------
+//      四元数を最小3成分の48bitに量子化します.
+//
+//      絶対値が最大の成分を除いた3成分を15bitずつ格納し，
+//      除いた成分の番号(2bit)は先頭2要素の最上位ビットに格納します.
+//-----------------------------------------------------------------------------
+inline void QuantizeRotation(const Float4& q, uint16_t* pDst)
+{
+    auto largest = 0;
+    for(auto i=1; i<4; ++i)
+    {
+        if (fabsf(q.v[i]) > fabsf(q.v[largest]))
+        { largest = i; }
+    }
+
+    // 最大成分が正になるようにする(q と -q は同じ回転).
+    auto sign = (q.v[largest] < 0.0f) ? -1.0f : 1.0f;
+
+    auto idx = 0;
+    for(auto i=0; i<4; ++i)
+    {
+        if (i == largest)
+        { continue; }
+
+        auto value = q.v[i] * sign;
+        auto t = (value + kInvSqrt2) / (2.0f * kInvSqrt2);
+        t = std::max(0.0f, std::min(1.0f, t));
+        pDst[idx++] = uint16_t(t * 32767.0f + 0.5f);
+    }
+
+    pDst[0] |= uint16_t((largest >> 1) & 0x1) << 15;
+    pDst[1] |= uint16_t((largest >> 0) & 0x1) << 15;
+}
+
+//-----------------------------------------------------------------------------
+//      平行移動・拡大縮小キーを変換します.
+//-----------------------------------------------------------------------------
+void ConvertVectorKeys
+(
+    const aiVectorKey*      pKeys,
+    uint32_t                count,
+    double                  ticksPerSecond,
+    double                  duration,
+    float                   tolerance,
+    asdx::Vector3&          mini,
+    asdx::Vector3&          extent,
+    std::vector<uint16_t>&  result
+)
+{
+    std::vector<double> times (count);
+    std::vector<Float3> values(count);
+    for(auto i=0u; i<count; ++i)
+    {
+        times [i] = pKeys[i].mTime / ticksPerSecond;
+        values[i] = { { pKeys[i].mValue.x, pKeys[i].mValue.y, pKeys[i].mValue.z } };
+    }
+
+    std::vector<uint32_t> kept;
+    ReduceKeys(times, values, tolerance, kept);
+
+    // 残ったキーの範囲を求める.
+    Float3 lo = values[kept[0]];
+    Float3 hi = values[kept[0]];
+    for(auto k : kept)
+    {
+        for(auto i=0; i<3; ++i)
+        {
+            lo.v[i] = std::min(lo.v[i], values[k].v[i]);
+            hi.v[i] = std::max(hi.v[i], values[k].v[i]);
+        }
+    }
+
+    mini   = asdx::Vector3(lo.v[0], lo.v[1], lo.v[2]);
+    extent = asdx::Vector3(hi.v[0] - lo.v[0], hi.v[1] - lo.v[1], hi.v[2] - lo.v[2]);
+
+    result.reserve(kept.size() * 4);
+    for(auto k : kept)
+    {
+        result.push_back(QuantizeTime(times[k], duration));
+        result.push_back(QuantizeRange(values[k].v[0], lo.v[0], extent.x));
+        result.push_back(QuantizeRange(values[k].v[1], lo.v[1], extent.y));
+        result.push_back(QuantizeRange(values[k].v[2], lo.v[2], extent.z));
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      回転キーを変換します.
+//-----------------------------------------------------------------------------
+void ConvertRotationKeys
+(
+    const aiQuatKey*        pKeys,
+    uint32_t                count,
+    double                  ticksPerSecond,
+    double                  duration,
+    float                   tolerance,
+    std::vector<uint16_t>&  result
+)
+{
+    std::vector<double> times (count);
+    std::vector<Float4> values(count);
+    for(auto i=0u; i<count; ++i)
+    {
+        const auto& q = pKeys[i].mValue;
+        times [i] = pKeys[i].mTime / ticksPerSecond;
+        values[i] = { { q.x, q.y, q.z, q.w } };
+
+        // 補間が最短経路になるように半球を揃える.
+        if (i > 0 && Dot(values[i - 1], values[i]) < 0.0f)
+        {
+            for(auto j=0; j<4; ++j)
+            { values[i].v[j] = -values[i].v[j]; }
+        }
+    }
+
+    std::vector<uint32_t> kept;
+    ReduceKeys(times, values, tolerance, kept);
+
+    result.reserve(kept.size() * 4);
+    for(auto k : kept)
+    {
+        uint16_t packed[3] = {};
+        QuantizeRotation(values[k], packed);
+
+        result.push_back(QuantizeTime(times[k], duration));
+        result.push_back(packed[0]);
+        result.push_back(packed[1]);
+        result.push_back(packed[2]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      バイト列を追加します.
+//-----------------------------------------------------------------------------
+void Append(std::vector<uint8_t>& data, const void* pValue, size_t size)
+{
+    auto ptr = static_cast<const uint8_t*>(pValue);
+    data.insert(data.end(), ptr, ptr + size);
+}
+
+//-----------------------------------------------------------------------------
+//      文字列を追加します.
+//-----------------------------------------------------------------------------
+void AppendString(std::vector<uint8_t>& data, const std::string& value)
+{
+    auto length = uint32_t(value.size());
+    Append(data, &length, sizeof(length));
+    Append(data, value.c_str(), length);
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      関節番号を検索します.
+//-----------------------------------------------------------------------------
+int32_t Skeleton::Find(uint32_t hash) const
+{
+    for(size_t i=0; i<Joints.size(); ++i)
+    {
+        if (Joints[i].Hash == hash)
+        { return int32_t(i); }
+    }
+
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+//      スケルトンを構築します.
+//-----------------------------------------------------------------------------
+bool BuildSkeleton(const aiScene* pScene, Skeleton& skeleton)
+{
+    skeleton.Joints.clear();
+
+    if (pScene == nullptr || pScene->mRootNode == nullptr)
+    { return false; }
+
+    // ボーンが参照するノードを列挙.
+    std::map<const aiNode*, const aiBone*> required;
+    for(auto i=0u; i<pScene->mNumMeshes; ++i)
+    {
+        auto pMesh = pScene->mMeshes[i];
+        for(auto j=0u; j<pMesh->mNumBones; ++j)
+        {
+            auto pBone = pMesh->mBones[j];
+            auto pNode = pScene->mRootNode->FindNode(pBone->mName);
+            if (pNode == nullptr)
+            {
+                ELOGA("Error : Bone Node Not Found. name = %s", pBone->mName.C_Str());
+                continue;
+            }
+
+            // 祖先も関節として必要になる(シーンのルートは除く).
+            required[pNode] = pBone;
+            for(auto pParent = pNode->mParent; pParent != nullptr && pParent != pScene->mRootNode; pParent = pParent->mParent)
+            {
+                if (required.find(pParent) == required.end())
+                { required[pParent] = nullptr; }
+            }
+        }
+    }
+
+    if (required.empty())
+    { return false; }
+
+    // 深さ優先で辿り，親が必ず子より前に来るように番号を付ける.
+    struct Entry
+    {
+        const aiNode*   pNode;
+        int32_t         Parent;
+    };
+
+    std::vector<Entry> stack;
+    stack.push_back({ pScene->mRootNode, -1 });
+
+    while(!stack.empty())
+    {
+        auto entry = stack.back();
+        stack.pop_back();
+
+        auto parent = entry.Parent;
+        auto itr = required.find(entry.pNode);
+        if (itr != required.end())
+        {
+            aiVector3D   scale;
+            aiQuaternion rotation;
+            aiVector3D   translation;
+            entry.pNode->mTransformation.Decompose(scale, rotation, translation);
+
+            Joint joint;
+            joint.Name            = entry.pNode->mName.C_Str();
+            joint.Hash            = asdx::Fnv1a(joint.Name.c_str()).GetHash();
+            joint.Parent          = parent;
+            joint.BindTranslation = asdx::Vector3(translation.x, translation.y, translation.z);
+            joint.BindRotation    = asdx::Vector4(rotation.x, rotation.y, rotation.z, rotation.w);
+            joint.BindScale       = asdx::Vector3(scale.x, scale.y, scale.z);
+
+            // ボーンで無い祖先は単位行列.
+            aiMatrix4x4 m;
+            if (itr->second != nullptr)
+            { m = itr->second->mOffsetMatrix; }
+
+            joint.InvBindPose[0] = asdx::Vector4(m.a1, m.a2, m.a3, m.a4);
+            joint.InvBindPose[1] = asdx::Vector4(m.b1, m.b2, m.b3, m.b4);
+            joint.InvBindPose[2] = asdx::Vector4(m.c1, m.c2, m.c3, m.c4);
+
+            parent = int32_t(skeleton.Joints.size());
+            skeleton.Joints.push_back(joint);
+        }
+
+        // 子を番号順に処理するため逆順に積む.
+        for(auto i=entry.pNode->mNumChildren; i>0; --i)
+        { stack.push_back({ entry.pNode->mChildren[i - 1], parent }); }
+    }
+
+    skeleton.Joints.shrink_to_fit();
+    return !skeleton.Joints.empty();
+}
+
+//-----------------------------------------------------------------------------
+//      アニメーションを変換します.
+//-----------------------------------------------------------------------------
+void ConvertAnimation
+(
+    const aiAnimation*              pSrcAnimation,
+    const Skeleton&                 skeleton,
+    const AnimationCompressOption&  option,
+    AnimationClip&                  clip
+)
+{
+    auto ticksPerSecond = (pSrcAnimation->mTicksPerSecond > 0.0)
+        ? pSrcAnimation->mTicksPerSecond
+        : kDefaultTicksPerSecond;
+    auto duration = pSrcAnimation->mDuration / ticksPerSecond;
+
+    clip.Name           = pSrcAnimation->mName.C_Str();
+    clip.Hash           = asdx::Fnv1a(clip.Name.c_str()).GetHash();
+    clip.Duration       = float(duration);
+    clip.SourceKeyCount = 0;
+    clip.KeyCount       = 0;
+    clip.Tracks.clear();
+
+    // スケルトンに含まれるチャンネルだけ変換する.
+    std::vector<const aiNodeAnim*> channels;
+    for(auto i=0u; i<pSrcAnimation->mNumChannels; ++i)
+    {
+        auto pChannel = pSrcAnimation->mChannels[i];
+        auto joint = skeleton.Find(asdx::Fnv1a(pChannel->mNodeName.C_Str()).GetHash());
+        if (joint < 0)
+        { continue; }
+
+        AnimationTrack track = {};
+        track.JointIndex = uint16_t(joint);
+        clip.Tracks.push_back(track);
+        channels.push_back(pChannel);
+
+        clip.SourceKeyCount += pChannel->mNumPositionKeys
+                             + pChannel->mNumRotationKeys
+                             + pChannel->mNumScalingKeys;
+    }
+
+    // トラックは互いに独立しているので並列に変換する.
+    ParallelFor(channels.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(auto i=begin; i<end; ++i)
+        {
+            auto  pChannel = channels[i];
+            auto& track    = clip.Tracks[i];
+
+            if (pChannel->mNumPositionKeys > 0)
+            {
+                ConvertVectorKeys(
+                    pChannel->mPositionKeys,
+                    pChannel->mNumPositionKeys,
+                    ticksPerSecond,
+                    duration,
+                    option.PositionTolerance,
+                    track.PositionMin,
+                    track.PositionExtent,
+                    track.PositionKeys);
+            }
+
+            if (pChannel->mNumRotationKeys > 0)
+            {
+                ConvertRotationKeys(
+                    pChannel->mRotationKeys,
+                    pChannel->mNumRotationKeys,
+                    ticksPerSecond,
+                    duration,
+                    option.RotationTolerance,
+                    track.RotationKeys);
+            }
+
+            if (pChannel->mNumScalingKeys > 0)
+            {
+                ConvertVectorKeys(
+                    pChannel->mScalingKeys,
+                    pChannel->mNumScalingKeys,
+                    ticksPerSecond,
+                    duration,
+                    option.ScaleTolerance,
+                    track.ScaleMin,
+                    track.ScaleExtent,
+                    track.ScaleKeys);
+            }
+        }
+    });
+
+    for(auto& track : clip.Tracks)
+    {
+        clip.KeyCount += (track.PositionKeys.size()
+                       +  track.RotationKeys.size()
+                       +  track.ScaleKeys.size()) / 4;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      スケルトンとアニメーションをバイナリデータに変換します.
+//-----------------------------------------------------------------------------
+void BuildAnimationData
+(
+    const Skeleton&                     skeleton,
+    const std::vector<AnimationClip>&   clips,
+    std::vector<uint8_t>&               data
+)
+{
+    data.clear();
+
+    // ファイルヘッダ.
+    const uint8_t  magic[4]   = { 'A', 'N', 'M', '\0' };
+    const uint32_t version    = 1;
+    const uint32_t jointCount = uint32_t(skeleton.Joints.size());
+    const uint32_t clipCount  = uint32_t(clips.size());
+    Append(data, magic,       sizeof(magic));
+    Append(data, &version,    sizeof(version));
+    Append(data, &jointCount, sizeof(jointCount));
+    Append(data, &clipCount,  sizeof(clipCount));
+
+    // スケルトン.
+    for(auto& joint : skeleton.Joints)
+    {
+        Append(data, &joint.Hash,            sizeof(joint.Hash));
+        Append(data, &joint.Parent,          sizeof(joint.Parent));
+        Append(data, &joint.BindTranslation, sizeof(joint.BindTranslation));
+        Append(data, &joint.BindRotation,    sizeof(joint.BindRotation));
+        Append(data, &joint.BindScale,       sizeof(joint.BindScale));
+        Append(data, &joint.InvBindPose[0],  sizeof(joint.InvBindPose));
+        AppendString(data, joint.Name);
+    }
+
+    // アニメーションクリップ.
+    for(auto& clip : clips)
+    {
+        auto trackCount = uint32_t(clip.Tracks.size());
+        Append(data, &clip.Hash,     sizeof(clip.Hash));
+        Append(data, &clip.Duration, sizeof(clip.Duration));
+        Append(data, &trackCount,    sizeof(trackCount));
+        AppendString(data, clip.Name);
+
+        for(auto& track : clip.Tracks)
+        {
+            uint32_t counts[3] = {
+                uint32_t(track.PositionKeys.size() / 4),
+                uint32_t(track.RotationKeys.size() / 4),
+                uint32_t(track.ScaleKeys   .size() / 4),
+            };
+
+            Append(data, &track.JointIndex,     sizeof(track.JointIndex));
+            Append(data, counts,                sizeof(counts));
+            Append(data, &track.PositionMin,    sizeof(track.PositionMin));
+            Append(data, &track.PositionExtent, sizeof(track.PositionExtent));
+            Append(data, &track.ScaleMin,       sizeof(track.ScaleMin));
+            Append(data, &track.ScaleExtent,    sizeof(track.ScaleExtent));
+            Append(data, track.PositionKeys.data(), sizeof(uint16_t) * track.PositionKeys.size());
+            Append(data, track.RotationKeys.data(), sizeof(uint16_t) * track.RotationKeys.size());
+            Append(data, track.ScaleKeys   .data(), sizeof(uint16_t) * track.ScaleKeys   .size());
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      スケルトンとアニメーションをバイナリファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportAnimation
+(
+    const char*                         path,
+    const Skeleton&                     skeleton,
+    const std::vector<AnimationClip>&   clips
+)
+{
+    std::vector<uint8_t> data;
+    BuildAnimationData(skeleton, clips, data);
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "wb");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", path);
+        return false;
+    }
+
+    auto size = fwrite(data.data(), 1, data.size(), pFile);
+    fclose(pFile);
+    return size == data.size();
+}
\ No newline at end of file
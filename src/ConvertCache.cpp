@@ -0,0 +1,182 @@
+﻿//-----------------------------------------------------------------------------
+// File : ConvertCache.cpp
+// Desc : Conversion Cache.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ConvertCache.h>
+#include <asdxLogger.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const uint32_t kConvertCacheVersion  = 1;
+static const uint64_t kFnvOffsetBasis       = 0xcbf29ce484222325ull;
+static const uint64_t kFnvPrime             = 0x100000001b3ull;
+
+//-----------------------------------------------------------------------------
+//      FNV-1a でハッシュを積算します.
+//-----------------------------------------------------------------------------
+uint64_t Accumulate(uint64_t hash, const void* pData, size_t size)
+{
+    auto ptr = static_cast<const uint8_t*>(pData);
+    for(size_t i=0; i<size; ++i)
+    {
+        hash ^= ptr[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      キャッシュファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool ConvertCache::Load(const char* path)
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Entries.clear();
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "r");
+    if (err != 0)
+    { return true; }
+
+    // [バージョン]
+    // [ファイルハッシュ] [オプションハッシュ] [キー]
+    // ...
+    char line[4096];
+    uint32_t version = 0;
+    if (fgets(line, sizeof(line), pFile) == nullptr
+     || sscanf_s(line, "%u", &version) != 1
+     || version != kConvertCacheVersion)
+    {
+        // 形式が異なる場合は全て再変換させる.
+        fclose(pFile);
+        return true;
+    }
+
+    while (fgets(line, sizeof(line), pFile) != nullptr)
+    {
+        Entry entry;
+        int   pos = 0;
+        if (sscanf_s(line, "%" SCNx64 " %" SCNx64 " %n", &entry.FileHash, &entry.OptionHash, &pos) != 2)
+        { continue; }
+
+        std::string key(line + pos);
+        while (!key.empty() && (key.back() == '\n' || key.back() == '\r'))
+        { key.pop_back(); }
+
+        if (key.empty())
+        { continue; }
+
+        m_Entries[key] = entry;
+    }
+
+    fclose(pFile);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      キャッシュファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool ConvertCache::Save(const char* path) const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "w");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", path);
+        return false;
+    }
+
+    fprintf(pFile, "%u\n", kConvertCacheVersion);
+    for(auto& itr : m_Entries)
+    {
+        fprintf(pFile, "%016" PRIx64 " %016" PRIx64 " %s\n",
+            itr.second.FileHash,
+            itr.second.OptionHash,
+            itr.first.c_str());
+    }
+
+    fclose(pFile);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      前回の変換結果が有効かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool ConvertCache::IsUpToDate(const std::string& key, uint64_t fileHash, uint64_t optionHash) const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    auto itr = m_Entries.find(key);
+    if (itr == m_Entries.end())
+    { return false; }
+
+    return itr->second.FileHash == fileHash && itr->second.OptionHash == optionHash;
+}
+
+//-----------------------------------------------------------------------------
+//      変換結果を記録します.
+//-----------------------------------------------------------------------------
+void ConvertCache::Update(const std::string& key, uint64_t fileHash, uint64_t optionHash)
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    auto& entry = m_Entries[key];
+    entry.FileHash   = fileHash;
+    entry.OptionHash = optionHash;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルの内容のハッシュを計算します.
+//-----------------------------------------------------------------------------
+bool CalcFileHash(const char* path, uint64_t& hash)
+{
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "rb");
+    if (err != 0)
+    { return false; }
+
+    std::vector<uint8_t> buffer(64 * 1024);
+    hash = kFnvOffsetBasis;
+    for(;;)
+    {
+        auto size = fread(buffer.data(), 1, buffer.size(), pFile);
+        if (size == 0)
+        { break; }
+
+        hash = Accumulate(hash, buffer.data(), size);
+    }
+
+    fclose(pFile);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      変換オプションのハッシュを計算します.
+//-----------------------------------------------------------------------------
+uint64_t CalcOptionHash(int argc, const char* const* argv)
+{
+    // 引数の区切りも含めて積算し, "-a bc" と "-ab c" を区別する.
+    auto hash = kFnvOffsetBasis;
+    for(auto i=0; i<argc; ++i)
+    { hash = Accumulate(hash, argv[i], strlen(argv[i]) + 1); }
+
+    return hash;
+}
\ No newline at end of file
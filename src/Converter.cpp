@@ -0,0 +1,830 @@
+﻿//-----------------------------------------------------------------------------
+// File : Converter.cpp
+// Desc : Model Converter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <Converter.h>
+#include <MaterialExporter.h>
+#include <asdxLogger.h>
+#include <assimp/postprocess.h>
+#include <chrono>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      値を取る引数の次に進みます.
+//-----------------------------------------------------------------------------
+bool NextArg(int argc, const char* const* argv, int& i)
+{
+    if (i + 1 >= argc)
+    {
+        ELOGA("Error : Missing Argument Value. option = %s", argv[i]);
+        return false;
+    }
+
+    i++;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      相対パスを基準ディレクトリからのパスにします.
+//-----------------------------------------------------------------------------
+void ResolvePath(const std::string& baseDir, std::string& path)
+{
+    if (path.empty() || baseDir.empty())
+    { return; }
+
+    // ドライブ指定, ルート, UNC パスは絶対パス.
+    if ((path.size() >= 2 && path[1] == ':') || path[0] == '/' || path[0] == '\\')
+    { return; }
+
+    auto last = baseDir.back();
+    if (last == '/' || last == '\\')
+    { path = baseDir + path; }
+    else
+    { path = baseDir + "/" + path; }
+}
+
+//-----------------------------------------------------------------------------
+//      "{name}" を置換します.
+//-----------------------------------------------------------------------------
+void ExpandPath(const std::string& name, std::string& path)
+{
+    static const char   kTag[]  = "{name}";
+    static const size_t kLength = sizeof(kTag) - 1;
+
+    auto pos = path.find(kTag);
+    while (pos != std::string::npos)
+    {
+        path.replace(pos, kLength, name);
+        pos = path.find(kTag, pos + name.size());
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      スキニングデータをバイナリファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportSkin(const char* name, const std::vector<SkinStream>& skins)
+{
+    std::vector<uint8_t> data;
+    BuildSkinData(skins, data);
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, name, "wb");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", name);
+        return false;
+    }
+
+    auto size = fwrite(data.data(), 1, data.size(), pFile);
+    fclose(pFile);
+    return size == data.size();
+}
+
+//-----------------------------------------------------------------------------
+//      シャドウメッシュをバイナリファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportShadow(const char* name, const std::vector<ShadowMesh>& shadows)
+{
+    std::vector<uint8_t> data;
+    BuildShadowData(shadows, data);
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, name, "wb");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", name);
+        return false;
+    }
+
+    auto size = fwrite(data.data(), 1, data.size(), pFile);
+    fclose(pFile);
+    return size == data.size();
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      スキニングデータをバイナリデータに変換します.
+//-----------------------------------------------------------------------------
+void BuildSkinData(const std::vector<SkinStream>& skins, std::vector<uint8_t>& data)
+{
+    data.clear();
+
+    auto append = [&](const void* pValue, size_t size)
+    {
+        auto ptr = static_cast<const uint8_t*>(pValue);
+        data.insert(data.end(), ptr, ptr + size);
+    };
+
+    // ファイルヘッダ.
+    const uint8_t magic[4] = { 'S', 'K', 'N', '\0' };
+    const uint32_t version = 2;
+    const uint32_t count   = uint32_t(skins.size());
+    append(magic,    sizeof(magic));
+    append(&version, sizeof(version));
+    append(&count,   sizeof(count));
+
+    for(size_t i=0; i<skins.size(); ++i)
+    {
+        auto& skin = skins[i];
+
+        uint32_t header[7] = {
+            skin.MeshHash,
+            skin.InfluenceCount,
+            uint32_t(skin.WeightFormat),
+            skin.IndexSize,
+            skin.Stride,
+            uint32_t(skin.Data.size() / skin.Stride),
+            uint32_t(skin.BonePalette.size()),
+        };
+        append(header, sizeof(header));
+        append(skin.BonePalette.data(), sizeof(uint16_t) * skin.BonePalette.size());
+        append(skin.Data.data(), skin.Data.size());
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      シャドウメッシュをバイナリデータに変換します.
+//-----------------------------------------------------------------------------
+void BuildShadowData(const std::vector<ShadowMesh>& shadows, std::vector<uint8_t>& data)
+{
+    data.clear();
+
+    auto append = [&](const void* pValue, size_t size)
+    {
+        auto ptr = static_cast<const uint8_t*>(pValue);
+        data.insert(data.end(), ptr, ptr + size);
+    };
+
+    // ファイルヘッダ.
+    const uint8_t magic[4] = { 'S', 'D', 'W', '\0' };
+    const uint32_t version = 1;
+    const uint32_t count   = uint32_t(shadows.size());
+    append(magic,    sizeof(magic));
+    append(&version, sizeof(version));
+    append(&count,   sizeof(count));
+
+    for(size_t i=0; i<shadows.size(); ++i)
+    {
+        auto& shadow = shadows[i];
+
+        uint32_t header[6] = {
+            shadow.MeshHash,
+            uint32_t(shadow.Positions.size()),
+            uint32_t(shadow.TriangleIndices.size()),
+            uint32_t(shadow.Indices.size()),
+            uint32_t(shadow.Primitives.size()),
+            uint32_t(shadow.Meshlets.size()),
+        };
+        append(header, sizeof(header));
+        append(shadow.Positions      .data(), sizeof(shadow.Positions[0])       * shadow.Positions      .size());
+        append(shadow.TriangleIndices.data(), sizeof(shadow.TriangleIndices[0]) * shadow.TriangleIndices.size());
+        append(shadow.Indices        .data(), sizeof(shadow.Indices[0])         * shadow.Indices        .size());
+        append(shadow.Primitives     .data(), sizeof(shadow.Primitives[0])      * shadow.Primitives     .size());
+        append(shadow.Meshlets       .data(), sizeof(shadow.Meshlets[0])        * shadow.Meshlets       .size());
+        append(shadow.CullingInfos   .data(), sizeof(shadow.CullingInfos[0])    * shadow.CullingInfos   .size());
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドライン引数を解析します.
+//-----------------------------------------------------------------------------
+bool ParseArgs(int argc, const char* const* argv, ConvertArgs& args)
+{
+    auto explicitProfile = false;
+
+    for(auto i=0; i<argc; ++i)
+    {
+        if (strcmp(argv[i], "-i") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Input = argv[i];
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Output = argv[i];
+        }
+        else if (strcmp(argv[i], "-m") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.MaterialYaml = argv[i];
+        }
+        else if (strcmp(argv[i], "-mb") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.MaterialTable = argv[i];
+        }
+        else if (strcmp(argv[i], "-merge_mesh") == 0)
+        {
+            args.Option.MergeMeshes = true;
+        }
+        else if (strcmp(argv[i], "-split") == 0)
+        {
+            // 1メッシュの最大三角形数.
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Option.MaxFaceCount = uint32_t(strtoul(argv[i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "-merge_material") == 0)
+        {
+            args.Option.MergeMaterials = true;
+        }
+        else if (strcmp(argv[i], "-tdep") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.TextureIndex = argv[i];
+        }
+        else if (strcmp(argv[i], "-profile") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            if (!FindImportProfile(argv[i], args.Option.Profile))
+            {
+                ELOGA("Error : Unknown Import Profile. name = %s", argv[i]);
+                return false;
+            }
+            explicitProfile = true;
+        }
+        else if (strcmp(argv[i], "-enable") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            uint32_t flag = 0;
+            if (!FindPostProcessFlag(argv[i], flag))
+            {
+                ELOGA("Error : Unknown PostProcess Flag. name = %s", argv[i]);
+                return false;
+            }
+            args.Option.EnableFlags  |= flag;
+            args.Option.DisableFlags &= ~flag;
+        }
+        else if (strcmp(argv[i], "-disable") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            uint32_t flag = 0;
+            if (!FindPostProcessFlag(argv[i], flag))
+            {
+                ELOGA("Error : Unknown PostProcess Flag. name = %s", argv[i]);
+                return false;
+            }
+            args.Option.DisableFlags |= flag;
+            args.Option.EnableFlags  &= ~flag;
+        }
+        else if (strcmp(argv[i], "-time") == 0)
+        {
+            args.Option.MeasureTime = true;
+        }
+        else if (strcmp(argv[i], "-skin") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Skin = argv[i];
+        }
+        else if (strcmp(argv[i], "-influence") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Option.SkinInfluenceCount = uint32_t(atoi(argv[i]));
+            if (args.Option.SkinInfluenceCount < 1 || args.Option.SkinInfluenceCount > 8)
+            {
+                ELOGA("Error : Invalid Influence Count. value = %s", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-weight") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            if (_stricmp(argv[i], "float") == 0)
+            { args.Option.SkinWeightFormat = SKIN_WEIGHT_FORMAT_FLOAT; }
+            else if (_stricmp(argv[i], "unorm16") == 0)
+            { args.Option.SkinWeightFormat = SKIN_WEIGHT_FORMAT_UNORM16; }
+            else if (_stricmp(argv[i], "unorm8") == 0)
+            { args.Option.SkinWeightFormat = SKIN_WEIGHT_FORMAT_UNORM8; }
+            else
+            {
+                ELOGA("Error : Unknown Weight Format. name = %s", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-palette") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Option.BonePaletteSize = uint32_t(atoi(argv[i]));
+            if (args.Option.BonePaletteSize > 256)
+            {
+                ELOGA("Error : Bone Palette Size Too Large. value = %s", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-working_set") == 0)
+        {
+            // メッシュ構築時の作業メモリの目安. メガバイト単位で指定.
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Option.WorkingSetBudget = size_t(strtoull(argv[i], nullptr, 10)) * 1024 * 1024;
+        }
+        else if (strcmp(argv[i], "-tex") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.TexOption.OutputDir = argv[i];
+        }
+        else if (strcmp(argv[i], "-embed") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Option.EmbeddedTextureDir = argv[i];
+        }
+        else if (strcmp(argv[i], "-tex_thread") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.TexOption.ThreadCount = uint32_t(atoi(argv[i]));
+        }
+        else if (strcmp(argv[i], "-tex_nomip") == 0)
+        {
+            args.TexOption.GenerateMips = false;
+        }
+        else if (strcmp(argv[i], "-anim") == 0)
+        {
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Animation = argv[i];
+            args.Option.ParseAnimation = true;
+        }
+        else if (strcmp(argv[i], "-mapped") == 0)
+        {
+            // メモリマップ可能な形式で出力.
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Mapped = argv[i];
+        }
+        else if (strcmp(argv[i], "-shadow") == 0)
+        {
+            // 深度・シャドウパス用の位置座標のみのメッシュを出力.
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            args.Shadow = argv[i];
+            args.Option.GenerateShadowMesh = true;
+        }
+        else if (strcmp(argv[i], "-stream") == 0)
+        {
+            // メッシュを保持せずにメモリマップ形式へ逐次出力.
+            args.Stream = true;
+        }
+        else if (strcmp(argv[i], "-layout") == 0)
+        {
+            // メモリマップ形式でインターリーブする属性の並び順.
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            if (!ParseVertexLayout(argv[i], args.MappedOption.VertexLayout))
+            {
+                ELOGA("Error : Invalid Vertex Layout. value = %s", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-layout_only") == 0)
+        {
+            // インターリーブした属性の個別ストリームを出力しない.
+            args.MappedOption.SeparateStreams = false;
+        }
+        else if (strcmp(argv[i], "-anim_error") == 0)
+        {
+            // 平行移動・回転(ラジアン)・拡大縮小に同じ許容誤差を設定.
+            if (!NextArg(argc, argv, i))
+            { return false; }
+            auto value = float(atof(argv[i]));
+            if (value < 0.0f)
+            {
+                ELOGA("Error : Invalid Animation Error. value = %s", argv[i]);
+                return false;
+            }
+            args.Option.AnimationCompress.PositionTolerance = value;
+            args.Option.AnimationCompress.RotationTolerance = value;
+            args.Option.AnimationCompress.ScaleTolerance    = value;
+        }
+    }
+
+    // スキニングとアニメーションはボーンが必要なので PreTransformVertices を使うプロファイルでは変換できない.
+    if (args.Option.ParseAnimation || !args.Skin.empty())
+    {
+        if (!explicitProfile)
+        { args.Option.Profile = IMPORT_PROFILE_SKINNED; }
+
+        auto flag = GetImportFlags(args.Option.Profile);
+        flag |= args.Option.EnableFlags;
+        flag &= ~args.Option.DisableFlags;
+        if (flag & aiProcess_PreTransformVertices)
+        {
+            ELOGA("Error : -anim and -skin cannot be used with PreTransformVertices. Use -profile skinned.");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      相対パスを基準ディレクトリからのパスに変換します.
+//-----------------------------------------------------------------------------
+void ResolvePaths(const std::string& baseDir, ConvertArgs& args)
+{
+    ResolvePath(baseDir, args.Input);
+    ResolvePath(baseDir, args.Output);
+    ResolvePath(baseDir, args.MaterialYaml);
+    ResolvePath(baseDir, args.MaterialTable);
+    ResolvePath(baseDir, args.TextureIndex);
+    ResolvePath(baseDir, args.Skin);
+    ResolvePath(baseDir, args.Animation);
+    ResolvePath(baseDir, args.Mapped);
+    ResolvePath(baseDir, args.Shadow);
+    ResolvePath(baseDir, args.Option.EmbeddedTextureDir);
+    ResolvePath(baseDir, args.TexOption.OutputDir);
+}
+
+//-----------------------------------------------------------------------------
+//      出力パスの "{name}" を置換します.
+//-----------------------------------------------------------------------------
+void ExpandPaths(const std::string& name, ConvertArgs& args)
+{
+    ExpandPath(name, args.Output);
+    ExpandPath(name, args.MaterialYaml);
+    ExpandPath(name, args.MaterialTable);
+    ExpandPath(name, args.TextureIndex);
+    ExpandPath(name, args.Skin);
+    ExpandPath(name, args.Animation);
+    ExpandPath(name, args.Mapped);
+    ExpandPath(name, args.Shadow);
+    ExpandPath(name, args.Option.EmbeddedTextureDir);
+    ExpandPath(name, args.TexOption.OutputDir);
+}
+
+//-----------------------------------------------------------------------------
+//      モデルごとの出力ファイルパスを取得します.
+//-----------------------------------------------------------------------------
+void GetOutputPaths(const ConvertArgs& args, std::vector<std::string>& paths)
+{
+    const std::string* kPaths[] = {
+        &args.Output,
+        &args.Mapped,
+        &args.MaterialYaml,
+        &args.MaterialTable,
+        &args.TextureIndex,
+        &args.Skin,
+        &args.Animation,
+        &args.Shadow,
+    };
+
+    paths.clear();
+    for(auto pPath : kPaths)
+    {
+        if (!pPath->empty())
+        { paths.push_back(*pPath); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      複数のモデルを変換できる出力パスかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool ValidateNamedOutputs(const ConvertArgs& args)
+{
+    std::vector<std::string> outputs;
+    GetOutputPaths(args, outputs);
+    if (outputs.empty())
+    {
+        ELOGA("Error : Output Path Not Specified.");
+        return false;
+    }
+
+    for(auto& path : outputs)
+    {
+        if (path.find("{name}") == std::string::npos)
+        {
+            ELOGA("Error : Output Path Must Contain {name}. path = %s", path.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      モデルを変換します.
+//-----------------------------------------------------------------------------
+bool Convert(const ConvertArgs& args, ConvertStats* pStats)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    auto countMesh = [pStats](const asdx::ResMesh& mesh)
+    {
+        if (pStats == nullptr)
+        { return; }
+
+        pStats->MeshCount++;
+        pStats->VertexCount    += mesh.Positions.size();
+        pStats->PrimitiveCount += mesh.Primitives.size();
+        pStats->MeshletCount   += uint32_t(mesh.Meshlets.size());
+    };
+
+    // 逐次出力する場合は構築したメッシュを保持しない.
+    // シャドウメッシュとスキニングデータはメッシュごとに蓄積されるため，併用するとメモリ上限を守れない.
+    auto option = args.Option;
+    MappedModelWriter writer;
+    if (args.Stream)
+    {
+        if (args.Mapped.empty() || !args.Output.empty())
+        {
+            ELOGA("Error : -stream requires -mapped and cannot be used with -o.");
+            return false;
+        }
+
+        if (!args.Shadow.empty() || !args.Skin.empty())
+        {
+            ELOGA("Error : -stream cannot be used with -shadow or -skin.");
+            return false;
+        }
+
+        if (!writer.Open(args.Mapped.c_str(), args.MappedOption))
+        {
+            ELOGA("Error : MappedModelWriter::Open() Failed. path = %s", args.Mapped.c_str());
+            return false;
+        }
+
+        option.MeshOutput = [&](asdx::ResMesh& mesh)
+        {
+            countMesh(mesh);
+            return writer.Append(mesh);
+        };
+    }
+
+    asdx::ResModel model;
+    MeshLoader loader;
+    if (!loader.Load(args.Input.c_str(), model, option))
+    {
+        ELOGA("Error : MeshLoader::Load() Failed. path = %s", args.Input.c_str());
+        return false;
+    }
+
+    if (args.Stream)
+    {
+        auto meshCount = writer.GetMeshCount();
+        if (writer.Close())
+        { ILOGA("Info : Mapped Model Save OK! output path = %s, meshes = %u", args.Mapped.c_str(), meshCount); }
+        else
+        {
+            ELOGA("Error : MappedModelWriter::Close() Failed. path = %s", args.Mapped.c_str());
+            return false;
+        }
+    }
+
+    if (pStats != nullptr)
+    {
+        pStats->MaterialCount = uint32_t(loader.GetMaterials().size());
+        pStats->TextureCount  = uint32_t(loader.GetTextures().size());
+        for(auto& mesh : model.Meshes)
+        { countMesh(mesh); }
+        for(auto& shadow : loader.GetShadowMeshes())
+        { pStats->ShadowVertexCount += shadow.Positions.size(); }
+    }
+
+    // テクスチャ変換はモデル等の出力と並行して行う.
+    auto texOption = args.TexOption;
+    TextureConverter texConverter;
+    auto textures = &loader.GetTextures();
+    if (!texOption.OutputDir.empty())
+    {
+        auto pos = args.Input.find_last_of("/\\");
+        if (pos != std::string::npos)
+        { texOption.InputDir = args.Input.substr(0, pos); }
+
+        if (!texConverter.Begin(loader.GetMaterials(), loader.GetTextures(), texOption))
+        {
+            ELOGA("Error : TextureConverter::Begin() Failed.");
+            return false;
+        }
+        textures = &texConverter.GetTextures();
+    }
+
+    if (!args.Skin.empty())
+    {
+        if (loader.GetSkins().empty())
+        {
+            ELOGA("Error : Skinned Mesh Not Found. path = %s", args.Input.c_str());
+            return false;
+        }
+
+        if (ExportSkin(args.Skin.c_str(), loader.GetSkins()))
+        { ILOGA("Info : Skin Save OK! output path = %s", args.Skin.c_str()); }
+        else
+        {
+            ELOGA("Error : ExportSkin() Failed. path = %s", args.Skin.c_str());
+            return false;
+        }
+    }
+
+    if (!args.Animation.empty())
+    {
+        if (ExportAnimation(args.Animation.c_str(), loader.GetSkeleton(), loader.GetAnimations()))
+        { ILOGA("Info : Animation Save OK! output path = %s", args.Animation.c_str()); }
+        else
+        {
+            ELOGA("Error : ExportAnimation() Failed. path = %s", args.Animation.c_str());
+            return false;
+        }
+    }
+
+    if (!args.Shadow.empty())
+    {
+        if (args.Option.MeasureTime)
+        {
+            size_t vertexCount = 0;
+            size_t shadowCount = 0;
+            for(auto& mesh : model.Meshes)
+            {
+                if (mesh.BoneIndices.empty())
+                { vertexCount += mesh.Positions.size(); }
+            }
+            for(auto& shadow : loader.GetShadowMeshes())
+            { shadowCount += shadow.Positions.size(); }
+            ILOGA("Info : [Shadow] vertex count = %zu -> %zu", vertexCount, shadowCount);
+        }
+
+        if (ExportShadow(args.Shadow.c_str(), loader.GetShadowMeshes()))
+        { ILOGA("Info : Shadow Save OK! output path = %s", args.Shadow.c_str()); }
+        else
+        {
+            ELOGA("Error : ExportShadow() Failed. path = %s", args.Shadow.c_str());
+            return false;
+        }
+    }
+
+    // メモリマップ形式のみ出力する場合は従来形式を省略できる.
+    if (!args.Output.empty() || args.Mapped.empty())
+    {
+        if (!asdx::SaveModel(args.Output.c_str(), model))
+        {
+            ELOGA("Error : SaveModel() Fialed. path = %s", args.Output.c_str());
+            return false;
+        }
+
+        ILOGA("Info : Model Save OK! output path = %s", args.Output.c_str());
+    }
+
+    if (!args.Mapped.empty() && !args.Stream)
+    {
+        // 選択したレイアウトでの頂点フェッチ効率を確認できるようにする.
+        if (args.Option.MeasureTime && !args.MappedOption.VertexLayout.empty())
+        {
+            for(auto& mesh : model.Meshes)
+            {
+                auto layout = GetVertexLayout(mesh, args.MappedOption.VertexLayout);
+                ILOGA("Info : [Fetch] mesh = 0x%08x, position overfetch = %.3f, vertex(stride = %u) overfetch = %.3f",
+                    mesh.MeshHash,
+                    AnalyzeVertexFetch(mesh, sizeof(mesh.Positions[0])),
+                    layout.Stride,
+                    AnalyzeVertexFetch(mesh, layout.Stride));
+            }
+        }
+
+        if (ExportMappedModel(args.Mapped.c_str(), model, args.MappedOption))
+        { ILOGA("Info : Mapped Model Save OK! output path = %s", args.Mapped.c_str()); }
+        else
+        {
+            ELOGA("Error : ExportMappedModel() Failed. path = %s", args.Mapped.c_str());
+            return false;
+        }
+    }
+
+    // マテリアルは変換結果のパスを参照するので完了を待つ.
+    if (!texOption.OutputDir.empty())
+    {
+        auto failed = texConverter.End();
+        if (pStats != nullptr)
+        { pStats->FailedTextureCount = uint32_t(failed); }
+        if (failed > 0)
+        { ELOGA("Error : Texture Convert Failed. count = %zu", failed); }
+        else
+        { ILOGA("Info : Texture Convert OK! output dir = %s", texOption.OutputDir.c_str()); }
+    }
+
+    if (!args.MaterialYaml.empty())
+    {
+       if (ExportMaterialYaml(args.MaterialYaml.c_str(), loader.GetMaterials(), *textures))
+       { ILOGA("Info : Material Save OK! output path = %s", args.MaterialYaml.c_str()); }
+       else
+       {
+           ELOGA("Error : ExportMaterialYaml() Failed. path = %s", args.MaterialYaml.c_str());
+           return false;
+       }
+    }
+
+    if (!args.MaterialTable.empty())
+    {
+        if (ExportMaterialTable(args.MaterialTable.c_str(), loader.GetMaterials(), *textures))
+        { ILOGA("Info : Material Table Save OK! output path = %s", args.MaterialTable.c_str()); }
+        else
+        {
+            ELOGA("Error : ExportMaterialTable() Failed. path = %s", args.MaterialTable.c_str());
+            return false;
+        }
+    }
+
+    if (!args.TextureIndex.empty())
+    {
+        if (ExportTextureIndex(args.TextureIndex.c_str(), *textures))
+        { ILOGA("Info : Texture Index Save OK! output path = %s", args.TextureIndex.c_str()); }
+        else
+        {
+            ELOGA("Error : ExportTextureIndex() Failed. path = %s", args.TextureIndex.c_str());
+            return false;
+        }
+    }
+
+    if (pStats != nullptr)
+    {
+        auto end = std::chrono::steady_clock::now();
+        pStats->ElapsedMsec = std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      メモリ上のファイルイメージを変換します.
+//-----------------------------------------------------------------------------
+CONVERT_RESULT ConvertMemory
+(
+    const void*             pData,
+    size_t                  size,
+    const char*             name,
+    const MeshLoaderOption& option,
+    ConvertOutput&          output
+)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    output = ConvertOutput();
+
+    MeshLoader loader;
+    if (!loader.Load(pData, size, name, output.Model, option))
+    {
+        if (loader.IsCanceled())
+        { return CONVERT_RESULT_CANCELED; }
+
+        ELOGA("Error : MeshLoader::Load() Failed. name = %s", (name != nullptr) ? name : "");
+        return CONVERT_RESULT_FAILED;
+    }
+
+    if (option.Progress && !option.Progress(PROGRESS_STAGE_EXPORT, 0, 1))
+    { return CONVERT_RESULT_CANCELED; }
+
+    output.Materials    = loader.GetMaterials();
+    output.Textures     = loader.GetTextures();
+    output.Skins        = loader.GetSkins();
+    output.Bones        = loader.GetSkeleton();
+    output.Animations   = loader.GetAnimations();
+    output.ShadowMeshes = loader.GetShadowMeshes();
+
+    BuildMaterialTable(output.Materials, output.Textures, output.MaterialTable);
+    BuildSkinData(output.Skins, output.SkinData);
+    BuildAnimationData(output.Bones, output.Animations, output.AnimationData);
+    BuildShadowData(output.ShadowMeshes, output.ShadowData);
+
+    auto& stats = output.Stats;
+    stats.MeshCount     = uint32_t(output.Model.Meshes.size());
+    stats.MaterialCount = uint32_t(output.Materials.size());
+    stats.TextureCount  = uint32_t(output.Textures.size());
+    for(auto& mesh : output.Model.Meshes)
+    {
+        stats.VertexCount    += mesh.Positions.size();
+        stats.PrimitiveCount += mesh.Primitives.size();
+        stats.MeshletCount   += uint32_t(mesh.Meshlets.size());
+    }
+    for(auto& shadow : output.ShadowMeshes)
+    { stats.ShadowVertexCount += shadow.Positions.size(); }
+
+    if (option.Progress)
+    { option.Progress(PROGRESS_STAGE_EXPORT, 1, 1); }
+
+    auto end = std::chrono::steady_clock::now();
+    stats.ElapsedMsec = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    return CONVERT_RESULT_OK;
+}
\ No newline at end of file
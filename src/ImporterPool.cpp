@@ -0,0 +1,122 @@
+﻿//-----------------------------------------------------------------------------
+// File : ImporterPool.cpp
+// Desc : Assimp Importer Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ImporterPool.h>
+#include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ImporterPool::Progress class
+///////////////////////////////////////////////////////////////////////////////
+class ImporterPool::Progress : public Assimp::ProgressHandler
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      進捗を更新します. false を返却すると読み込みを中断します.
+    //-------------------------------------------------------------------------
+    bool Update(float percentage) override
+    { return (m_Callback) ? m_Callback(percentage) : true; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      転送先のコールバックを設定します.
+    //-------------------------------------------------------------------------
+    void SetCallback(std::function<bool(float)> callback)
+    { m_Callback = std::move(callback); }
+
+private:
+    std::function<bool(float)>  m_Callback;     //!< 転送先のコールバックです.
+};
+
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ImporterPool::ImporterPool()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ImporterPool::~ImporterPool()
+{
+    // 進捗ハンドラーはインポーターが解放する.
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Free     .clear();
+    m_Progress .clear();
+    m_Importers.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      インポーターを取得します.
+//-----------------------------------------------------------------------------
+Assimp::Importer* ImporterPool::Acquire()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        if (!m_Free.empty())
+        {
+            auto pImporter = m_Free.back();
+            m_Free.pop_back();
+            return pImporter;
+        }
+    }
+
+    // ローダーの登録に時間がかかるのでロック外で生成する.
+    std::unique_ptr<Assimp::Importer> importer(new Assimp::Importer());
+    auto pImporter = importer.get();
+
+    // 進捗ハンドラーはインポーターの破棄時に解放されるので，差し替えずに使い回す.
+    auto pProgress = new Progress();
+    pImporter->SetProgressHandler(pProgress);
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Importers.push_back(std::move(importer));
+    m_Progress[pImporter] = pProgress;
+    return pImporter;
+}
+
+//-----------------------------------------------------------------------------
+//      インポーターを返却します.
+//-----------------------------------------------------------------------------
+void ImporterPool::Release(Assimp::Importer* pImporter)
+{
+    if (pImporter == nullptr)
+    { return; }
+
+    pImporter->FreeScene();
+
+    // コールバックは呼び出し元を参照しているので外しておく.
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Progress[pImporter]->SetCallback(nullptr);
+    m_Free.push_back(pImporter);
+}
+
+//-----------------------------------------------------------------------------
+//      進捗コールバックを設定します.
+//-----------------------------------------------------------------------------
+void ImporterPool::SetProgress(Assimp::Importer* pImporter, std::function<bool(float)> callback)
+{
+    if (pImporter == nullptr)
+    { return; }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    auto itr = m_Progress.find(pImporter);
+    if (itr != m_Progress.end())
+    { itr->second->SetCallback(std::move(callback)); }
+}
+
+//-----------------------------------------------------------------------------
+//      生成したインポーター数を取得します.
+//-----------------------------------------------------------------------------
+size_t ImporterPool::GetCount() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_Importers.size();
+}
\ No newline at end of file
@@ -0,0 +1,591 @@
+﻿//-----------------------------------------------------------------------------
+// File : MappedModel.cpp
+// Desc : Memory Mappable Model Format.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <MappedModel.h>
+#include <asdxLogger.h>
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      配置境界に切り上げます.
+//-----------------------------------------------------------------------------
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+//-----------------------------------------------------------------------------
+//      UTF-8文字列をワイド文字列に変換します.
+//-----------------------------------------------------------------------------
+std::wstring ToWide(const char* value)
+{
+    auto length = MultiByteToWideChar(CP_UTF8, 0, value, -1, nullptr, 0);
+    if (length <= 0)
+    { return std::wstring(); }
+
+    std::wstring result(size_t(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value, -1, &result[0], length);
+    result.resize(size_t(length - 1));
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// StreamSource structure
+///////////////////////////////////////////////////////////////////////////////
+struct StreamSource
+{
+    const void* pData;      //!< 先頭アドレスです.
+    size_t      Size;       //!< サイズ(バイト)です.
+};
+
+//-----------------------------------------------------------------------------
+//      配列をストリームにします.
+//-----------------------------------------------------------------------------
+template<typename T>
+StreamSource ToStream(const std::vector<T>& values)
+{ return StreamSource{ values.data(), values.size() * sizeof(T) }; }
+
+//-----------------------------------------------------------------------------
+//      メッシュのストリームを取得します.
+//-----------------------------------------------------------------------------
+void GetStreams
+(
+    const asdx::ResMesh&        mesh,
+    const std::vector<uint8_t>& vertices,
+    uint32_t                    vertexMask,
+    bool                        separate,
+    StreamSource                (&streams)[MAPPED_STREAM_COUNT]
+)
+{
+    streams[MAPPED_STREAM_POSITION]      = ToStream(mesh.Positions);
+    streams[MAPPED_STREAM_TANGENT_SPACE] = ToStream(mesh.TangentSpaces);
+    streams[MAPPED_STREAM_COLOR]         = ToStream(mesh.Colors);
+    streams[MAPPED_STREAM_TEXCOORD0]     = ToStream(mesh.TexCoords[0]);
+    streams[MAPPED_STREAM_TEXCOORD1]     = ToStream(mesh.TexCoords[1]);
+    streams[MAPPED_STREAM_TEXCOORD2]     = ToStream(mesh.TexCoords[2]);
+    streams[MAPPED_STREAM_TEXCOORD3]     = ToStream(mesh.TexCoords[3]);
+    streams[MAPPED_STREAM_BONE_INDEX]    = ToStream(mesh.BoneIndices);
+    streams[MAPPED_STREAM_BONE_WEIGHT]   = ToStream(mesh.BoneWeights);
+    streams[MAPPED_STREAM_INDEX]         = ToStream(mesh.Indices);
+    streams[MAPPED_STREAM_PRIMITIVE]     = ToStream(mesh.Primitives);
+    streams[MAPPED_STREAM_MESHLET]       = ToStream(mesh.Meshlets);
+    streams[MAPPED_STREAM_CULLING_INFO]  = ToStream(mesh.CullingInfos);
+    streams[MAPPED_STREAM_VERTEX]        = ToStream(vertices);
+
+    if (separate)
+    { return; }
+
+    // インターリーブした属性は個別ストリームから除外する.
+    static const MAPPED_STREAM kStreams[VERTEX_ATTRIBUTE_COUNT] = {
+        MAPPED_STREAM_TANGENT_SPACE,
+        MAPPED_STREAM_COLOR,
+        MAPPED_STREAM_TEXCOORD0,
+        MAPPED_STREAM_TEXCOORD1,
+        MAPPED_STREAM_TEXCOORD2,
+        MAPPED_STREAM_TEXCOORD3,
+        MAPPED_STREAM_BONE_INDEX,
+        MAPPED_STREAM_BONE_WEIGHT,
+    };
+
+    for(auto i=0; i<VERTEX_ATTRIBUTE_COUNT; ++i)
+    {
+        if ((vertexMask & (0x1u << i)) != 0)
+        { streams[kStreams[i]] = StreamSource{ nullptr, 0 }; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュレコードを初期化します.
+//-----------------------------------------------------------------------------
+void InitRecord
+(
+    const asdx::ResMesh&    mesh,
+    const VertexLayout&     layout,
+    MappedMeshRecord&       record
+)
+{
+    memset(&record, 0, sizeof(record));
+
+    record.MeshHash     = mesh.MeshHash;
+    record.MaterialHash = mesh.MatrerialHash;
+    record.VertexCount  = uint32_t(mesh.Positions.size());
+    record.VertexStride = layout.Stride;
+    record.VertexMask   = layout.Mask;
+    memcpy(record.VertexOffsets, layout.Offsets, sizeof(record.VertexOffsets));
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルヘッダを生成します.
+//-----------------------------------------------------------------------------
+MappedModelHeader MakeHeader
+(
+    uint32_t    meshCount,
+    uint32_t    alignment,
+    uint64_t    meshOffset,
+    uint64_t    fileSize
+)
+{
+    MappedModelHeader header = {};
+    header.Magic[0]   = 'M';
+    header.Magic[1]   = 'M';
+    header.Magic[2]   = 'D';
+    header.Magic[3]   = '\0';
+    header.Version    = kMappedModelVersion;
+    header.MeshCount  = meshCount;
+    header.Alignment  = alignment;
+    header.MeshOffset = meshOffset;
+    header.FileSize   = fileSize;
+    return header;
+}
+
+//-----------------------------------------------------------------------------
+//      配置境界を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetAlignment(const MappedModelOption& option)
+{
+    auto alignment = option.Alignment;
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    { alignment = kMappedModelAlignment; }
+    return alignment;
+}
+
+} // namespace /* anonymous */
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{ Close(); }
+
+//-----------------------------------------------------------------------------
+//      ファイルを読み取り専用でメモリにマップします.
+//-----------------------------------------------------------------------------
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    auto hFile = CreateFileW(
+        ToWide(path).c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        ELOGA("Error : File Open Failed. path = %s", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+    {
+        ELOGA("Error : Invalid File Size. path = %s", path);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapping == nullptr)
+    {
+        ELOGA("Error : CreateFileMapping() Failed. path = %s", path);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (pData == nullptr)
+    {
+        ELOGA("Error : MapViewOfFile() Failed. path = %s", path);
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_hFile    = hFile;
+    m_hMapping = hMapping;
+    m_pData    = pData;
+    m_Size     = size_t(size.QuadPart);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      マップを解除します.
+//-----------------------------------------------------------------------------
+void MappedFile::Close()
+{
+    if (m_pData != nullptr)
+    {
+        UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+
+    if (m_hMapping != nullptr)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+    }
+
+    if (m_hFile != nullptr)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = nullptr;
+    }
+
+    m_Size = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      先頭アドレスを取得します.
+//-----------------------------------------------------------------------------
+const void* MappedFile::GetData() const
+{ return m_pData; }
+
+//-----------------------------------------------------------------------------
+//      サイズを取得します.
+//-----------------------------------------------------------------------------
+size_t MappedFile::GetSize() const
+{ return m_Size; }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MappedModelWriter class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MappedModelWriter::~MappedModelWriter()
+{
+    if (m_pFile != nullptr)
+    {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      出力ファイルを開きます.
+//-----------------------------------------------------------------------------
+bool MappedModelWriter::Open(const char* path, const MappedModelOption& option)
+{
+    if (m_pFile != nullptr)
+    {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+
+    auto err = fopen_s(&m_pFile, path, "wb");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", path);
+        m_pFile = nullptr;
+        return false;
+    }
+
+    m_Option    = option;
+    m_Alignment = GetAlignment(option);
+    m_Offset    = 0;
+    m_Failed    = false;
+    m_Records.clear();
+
+    // ヘッダは Close() で書き戻すまでゼロにしておき，途中で終わったファイルを無効にする.
+    return Write(nullptr, sizeof(MappedModelHeader));
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュのストリームを追記します.
+//-----------------------------------------------------------------------------
+bool MappedModelWriter::Append(const asdx::ResMesh& mesh)
+{
+    if (m_pFile == nullptr || m_Failed)
+    { return false; }
+
+    std::vector<uint8_t> vertices;
+    auto layout = GetVertexLayout(mesh, m_Option.VertexLayout);
+    BuildInterleavedVertices(mesh, layout, vertices);
+
+    MappedMeshRecord record;
+    InitRecord(mesh, layout, record);
+
+    StreamSource streams[MAPPED_STREAM_COUNT];
+    GetStreams(mesh, vertices, layout.Mask, m_Option.SeparateStreams, streams);
+
+    for(auto i=0; i<MAPPED_STREAM_COUNT; ++i)
+    {
+        if (streams[i].Size == 0)
+        { continue; }
+
+        if (!Write(nullptr, AlignUp(m_Offset, m_Alignment) - m_Offset))
+        { return false; }
+
+        record.Streams[i].Offset = m_Offset;
+        record.Streams[i].Size   = streams[i].Size;
+        record.StreamMask |= (0x1u << i);
+
+        if (!Write(streams[i].pData, streams[i].Size))
+        { return false; }
+    }
+
+    m_Records.push_back(record);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュレコードを末尾に書き出し，ヘッダを確定させて閉じます.
+//-----------------------------------------------------------------------------
+bool MappedModelWriter::Close()
+{
+    if (m_pFile == nullptr)
+    { return false; }
+
+    // メッシュ数は最後まで確定しないので，レコードはストリームの後ろに置く.
+    auto meshCount  = uint32_t(m_Records.size());
+    auto meshOffset = AlignUp(m_Offset, m_Alignment);
+    auto result     = Write(nullptr, meshOffset - m_Offset)
+                   && Write(m_Records.data(), sizeof(MappedMeshRecord) * meshCount)
+                   && Write(nullptr, AlignUp(m_Offset, m_Alignment) - m_Offset);
+
+    if (result)
+    {
+        auto header = MakeHeader(meshCount, m_Alignment, meshOffset, m_Offset);
+        result = fseek(m_pFile, 0, SEEK_SET) == 0
+              && fwrite(&header, sizeof(header), 1, m_pFile) == 1;
+    }
+
+    result = (fclose(m_pFile) == 0) && result;
+    m_pFile = nullptr;
+    m_Records.clear();
+    m_Records.shrink_to_fit();
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      追記したメッシュ数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t MappedModelWriter::GetMeshCount() const
+{ return uint32_t(m_Records.size()); }
+
+//-----------------------------------------------------------------------------
+//      データを書き込みます.
+//-----------------------------------------------------------------------------
+bool MappedModelWriter::Write(const void* pData, uint64_t size)
+{
+    if (m_Failed)
+    { return false; }
+
+    if (pData != nullptr)
+    {
+        if (fwrite(pData, 1, size_t(size), m_pFile) != size_t(size))
+        { m_Failed = true; }
+    }
+    else
+    {
+        static const uint8_t kZero[256] = {};
+        auto rest = size;
+        while(rest > 0 && !m_Failed)
+        {
+            auto count = size_t(std::min<uint64_t>(rest, sizeof(kZero)));
+            if (fwrite(kZero, 1, count, m_pFile) != count)
+            { m_Failed = true; }
+            rest -= count;
+        }
+    }
+
+    if (m_Failed)
+    {
+        ELOGA("Error : File Write Failed.");
+        return false;
+    }
+
+    m_Offset += size;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+//      モデルをメモリマップ可能な形式に変換します.
+//-----------------------------------------------------------------------------
+void BuildMappedModel
+(
+    const asdx::ResModel&       model,
+    const MappedModelOption&    option,
+    std::vector<uint8_t>&       data
+)
+{
+    auto alignment = GetAlignment(option);
+    auto meshCount = uint32_t(model.Meshes.size());
+
+    // インターリーブした頂点データはレイアウト確定時に構築しておく.
+    std::vector<std::vector<uint8_t>> vertices(meshCount);
+
+    // 先にレイアウトを確定させて1回で確保する.
+    std::vector<MappedMeshRecord> records(meshCount);
+    uint64_t offset = sizeof(MappedModelHeader) + sizeof(MappedMeshRecord) * meshCount;
+    for(auto i=0u; i<meshCount; ++i)
+    {
+        auto& mesh   = model.Meshes[i];
+        auto& record = records[i];
+
+        auto layout = GetVertexLayout(mesh, option.VertexLayout);
+        BuildInterleavedVertices(mesh, layout, vertices[i]);
+        InitRecord(mesh, layout, record);
+
+        StreamSource streams[MAPPED_STREAM_COUNT];
+        GetStreams(mesh, vertices[i], layout.Mask, option.SeparateStreams, streams);
+
+        for(auto j=0; j<MAPPED_STREAM_COUNT; ++j)
+        {
+            if (streams[j].Size == 0)
+            { continue; }
+
+            offset = AlignUp(offset, alignment);
+            record.Streams[j].Offset = offset;
+            record.Streams[j].Size   = streams[j].Size;
+            record.StreamMask |= (0x1u << j);
+            offset += streams[j].Size;
+        }
+    }
+
+    // 末尾もそろえておくとファイルを連結しても境界が崩れない.
+    auto fileSize = AlignUp(offset, alignment);
+    data.assign(size_t(fileSize), 0);
+
+    auto header = MakeHeader(meshCount, alignment, sizeof(MappedModelHeader), fileSize);
+    memcpy(data.data(), &header, sizeof(header));
+
+    if (meshCount > 0)
+    { memcpy(data.data() + header.MeshOffset, records.data(), sizeof(MappedMeshRecord) * meshCount); }
+
+    for(auto i=0u; i<meshCount; ++i)
+    {
+        StreamSource streams[MAPPED_STREAM_COUNT];
+        GetStreams(model.Meshes[i], vertices[i], records[i].VertexMask, option.SeparateStreams, streams);
+
+        for(auto j=0; j<MAPPED_STREAM_COUNT; ++j)
+        {
+            if (streams[j].Size == 0)
+            { continue; }
+
+            memcpy(data.data() + records[i].Streams[j].Offset, streams[j].pData, streams[j].Size);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      モデルをメモリマップ可能な形式でファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportMappedModel
+(
+    const char*                 path,
+    const asdx::ResModel&       model,
+    const MappedModelOption&    option
+)
+{
+    std::vector<uint8_t> data;
+    BuildMappedModel(model, option, data);
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "wb");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", path);
+        return false;
+    }
+
+    auto size = fwrite(data.data(), 1, data.size(), pFile);
+    fclose(pFile);
+    return size == data.size();
+}
+
+//-----------------------------------------------------------------------------
+//      メモリマップ可能なモデルを検証します.
+//-----------------------------------------------------------------------------
+const MappedModelHeader* GetMappedModel(const void* pData, size_t size)
+{
+    if (pData == nullptr || size < sizeof(MappedModelHeader))
+    { return nullptr; }
+
+    auto pHeader = static_cast<const MappedModelHeader*>(pData);
+    if (pHeader->Magic[0] != 'M'
+     || pHeader->Magic[1] != 'M'
+     || pHeader->Magic[2] != 'D'
+     || pHeader->Magic[3] != '\0')
+    { return nullptr; }
+
+    if (pHeader->Version != kMappedModelVersion || pHeader->FileSize > size)
+    { return nullptr; }
+
+    auto alignment = uint64_t(pHeader->Alignment);
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    { return nullptr; }
+
+    auto recordSize = uint64_t(sizeof(MappedMeshRecord)) * pHeader->MeshCount;
+    if (pHeader->MeshOffset > pHeader->FileSize || recordSize > pHeader->FileSize - pHeader->MeshOffset)
+    { return nullptr; }
+
+    auto pMeshes = GetMappedMeshes(pHeader);
+    for(auto i=0u; i<pHeader->MeshCount; ++i)
+    {
+        for(auto j=0; j<MAPPED_STREAM_COUNT; ++j)
+        {
+            auto& stream = pMeshes[i].Streams[j];
+            if (stream.Size == 0)
+            { continue; }
+
+            if ((stream.Offset & (alignment - 1)) != 0
+             || stream.Offset > pHeader->FileSize
+             || stream.Size   > pHeader->FileSize - stream.Offset)
+            { return nullptr; }
+        }
+
+        // インターリーブした頂点データはストライドと頂点数に一致する必要がある.
+        auto& vertex = pMeshes[i].Streams[MAPPED_STREAM_VERTEX];
+        if (vertex.Size != uint64_t(pMeshes[i].VertexStride) * pMeshes[i].VertexCount)
+        { return nullptr; }
+    }
+
+    return pHeader;
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュレコードを取得します.
+//-----------------------------------------------------------------------------
+const MappedMeshRecord* GetMappedMeshes(const MappedModelHeader* pHeader)
+{
+    auto ptr = reinterpret_cast<const uint8_t*>(pHeader);
+    return reinterpret_cast<const MappedMeshRecord*>(ptr + pHeader->MeshOffset);
+}
+
+//-----------------------------------------------------------------------------
+//      ストリームの先頭アドレスを取得します.
+//-----------------------------------------------------------------------------
+const void* GetMappedStream
+(
+    const MappedModelHeader*    pHeader,
+    const MappedMeshRecord*     pMesh,
+    MAPPED_STREAM               stream
+)
+{
+    auto& entry = pMesh->Streams[stream];
+    if (entry.Size == 0)
+    { return nullptr; }
+
+    auto ptr = reinterpret_cast<const uint8_t*>(pHeader);
+    return ptr + entry.Offset;
+}
\ No newline at end of file
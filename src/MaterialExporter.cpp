@@ -0,0 +1,475 @@
+﻿//-----------------------------------------------------------------------------
+// File : MaterialExporter.cpp
+// Desc : Material Table Exporter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <MaterialExporter.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+
+namespace /* anonymous */ {
+
+///////////////////////////////////////////////////////////////////////////////
+// StringTable class
+///////////////////////////////////////////////////////////////////////////////
+class StringTable
+{
+public:
+    //-------------------------------------------------------------------------
+    //      文字列を追加し，オフセットを返却します. 同じ文字列は共有します.
+    //-------------------------------------------------------------------------
+    uint32_t Add(const std::string& value)
+    {
+        auto itr = m_Offsets.find(value);
+        if (itr != m_Offsets.end())
+        { return itr->second; }
+
+        auto offset = uint32_t(m_Data.size());
+        m_Data.insert(m_Data.end(), value.begin(), value.end());
+        m_Data.push_back('\0');
+        m_Offsets[value] = offset;
+        return offset;
+    }
+
+    //-------------------------------------------------------------------------
+    //      データを取得します.
+    //-------------------------------------------------------------------------
+    const std::vector<char>& GetData() const
+    { return m_Data; }
+
+private:
+    std::vector<char>                           m_Data;     //!< 文字列データです.
+    std::unordered_map<std::string, uint32_t>   m_Offsets;  //!< 文字列からオフセットへの対応表です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TextWriter class
+///////////////////////////////////////////////////////////////////////////////
+class TextWriter
+{
+public:
+    //-------------------------------------------------------------------------
+    //      書式を指定して追記します.
+    //-------------------------------------------------------------------------
+    void Print(const char* format, ...)
+    {
+        char buffer[1024];
+
+        va_list args;
+        va_start(args, format);
+        auto length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        if (length < 0)
+        { return; }
+
+        if (size_t(length) < sizeof(buffer))
+        {
+            m_Buffer.append(buffer, size_t(length));
+            return;
+        }
+
+        // 長い行はバッファを確保し直して書き込む.
+        std::string temp(size_t(length) + 1, '\0');
+        va_start(args, format);
+        vsnprintf(&temp[0], temp.size(), format, args);
+        va_end(args);
+        m_Buffer.append(temp.c_str(), size_t(length));
+    }
+
+    //-------------------------------------------------------------------------
+    //      ファイルに一括で書き込みます.
+    //-------------------------------------------------------------------------
+    bool Save(const char* path) const
+    {
+        FILE* pFile;
+        auto err = fopen_s(&pFile, path, "wb");
+        if (err != 0)
+        {
+            ELOGA("Error : File Open Failed. path = %s", path);
+            return false;
+        }
+
+        auto size = fwrite(m_Buffer.data(), 1, m_Buffer.size(), pFile);
+        fclose(pFile);
+        return size == m_Buffer.size();
+    }
+
+private:
+    std::string m_Buffer;   //!< 書き込みバッファです.
+};
+
+//-----------------------------------------------------------------------------
+//      値を追記します.
+//-----------------------------------------------------------------------------
+template<typename T>
+void Append(std::vector<uint8_t>& data, const T* pValues, size_t count)
+{
+    auto size = sizeof(T) * count;
+    auto offset = data.size();
+    data.resize(offset + size);
+    if (size > 0)
+    { memcpy(&data[offset], pValues, size); }
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリデータをファイルに書き込みます.
+//-----------------------------------------------------------------------------
+bool WriteBinary(const char* path, const std::vector<uint8_t>& data)
+{
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "wb");
+    if (err != 0)
+    {
+        ELOGA("Error : File Open Failed. path = %s", path);
+        return false;
+    }
+
+    auto size = fwrite(data.data(), 1, data.size(), pFile);
+    fclose(pFile);
+    return size == data.size();
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルパスハッシュの昇順に並べたテクスチャを取得します.
+//-----------------------------------------------------------------------------
+std::vector<const TextureEntry*> SortTextures(const std::vector<TextureEntry>& textures)
+{
+    std::vector<const TextureEntry*> sorted(textures.size());
+    for(size_t i=0; i<textures.size(); ++i)
+    { sorted[i] = &textures[i]; }
+
+    std::sort(sorted.begin(), sorted.end(), [](const TextureEntry* lhs, const TextureEntry* rhs)
+    { return lhs->Id < rhs->Id; });
+
+    return sorted;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      テクスチャ用途を文字列にします.
+//-----------------------------------------------------------------------------
+const char* ToString(TEXTURE_USAGE usage)
+{
+    const char* table[] = {
+        "NONE",
+        "DIFFUSE",
+        "SPECULAR",
+        "AMBIENT",
+        "EMISSIVE",
+        "HEIGHT",
+        "NORMAL",
+        "SHININESS",
+        "OPACITY",
+        "DISPLACEMENT",
+        "LIGHTMAP",
+        "REFLECTION",
+        "UNKNOWN"
+    };
+
+    return table[usage];
+}
+
+//-----------------------------------------------------------------------------
+//      アルファモードを文字列にします.
+//-----------------------------------------------------------------------------
+const char* ToString(ALPHA_MODE mode)
+{
+    const char* table[] = {
+        "OPAQUE",
+        "MASK",
+        "BLEND"
+    };
+
+    return table[mode];
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアル情報をバイナリテーブルに変換します.
+//-----------------------------------------------------------------------------
+void BuildMaterialTable
+(
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures,
+    std::vector<uint8_t>&               data
+)
+{
+    // ハッシュで二分探索できるように並べ替える.
+    std::vector<const Material*> sorted(materials.size());
+    for(size_t i=0; i<materials.size(); ++i)
+    { sorted[i] = &materials[i]; }
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Material* lhs, const Material* rhs)
+    { return lhs->Hash < rhs->Hash; });
+
+    StringTable                         strings;
+    std::vector<TexturePathRecord>      paths;
+    std::unordered_map<uint32_t, uint32_t> pathOffsets;
+
+    // テクスチャパスは1回だけ格納する.
+    paths.reserve(textures.size());
+    for(auto pTexture : SortTextures(textures))
+    {
+        TexturePathRecord path;
+        path.Id         = pTexture->Id;
+        path.PathOffset = strings.Add(pTexture->Path);
+        paths.push_back(path);
+
+        pathOffsets[path.Id] = path.PathOffset;
+    }
+
+    std::vector<MaterialRecord>         records;
+    std::vector<MaterialTextureRecord>  refs;
+    records.reserve(sorted.size());
+
+    for(auto pMaterial : sorted)
+    {
+        MaterialRecord record = {};
+        record.Hash         = pMaterial->Hash;
+        record.NameOffset   = strings.Add(pMaterial->Name);
+        record.TextureIndex = uint32_t(refs.size());
+        record.TextureCount = uint32_t(pMaterial->Textures.size());
+        record.Features     = pMaterial->Features;
+        record.AlphaMode    = uint32_t(pMaterial->AlphaMode);
+        record.BaseColor[0] = pMaterial->BaseColor.x;
+        record.BaseColor[1] = pMaterial->BaseColor.y;
+        record.BaseColor[2] = pMaterial->BaseColor.z;
+        record.BaseColor[3] = pMaterial->BaseColor.w;
+        record.Emissive[0]  = pMaterial->Emissive.x;
+        record.Emissive[1]  = pMaterial->Emissive.y;
+        record.Emissive[2]  = pMaterial->Emissive.z;
+        record.Metallic     = pMaterial->Metallic;
+        record.Roughness    = pMaterial->Roughness;
+        record.AlphaCutoff  = pMaterial->AlphaCutoff;
+        record.UVScale[0]   = pMaterial->UVScale.x;
+        record.UVScale[1]   = pMaterial->UVScale.y;
+        record.UVOffset[0]  = pMaterial->UVOffset.x;
+        record.UVOffset[1]  = pMaterial->UVOffset.y;
+        record.UVRotation   = pMaterial->UVRotation;
+        records.push_back(record);
+
+        for(auto& tex : pMaterial->Textures)
+        {
+            MaterialTextureRecord ref;
+            ref.Usage      = uint32_t(tex.Usage);
+            ref.PathId     = tex.PathId;
+            ref.PathOffset = pathOffsets[tex.PathId];
+            refs.push_back(ref);
+        }
+    }
+
+    const auto& stringData = strings.GetData();
+
+    MaterialTableHeader header = {};
+    header.Magic[0]         = 'M';
+    header.Magic[1]         = 'T';
+    header.Magic[2]         = 'B';
+    header.Magic[3]         = '\0';
+    header.Version          = kMaterialTableVersion;
+    header.MaterialCount    = uint32_t(records.size());
+    header.TextureCount     = uint32_t(refs.size());
+    header.PathCount        = uint32_t(paths.size());
+    header.MaterialOffset   = uint32_t(sizeof(header));
+    header.TextureOffset    = header.MaterialOffset + uint32_t(sizeof(MaterialRecord) * records.size());
+    header.PathOffset       = header.TextureOffset  + uint32_t(sizeof(MaterialTextureRecord) * refs.size());
+    header.StringOffset     = header.PathOffset     + uint32_t(sizeof(TexturePathRecord) * paths.size());
+    header.StringSize       = uint32_t(stringData.size());
+
+    data.clear();
+    data.reserve(header.StringOffset + header.StringSize);
+    Append(data, &header, 1);
+    Append(data, records.data(), records.size());
+    Append(data, refs.data(), refs.size());
+    Append(data, paths.data(), paths.size());
+    Append(data, stringData.data(), stringData.size());
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアル情報をバイナリファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportMaterialTable
+(
+    const char*                         path,
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures
+)
+{
+    std::vector<uint8_t> data;
+    BuildMaterialTable(materials, textures, data);
+    return WriteBinary(path, data);
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアル情報をYAMLファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportMaterialYaml
+(
+    const char*                         path,
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures
+)
+{
+    std::unordered_map<uint32_t, const TextureEntry*> lookup;
+    for(auto& texture : textures)
+    { lookup[texture.Id] = &texture; }
+
+    TextWriter writer;
+    writer.Print("# Materials\n");
+
+    for(size_t i=0; i<materials.size(); ++i)
+    {
+        auto& mat = materials[i];
+        writer.Print("- name: %s\n", mat.Name.c_str());
+        writer.Print("  hash: %u\n", mat.Hash);
+        writer.Print("  content_hash: %u\n", mat.ContentHash);
+        writer.Print("  features: 0x%08x\n", mat.Features);
+        writer.Print("  base_color: [%f, %f, %f, %f]\n", mat.BaseColor.x, mat.BaseColor.y, mat.BaseColor.z, mat.BaseColor.w);
+        writer.Print("  emissive: [%f, %f, %f]\n", mat.Emissive.x, mat.Emissive.y, mat.Emissive.z);
+        writer.Print("  metallic: %f\n", mat.Metallic);
+        writer.Print("  roughness: %f\n", mat.Roughness);
+        writer.Print("  alpha_mode: %s\n", ToString(mat.AlphaMode));
+        writer.Print("  alpha_cutoff: %f\n", mat.AlphaCutoff);
+        writer.Print("  two_sided: %s\n", mat.TwoSided ? "true" : "false");
+        writer.Print("  uv_scale: [%f, %f]\n", mat.UVScale.x, mat.UVScale.y);
+        writer.Print("  uv_offset: [%f, %f]\n", mat.UVOffset.x, mat.UVOffset.y);
+        writer.Print("  uv_rotation: %f\n", mat.UVRotation);
+
+        if (mat.Textures.size() > 0)
+        {
+            writer.Print("  textures:\n");
+            for(size_t j=0; j<mat.Textures.size(); ++j)
+            {
+                auto& tex = mat.Textures[j];
+                auto itr  = lookup.find(tex.PathId);
+                writer.Print("    - usage: %s\n", ToString(tex.Usage));
+                writer.Print("      id: %u\n", tex.PathId);
+                writer.Print("      path: %s\n", (itr != lookup.end()) ? itr->second->Path.c_str() : "");
+            }
+        }
+        writer.Print("\n");
+    }
+
+    return writer.Save(path);
+}
+
+//-----------------------------------------------------------------------------
+//      テクスチャの依存関係をバイナリファイルに出力します.
+//-----------------------------------------------------------------------------
+bool ExportTextureIndex(const char* path, const std::vector<TextureEntry>& textures)
+{
+    StringTable                     strings;
+    std::vector<TextureIndexRecord> records;
+    std::vector<uint32_t>           references;
+    records.reserve(textures.size());
+
+    for(auto pTexture : SortTextures(textures))
+    {
+        TextureIndexRecord record;
+        record.Id            = pTexture->Id;
+        record.PathOffset    = strings.Add(pTexture->Path);
+        record.MaterialIndex = uint32_t(references.size());
+        record.MaterialCount = uint32_t(pTexture->Materials.size());
+        references.insert(references.end(), pTexture->Materials.begin(), pTexture->Materials.end());
+
+        record.MeshIndex     = uint32_t(references.size());
+        record.MeshCount     = uint32_t(pTexture->Meshes.size());
+        references.insert(references.end(), pTexture->Meshes.begin(), pTexture->Meshes.end());
+
+        records.push_back(record);
+    }
+
+    const auto& stringData = strings.GetData();
+
+    TextureIndexHeader header = {};
+    header.Magic[0]         = 'T';
+    header.Magic[1]         = 'D';
+    header.Magic[2]         = 'X';
+    header.Magic[3]         = '\0';
+    header.Version          = kTextureIndexVersion;
+    header.TextureCount     = uint32_t(records.size());
+    header.ReferenceCount   = uint32_t(references.size());
+    header.TextureOffset    = uint32_t(sizeof(header));
+    header.ReferenceOffset  = header.TextureOffset   + uint32_t(sizeof(TextureIndexRecord) * records.size());
+    header.StringOffset     = header.ReferenceOffset + uint32_t(sizeof(uint32_t) * references.size());
+    header.StringSize       = uint32_t(stringData.size());
+
+    std::vector<uint8_t> data;
+    data.reserve(header.StringOffset + header.StringSize);
+    Append(data, &header, 1);
+    Append(data, records.data(), records.size());
+    Append(data, references.data(), references.size());
+    Append(data, stringData.data(), stringData.size());
+
+    return WriteBinary(path, data);
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアルテーブルを検証します.
+//-----------------------------------------------------------------------------
+const MaterialTableHeader* GetMaterialTable(const void* pData, size_t size)
+{
+    if (pData == nullptr || size < sizeof(MaterialTableHeader))
+    { return nullptr; }
+
+    auto pHeader = static_cast<const MaterialTableHeader*>(pData);
+    if (memcmp(pHeader->Magic, "MTB", 4) != 0 || pHeader->Version != kMaterialTableVersion)
+    { return nullptr; }
+
+    // 各ブロックがデータ内に収まっているか確認.
+    auto materialEnd = uint64_t(pHeader->MaterialOffset) + uint64_t(pHeader->MaterialCount) * sizeof(MaterialRecord);
+    auto textureEnd  = uint64_t(pHeader->TextureOffset)  + uint64_t(pHeader->TextureCount)  * sizeof(MaterialTextureRecord);
+    auto pathEnd     = uint64_t(pHeader->PathOffset)     + uint64_t(pHeader->PathCount)     * sizeof(TexturePathRecord);
+    auto stringEnd   = uint64_t(pHeader->StringOffset)   + uint64_t(pHeader->StringSize);
+    if (materialEnd > size || textureEnd > size || pathEnd > size || stringEnd > size)
+    { return nullptr; }
+
+    return pHeader;
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアルレコードを二分探索します.
+//-----------------------------------------------------------------------------
+const MaterialRecord* FindMaterialRecord(const MaterialTableHeader* pHeader, uint32_t hash)
+{
+    auto pBase  = reinterpret_cast<const uint8_t*>(pHeader);
+    auto pFirst = reinterpret_cast<const MaterialRecord*>(pBase + pHeader->MaterialOffset);
+    auto pLast  = pFirst + pHeader->MaterialCount;
+
+    auto pFound = std::lower_bound(pFirst, pLast, hash, [](const MaterialRecord& record, uint32_t value)
+    { return record.Hash < value; });
+
+    if (pFound == pLast || pFound->Hash != hash)
+    { return nullptr; }
+
+    return pFound;
+}
+
+//-----------------------------------------------------------------------------
+//      テクスチャレコードを取得します.
+//-----------------------------------------------------------------------------
+const MaterialTextureRecord* GetTextureRecords(const MaterialTableHeader* pHeader, const MaterialRecord* pRecord)
+{
+    auto pBase = reinterpret_cast<const uint8_t*>(pHeader);
+    return reinterpret_cast<const MaterialTextureRecord*>(pBase + pHeader->TextureOffset) + pRecord->TextureIndex;
+}
+
+//-----------------------------------------------------------------------------
+//      文字列テーブルから文字列を取得します.
+//-----------------------------------------------------------------------------
+const char* GetTableString(const MaterialTableHeader* pHeader, uint32_t offset)
+{
+    auto pBase = reinterpret_cast<const char*>(pHeader);
+    return pBase + pHeader->StringOffset + offset;
+}
\ No newline at end of file
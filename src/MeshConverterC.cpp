@@ -0,0 +1,240 @@
+﻿//-----------------------------------------------------------------------------
+// File : MeshConverterC.cpp
+// Desc : C Interface.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <MeshConverterC.h>
+#include <Converter.h>
+#include <assimp/postprocess.h>
+#include <new>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MC_RESULT structure
+///////////////////////////////////////////////////////////////////////////////
+struct MC_RESULT
+{
+    ConvertOutput   Output;     //!< 変換結果です.
+};
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      配列の先頭アドレスを取得します. 空の場合は nullptr を返却します.
+//-----------------------------------------------------------------------------
+template<typename T>
+const T* GetData(const std::vector<T>& values)
+{ return values.empty() ? nullptr : values.data(); }
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      変換設定を既定値で初期化します.
+//-----------------------------------------------------------------------------
+void mcGetDefaultConvertDesc(MC_CONVERT_DESC* pDesc)
+{
+    if (pDesc == nullptr)
+    { return; }
+
+    MeshLoaderOption option;
+    pDesc->Profile              = uint32_t(option.Profile);
+    pDesc->EnableFlags          = option.EnableFlags;
+    pDesc->DisableFlags         = option.DisableFlags;
+    pDesc->SkinInfluenceCount   = option.SkinInfluenceCount;
+    pDesc->SkinWeightFormat     = uint32_t(option.SkinWeightFormat);
+    pDesc->BonePaletteSize      = option.BonePaletteSize;
+    pDesc->MaxFaceCount         = option.MaxFaceCount;
+    pDesc->ParseAnimation       = option.ParseAnimation ? 1 : 0;
+    pDesc->MergeMeshes          = option.MergeMeshes    ? 1 : 0;
+    pDesc->MergeMaterials       = option.MergeMaterials ? 1 : 0;
+    pDesc->GenerateShadowMesh   = option.GenerateShadowMesh ? 1 : 0;
+    pDesc->pProgress            = nullptr;
+    pDesc->pUser                = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      メモリ上のファイルイメージを変換します.
+//-----------------------------------------------------------------------------
+int mcConvertMemory
+(
+    const void*             pData,
+    size_t                  size,
+    const char*             name,
+    const MC_CONVERT_DESC*  pDesc,
+    MC_RESULT**             ppResult
+)
+{
+    if (pData == nullptr || size == 0 || name == nullptr || ppResult == nullptr)
+    { return MC_ERROR_INVALID_ARG; }
+
+    *ppResult = nullptr;
+
+    MC_CONVERT_DESC desc;
+    if (pDesc != nullptr)
+    { desc = *pDesc; }
+    else
+    { mcGetDefaultConvertDesc(&desc); }
+
+    if (desc.SkinInfluenceCount < 1 || desc.SkinInfluenceCount > 8 || desc.BonePaletteSize > 256)
+    { return MC_ERROR_INVALID_ARG; }
+
+    MeshLoaderOption option;
+    option.Profile              = IMPORT_PROFILE(desc.Profile);
+    option.EnableFlags          = desc.EnableFlags;
+    option.DisableFlags         = desc.DisableFlags;
+    option.SkinInfluenceCount   = desc.SkinInfluenceCount;
+    option.SkinWeightFormat     = SKIN_WEIGHT_FORMAT(desc.SkinWeightFormat);
+    option.BonePaletteSize      = desc.BonePaletteSize;
+    option.MaxFaceCount         = desc.MaxFaceCount;
+    option.ParseAnimation       = (desc.ParseAnimation != 0);
+    option.MergeMeshes          = (desc.MergeMeshes    != 0);
+    option.MergeMaterials       = (desc.MergeMaterials != 0);
+    option.GenerateShadowMesh   = (desc.GenerateShadowMesh != 0);
+
+    // コマンドラインの -anim と同様に，既定プロファイルのままならスキンメッシュ向けに切り替える.
+    if (option.ParseAnimation)
+    {
+        if (option.Profile == IMPORT_PROFILE_DEFAULT)
+        { option.Profile = IMPORT_PROFILE_SKINNED; }
+
+        auto flag = GetImportFlags(option.Profile);
+        flag |= option.EnableFlags;
+        flag &= ~option.DisableFlags;
+        if (flag & aiProcess_PreTransformVertices)
+        { return MC_ERROR_INVALID_ARG; }
+    }
+
+    if (desc.pProgress != nullptr)
+    {
+        auto pProgress = desc.pProgress;
+        auto pUser     = desc.pUser;
+        option.Progress = [pProgress, pUser](PROGRESS_STAGE stage, uint32_t done, uint32_t total)
+        { return pProgress(pUser, uint32_t(stage), done, total) != 0; };
+    }
+
+    auto pResult = new (std::nothrow) MC_RESULT();
+    if (pResult == nullptr)
+    { return MC_ERROR_FAILED; }
+
+    // C の呼び出し元に例外を伝播させない.
+    CONVERT_RESULT ret;
+    try
+    { ret = ConvertMemory(pData, size, name, option, pResult->Output); }
+    catch(...)
+    { ret = CONVERT_RESULT_FAILED; }
+
+    if (ret != CONVERT_RESULT_OK)
+    {
+        delete pResult;
+        return (ret == CONVERT_RESULT_CANCELED) ? MC_ERROR_CANCELED : MC_ERROR_FAILED;
+    }
+
+    *ppResult = pResult;
+    return MC_OK;
+}
+
+//-----------------------------------------------------------------------------
+//      変換結果を解放します.
+//-----------------------------------------------------------------------------
+void mcReleaseResult(MC_RESULT* pResult)
+{ delete pResult; }
+
+//-----------------------------------------------------------------------------
+//      メッシュ数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t mcGetMeshCount(const MC_RESULT* pResult)
+{
+    if (pResult == nullptr)
+    { return 0; }
+
+    return uint32_t(pResult->Output.Model.Meshes.size());
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュデータを参照します.
+//-----------------------------------------------------------------------------
+int mcGetMesh(const MC_RESULT* pResult, uint32_t index, MC_MESH_VIEW* pView)
+{
+    if (pResult == nullptr || pView == nullptr || index >= pResult->Output.Model.Meshes.size())
+    { return MC_ERROR_INVALID_ARG; }
+
+    auto& mesh = pResult->Output.Model.Meshes[index];
+
+    pView->MeshHash             = mesh.MeshHash;
+    pView->MaterialHash         = mesh.MatrerialHash;
+    pView->VertexCount          = uint32_t(mesh.Positions.size());
+    pView->IndexCount           = uint32_t(mesh.Indices.size());
+    pView->PrimitiveCount       = uint32_t(mesh.Primitives.size());
+    pView->MeshletCount         = uint32_t(mesh.Meshlets.size());
+    pView->PrimitiveStride      = uint32_t(sizeof(asdx::ResPrimitive));
+    pView->MeshletStride        = uint32_t(sizeof(asdx::ResMeshlet));
+    pView->CullingInfoStride    = uint32_t(sizeof(asdx::ResCullingInfo));
+    pView->pPositions           = reinterpret_cast<const float*>(GetData(mesh.Positions));
+    pView->pTangentSpaces       = GetData(mesh.TangentSpaces);
+    pView->pColors              = GetData(mesh.Colors);
+    for(auto i=0; i<4; ++i)
+    { pView->pTexCoords[i] = GetData(mesh.TexCoords[i]); }
+    pView->pBoneIndices         = reinterpret_cast<const uint16_t*>(GetData(mesh.BoneIndices));
+    pView->pBoneWeights         = reinterpret_cast<const float*>(GetData(mesh.BoneWeights));
+    pView->pIndices             = GetData(mesh.Indices);
+    pView->pPrimitives          = GetData(mesh.Primitives);
+    pView->pMeshlets            = GetData(mesh.Meshlets);
+    pView->pCullingInfos        = GetData(mesh.CullingInfos);
+
+    return MC_OK;
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリデータを参照します.
+//-----------------------------------------------------------------------------
+int mcGetBlob(const MC_RESULT* pResult, uint32_t type, const void** ppData, size_t* pSize)
+{
+    if (pResult == nullptr || ppData == nullptr || pSize == nullptr)
+    { return MC_ERROR_INVALID_ARG; }
+
+    const std::vector<uint8_t>* pBlob = nullptr;
+    switch(type)
+    {
+    case MC_BLOB_MATERIAL_TABLE:
+        pBlob = &pResult->Output.MaterialTable;
+        break;
+
+    case MC_BLOB_SKIN:
+        pBlob = &pResult->Output.SkinData;
+        break;
+
+    case MC_BLOB_ANIMATION:
+        pBlob = &pResult->Output.AnimationData;
+        break;
+
+    case MC_BLOB_SHADOW:
+        pBlob = &pResult->Output.ShadowData;
+        break;
+
+    default:
+        return MC_ERROR_INVALID_ARG;
+    }
+
+    *ppData = GetData(*pBlob);
+    *pSize  = pBlob->size();
+    return MC_OK;
+}
+
+//-----------------------------------------------------------------------------
+//      モデルをファイルに保存します.
+//-----------------------------------------------------------------------------
+int mcSaveModel(const MC_RESULT* pResult, const char* path)
+{
+    if (pResult == nullptr || path == nullptr)
+    { return MC_ERROR_INVALID_ARG; }
+
+    if (!asdx::SaveModel(path, pResult->Output.Model))
+    { return MC_ERROR_FAILED; }
+
+    return MC_OK;
+}
\ No newline at end of file
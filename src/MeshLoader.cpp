@@ -8,448 +8,1920 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <MeshLoader.h>
+#include <TangentGenerator.h>
+#include <SkinPacker.h>
+#include <ImporterPool.h>
+#include <ParallelFor.h>
 #include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/pbrmaterial.h>
 #include <assimp/cimport.h>
 #include <codecvt>
 #include <cassert>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <string>
 #include <meshoptimizer.h>
 #include <asdxHash.h>
+#include <asdxLogger.h>
 
 
-//-----------------------------------------------------------------------------
-//      コンストラクタです.
-//-----------------------------------------------------------------------------
-MeshLoader::MeshLoader()
-: m_pScene(nullptr)
-{ /* DO_NOTHING */ }
+namespace /* anonymous */ {
 
-//-----------------------------------------------------------------------------
-//      デストラクタです.
-//-----------------------------------------------------------------------------
-MeshLoader::~MeshLoader()
-{ /* DO_NOTHING */ }
+///////////////////////////////////////////////////////////////////////////////
+// PostProcessStep structure
+///////////////////////////////////////////////////////////////////////////////
+struct PostProcessStep
+{
+    const char*     Name;       //!< ステップ名です.
+    uint32_t        Flag;       //!< ポストプロセスフラグです.
+};
 
 //-----------------------------------------------------------------------------
-//      メッシュをロードします.
+// Constant Values.
 //-----------------------------------------------------------------------------
-bool MeshLoader::Load(const char* filename, asdx::ResModel& model)
+
+// 1メッシュあたりの最大三角形数.
+// メッシュレットの頂点インデックス数は最悪で三角形数の3倍になるため，
+// ResMeshlet のオフセットと頂点インデックスが32bitに収まるように制限する.
+static const size_t kMaxFaceCount = UINT32_MAX / 3;
+
+// ボーンパレットの最大サイズ(8bitで参照できる範囲).
+static const size_t kMaxBonePaletteSize = 256;
+
+// メッシュレットの最大頂点数と最大プリミティブ数.
+// see. https://developer.nvidia.com/blog/introduction-turing-mesh-shaders/
+static const size_t kMeshletMaxVertices   = 64;
+static const size_t kMeshletMaxPrimitives = 126;
+
+// メッシュレットを空間分割して並列に構築する三角形数の閾値と，1区画あたりの三角形数.
+// 区画の境界では端数のメッシュレットが出来るので，区画は十分大きくしておく.
+static const size_t kParallelMeshletFaceCount   = 1 << 18;
+static const size_t kMeshletPartitionFaceCount  = 1 << 16;
+
+// Assimpの内部実行順に並べたポストプロセスステップ.
+static const PostProcessStep kPostProcessSteps[] = {
+    { "ValidateDataStructure",      aiProcess_ValidateDataStructure     },
+    { "MakeLeftHanded",             aiProcess_MakeLeftHanded            },
+    { "FlipUVs",                    aiProcess_FlipUVs                   },
+    { "FlipWindingOrder",           aiProcess_FlipWindingOrder          },
+    { "RemoveComponent",            aiProcess_RemoveComponent           },
+    { "RemoveRedundantMaterials",   aiProcess_RemoveRedundantMaterials  },
+    { "FindInstances",              aiProcess_FindInstances             },
+    { "OptimizeGraph",              aiProcess_OptimizeGraph             },
+    { "OptimizeMeshes",             aiProcess_OptimizeMeshes            },
+    { "FindDegenerates",            aiProcess_FindDegenerates           },
+    { "GenUVCoords",                aiProcess_GenUVCoords               },
+    { "TransformUVCoords",          aiProcess_TransformUVCoords         },
+    { "PreTransformVertices",       aiProcess_PreTransformVertices      },
+    { "Triangulate",                aiProcess_Triangulate               },
+    { "SortByPType",                aiProcess_SortByPType               },
+    { "FindInvalidData",            aiProcess_FindInvalidData           },
+    { "FixInfacingNormals",         aiProcess_FixInfacingNormals        },
+    { "SplitByBoneCount",           aiProcess_SplitByBoneCount          },
+    { "SplitLargeMeshes",           aiProcess_SplitLargeMeshes          },
+    { "GenNormals",                 aiProcess_GenNormals                },
+    { "GenSmoothNormals",           aiProcess_GenSmoothNormals          },
+    { "CalcTangentSpace",           aiProcess_CalcTangentSpace          },
+    { "JoinIdenticalVertices",      aiProcess_JoinIdenticalVertices     },
+    { "Debone",                     aiProcess_Debone                    },
+    { "LimitBoneWeights",           aiProcess_LimitBoneWeights          },
+    { "ImproveCacheLocality",       aiProcess_ImproveCacheLocality      },
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// StageTimer class
+///////////////////////////////////////////////////////////////////////////////
+class StageTimer
 {
-    if (filename == nullptr)
-    { return false; }
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    StageTimer(bool enable, const char* tag)
+    : m_Enable  (enable)
+    , m_Tag     (tag)
+    , m_Start   (std::chrono::steady_clock::now())
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~StageTimer()
+    {
+        if (!m_Enable)
+        { return; }
 
-    Assimp::Importer importer;
-    unsigned int flag = 0;
-    flag |= aiProcess_Triangulate;
-    flag |= aiProcess_PreTransformVertices;
-    flag |= aiProcess_CalcTangentSpace;
-    flag |= aiProcess_GenSmoothNormals;
-    flag |= aiProcess_GenUVCoords;
-    flag |= aiProcess_RemoveRedundantMaterials;
-    flag |= aiProcess_OptimizeMeshes;
+        auto end  = std::chrono::steady_clock::now();
+        auto msec = std::chrono::duration<double, std::milli>(end - m_Start).count();
+        ILOGA("Info : [Time] %-24s : %10.3f msec", m_Tag, msec);
+    }
 
-    // ファイルを読み込み.
-    m_pScene = importer.ReadFile(filename, flag);
+private:
+    bool                                    m_Enable;   //!< 計測するならtrue.
+    const char*                             m_Tag;      //!< ステージ名です.
+    std::chrono::steady_clock::time_point   m_Start;    //!< 開始時刻です.
+};
 
-    // チェック.
-    if (m_pScene == nullptr)
-    { return false; }
+//-----------------------------------------------------------------------------
+//      Assimp の進捗を百分率に変換します.
+//-----------------------------------------------------------------------------
+uint32_t ToProgress(float percentage)
+{
+    // 進捗が不明な場合は負の値が渡される.
+    return uint32_t(std::max(0.0f, std::min(percentage, 1.0f)) * 100.0f);
+}
 
-    // メッシュデータを変換.
-    for(auto i=0u; i<m_pScene->mNumMeshes; ++i)
+///////////////////////////////////////////////////////////////////////////////
+// ImportProgress class
+///////////////////////////////////////////////////////////////////////////////
+class ImportProgress : public Assimp::ProgressHandler
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    explicit ImportProgress(std::function<bool(uint32_t)> callback)
+    : m_Callback(std::move(callback))
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      進捗を更新します. false を返却すると読み込みを中断します.
+    //-------------------------------------------------------------------------
+    bool Update(float percentage) override
+    { return m_Callback(ToProgress(percentage)); }
+
+private:
+    std::function<bool(uint32_t)>   m_Callback;     //!< 進捗(0～100)を受け取るコールバックです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ScopedImporter class
+///////////////////////////////////////////////////////////////////////////////
+class ScopedImporter
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //!
+    //! @param[in]      pPool       取得元です. nullptr の場合は新たに生成します.
+    //-------------------------------------------------------------------------
+    explicit ScopedImporter(ImporterPool* pPool)
+    : m_pPool    (pPool)
+    , m_pImporter((pPool != nullptr) ? pPool->Acquire() : new Assimp::Importer())
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ScopedImporter()
     {
-        const auto pMesh = m_pScene->mMeshes[i];
-        ParseMesh(model, pMesh);
+        if (m_pPool != nullptr)
+        { m_pPool->Release(m_pImporter); }
+        else
+        { delete m_pImporter; }
     }
-    model.Meshes.shrink_to_fit();
 
-    // マテリアルデータを変換.
-    for(auto i=0u; i<m_pScene->mNumMaterials; ++i)
+    //-------------------------------------------------------------------------
+    //! @brief      インポーターを取得します.
+    //-------------------------------------------------------------------------
+    Assimp::Importer& Get()
+    { return *m_pImporter; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      進捗コールバックを設定します.
+    //!
+    //! @param[in]      callback    進捗(0～100)を受け取るコールバックです.
+    //-------------------------------------------------------------------------
+    void SetProgress(std::function<bool(uint32_t)> callback)
     {
-        const auto pMaterial = m_pScene->mMaterials[i];
-        ParseMaterial(pMaterial);
+        // プールのインポーターは登録済みの進捗ハンドラーに転送させる.
+        // 差し替えると以前のハンドラーが解放されずに残る.
+        if (m_pPool != nullptr)
+        {
+            m_pPool->SetProgress(m_pImporter, [callback](float percentage)
+            { return callback(ToProgress(percentage)); });
+        }
+        else
+        {
+            // インポーターが破棄を行う.
+            m_pImporter->SetProgressHandler(new ImportProgress(std::move(callback)));
+        }
     }
-    m_Materials.shrink_to_fit();
 
-    // 不要になったのでクリア.
-    importer.FreeScene();
-    m_pScene = nullptr;
+private:
+    ImporterPool*       m_pPool;        //!< 取得元です.
+    Assimp::Importer*   m_pImporter;    //!< インポーターです.
 
-    // 正常終了.
-    return true;
+    ScopedImporter  (const ScopedImporter&) = delete;
+    void operator = (const ScopedImporter&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+//      頂点ストリームを再マッピングします.
+//-----------------------------------------------------------------------------
+template<typename T>
+void RemapStream(std::vector<T>& stream, const uint32_t* pRemap, size_t vertexCount)
+{
+    if (stream.empty())
+    { return; }
+
+    meshopt_remapVertexBuffer(
+        stream.data(),
+        stream.data(),
+        stream.size(),
+        sizeof(T),
+        pRemap);
+
+    stream.resize(vertexCount);
+    stream.shrink_to_fit();
 }
 
 //-----------------------------------------------------------------------------
-//      静的メッシュデータを解析します.
+//      任意のストライドを持つ頂点ストリームを再マッピングします.
 //-----------------------------------------------------------------------------
-void MeshLoader::ParseMesh(asdx::ResModel& model, const aiMesh* pSrcMesh)
+void RemapStream(std::vector<uint8_t>& stream, size_t stride, const uint32_t* pRemap, size_t vertexCount)
 {
-    // マテリアル番号を設定.
-    auto matId = pSrcMesh->mMaterialIndex;
-    uint32_t matHash = matId;
+    if (stream.empty())
+    { return; }
+
+    meshopt_remapVertexBuffer(
+        stream.data(),
+        stream.data(),
+        stream.size() / stride,
+        stride,
+        pRemap);
+
+    stream.resize(vertexCount * stride);
+    stream.shrink_to_fit();
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュの全頂点ストリームを再マッピングします.
+//-----------------------------------------------------------------------------
+void RemapVertexStreams(asdx::ResMesh& mesh, const uint32_t* pRemap, size_t vertexCount)
+{
+    RemapStream(mesh.Positions,     pRemap, vertexCount);
+    RemapStream(mesh.TangentSpaces, pRemap, vertexCount);
+    RemapStream(mesh.Colors,        pRemap, vertexCount);
+    for(auto i=0; i<4; ++i)
+    { RemapStream(mesh.TexCoords[i], pRemap, vertexCount); }
+    RemapStream(mesh.BoneIndices,   pRemap, vertexCount);
+    RemapStream(mesh.BoneWeights,   pRemap, vertexCount);
+}
+
+//-----------------------------------------------------------------------------
+//      作業メモリの目安内で一度に処理できる最大三角形数を見積もります.
+//-----------------------------------------------------------------------------
+size_t EstimateFaceLimit(const aiMesh* pSrcMesh, size_t budget)
+{
+    if (budget == 0)
+    { return SIZE_MAX; }
 
-    // マテリアルハッシュ生成.
+    // 1頂点あたりの作業メモリ(一時ストリームを含む).
+    size_t bytesPerVertex = sizeof(asdx::Vector3) + sizeof(uint32_t);
+    if (pSrcMesh->HasNormals())
+    { bytesPerVertex += sizeof(asdx::Vector3) + sizeof(asdx::Vector2) + sizeof(uint32_t); }
+    for(auto i=0; i<4; ++i)
     {
-        auto pMaterial = m_pScene->mMaterials[matId];
-        aiString matName;
-        if (pMaterial->Get(AI_MATKEY_NAME, matName) == AI_SUCCESS)
-        { matHash = asdx::Fnv1a(matName.C_Str()).GetHash(); }
+        if (pSrcMesh->HasTextureCoords(i))
+        { bytesPerVertex += sizeof(uint32_t); }
     }
+    if (pSrcMesh->HasVertexColors(0))
+    { bytesPerVertex += sizeof(uint32_t); }
+    if (pSrcMesh->HasBones())
+    { bytesPerVertex += sizeof(asdx::ResBoneIndex) + sizeof(asdx::Vector4); }
 
-    asdx::ResMesh dstMesh;
-    dstMesh.MeshHash        = asdx::Fnv1a(pSrcMesh->mName.C_Str()).GetHash();
-    dstMesh.MatrerialHash   = matHash;
+    // 1三角形あたりの作業メモリ(インデックス, 頂点マップ, メッシュレット出力).
+    size_t bytesPerFace = sizeof(uint32_t) * 3 * 3
+                        + sizeof(asdx::ResPrimitive)
+                        + sizeof(uint32_t) * 3;
+
+    // 頂点数は三角形数を超えないと仮定して見積もる.
+    auto limit = budget / (bytesPerVertex + bytesPerFace);
+    return std::max<size_t>(limit, 1);
+}
 
+//-----------------------------------------------------------------------------
+//      3次元モートン符号を求めます.
+//-----------------------------------------------------------------------------
+uint32_t EncodeMorton3(uint32_t x, uint32_t y, uint32_t z)
+{
+    auto part = [](uint32_t v)
+    {
+        v &= 0x000003ff;
+        v = (v ^ (v << 16)) & 0xff0000ff;
+        v = (v ^ (v <<  8)) & 0x0300f00f;
+        v = (v ^ (v <<  4)) & 0x030c30c3;
+        v = (v ^ (v <<  2)) & 0x09249249;
+        return v;
+    };
+
+    return (part(x) << 2) | (part(y) << 1) | part(z);
+}
 
-    aiVector3D zero3D(0.0f, 0.0f, 0.0f);
-    aiColor4D  white (1.0f, 1.0f, 1.0f, 1.0f);
+//-----------------------------------------------------------------------------
+//      三角形を空間分割してチャンクに振り分けます.
+//
+//      三角形は重心が属するグリッドセルで一意にチャンクへ割り当てるため，
+//      境界の頂点は各チャンクに同じ値で複製され，継ぎ目に隙間は生じません.
+//-----------------------------------------------------------------------------
+void PartitionFaces
+(
+    const aiMesh*           pSrcMesh,
+    size_t                  faceLimit,
+    std::vector<uint32_t>&  faces,
+    std::vector<size_t>&    offsets
+)
+{
+    const size_t kMaxResolution = 64;   // 1軸あたりの最大セル数.
 
-    // 頂点データのメモリを確保.
-    dstMesh.Positions.resize(pSrcMesh->mNumVertices);
-    if (pSrcMesh->HasNormals())
-    { dstMesh.TangentSpaces.resize(pSrcMesh->mNumVertices); }
+    auto faceCount = size_t(pSrcMesh->mNumFaces);
 
-    for(auto i=0; i<4; ++i)
+    // バウンディングボックスを求める.
+    aiVector3D mini = pSrcMesh->mVertices[0];
+    aiVector3D maxi = pSrcMesh->mVertices[0];
+    for(auto i=1u; i<pSrcMesh->mNumVertices; ++i)
     {
-        if (pSrcMesh->HasTextureCoords(i))
-        { dstMesh.TexCoords[i].resize(pSrcMesh->mNumVertices); }
+        const auto& p = pSrcMesh->mVertices[i];
+        mini.x = std::min(mini.x, p.x); maxi.x = std::max(maxi.x, p.x);
+        mini.y = std::min(mini.y, p.y); maxi.y = std::max(maxi.y, p.y);
+        mini.z = std::min(mini.z, p.z); maxi.z = std::max(maxi.z, p.z);
     }
 
-    if (pSrcMesh->HasVertexColors(0))
-    { dstMesh.Colors.resize(pSrcMesh->mNumVertices); }
+    // 1セルあたり数チャンク分に細かく分けてから連結する.
+    auto chunkCount = (faceCount + faceLimit - 1) / faceLimit;
+    size_t resolution = 1;
+    while(resolution < kMaxResolution && resolution * resolution * resolution < chunkCount * 8)
+    { resolution *= 2; }
 
-    if (pSrcMesh->HasBones())
+    auto cellCount = resolution * resolution * resolution;
+    auto scale = [&](float value, float lo, float hi)
+    {
+        auto extent = hi - lo;
+        if (extent <= 0.0f)
+        { return 0u; }
+        auto cell = uint32_t((value - lo) / extent * float(resolution));
+        return std::min(cell, uint32_t(resolution - 1));
+    };
+
+    auto getCell = [&](size_t face)
     {
-        dstMesh.BoneIndices.resize(pSrcMesh->mNumVertices);
-        dstMesh.BoneWeights.resize(pSrcMesh->mNumVertices);
+        const auto& f  = pSrcMesh->mFaces[face];
+        const auto& p0 = pSrcMesh->mVertices[f.mIndices[0]];
+        const auto& p1 = pSrcMesh->mVertices[f.mIndices[1]];
+        const auto& p2 = pSrcMesh->mVertices[f.mIndices[2]];
+
+        auto x = (p0.x + p1.x + p2.x) / 3.0f;
+        auto y = (p0.y + p1.y + p2.y) / 3.0f;
+        auto z = (p0.z + p1.z + p2.z) / 3.0f;
+
+        return EncodeMorton3(
+            scale(x, mini.x, maxi.x),
+            scale(y, mini.y, maxi.y),
+            scale(z, mini.z, maxi.z));
+    };
+
+    // セル毎の三角形数を数える.
+    std::vector<size_t> cellOffsets(cellCount + 1, 0);
+    for(size_t i=0; i<faceCount; ++i)
+    { cellOffsets[getCell(i) + 1]++; }
+
+    for(size_t i=0; i<cellCount; ++i)
+    { cellOffsets[i + 1] += cellOffsets[i]; }
+
+    // モートン順に並べる(計数ソート).
+    faces.resize(faceCount);
+    {
+        std::vector<size_t> cursor(cellOffsets.begin(), cellOffsets.end() - 1);
+        for(size_t i=0; i<faceCount; ++i)
+        { faces[cursor[getCell(i)]++] = uint32_t(i); }
     }
 
-    for(auto i=0u; i<pSrcMesh->mNumVertices; ++i)
-    {
-        auto pPosition  = &(pSrcMesh->mVertices[i]);
-        dstMesh.Positions[i] = asdx::Vector3(pPosition->x, pPosition->y, pPosition->z);
+    // 上限を超えない範囲で隣接セルを連結してチャンクにする.
+    BuildChunkOffsets(cellOffsets, faceLimit, offsets);
+}
 
-        if (pSrcMesh->HasNormals() && pSrcMesh->HasTangentsAndBitangents())
-        {
-            auto pNormal = &(pSrcMesh->mNormals[i]);
-            auto pTangent = &(pSrcMesh->mTangents[i]);
+//-----------------------------------------------------------------------------
+//      参照するボーンがパレットに収まるように三角形を分割します.
+//-----------------------------------------------------------------------------
+void PartitionFacesByBones
+(
+    const aiMesh*                       pSrcMesh,
+    const PackedSkin&                   skin,
+    size_t                              boneCount,
+    size_t                              paletteSize,
+    size_t                              faceLimit,
+    std::vector<uint32_t>&              faces,
+    std::vector<size_t>&                offsets,
+    std::vector<std::vector<uint16_t>>& palettes
+)
+{
+    const auto count = skin.InfluenceCount;
 
-            auto N = asdx::Vector3(pNormal->x, pNormal->y, pNormal->z);
-            auto T = asdx::Vector3(pTangent->x, pTangent->y, pTangent->z);
+    std::vector<uint8_t>  used(boneCount, 0);
+    std::vector<uint16_t> palette;
+    std::vector<uint16_t> pending;
+    palette.reserve(paletteSize);
+    pending.reserve(count * 3);
 
-            dstMesh.TangentSpaces[i] = EncodeTBN(N, T, 0);
-        }
+    // 三角形の順番は維持する.
+    faces.resize(pSrcMesh->mNumFaces);
+    for(auto i=0u; i<pSrcMesh->mNumFaces; ++i)
+    { faces[i] = i; }
 
-        if (pSrcMesh->HasNormals() && !pSrcMesh->HasTangentsAndBitangents())
-        {
-            auto pNormal = &(pSrcMesh->mNormals[i]);
-            auto N = asdx::Vector3(pNormal->x, pNormal->y, pNormal->z);
-            asdx::Vector3 T, B;
-            asdx::CalcONB(N, T, B);
+    offsets.clear();
+    offsets.push_back(0);
 
-            dstMesh.TangentSpaces[i] = EncodeTBN(N, T, 0);
-        }
+    auto close = [&](size_t face)
+    {
+        for(auto bone : palette)
+        { used[bone] = 0; }
 
-        for(auto j=0; j<4; ++j)
+        offsets.push_back(face);
+        palettes.push_back(palette);
+        palette.clear();
+    };
+
+    for(size_t i=0; i<pSrcMesh->mNumFaces; ++i)
+    {
+        // この三角形で新たに必要になるボーンを列挙.
+        auto collect = [&]()
         {
-            if (pSrcMesh->HasTextureCoords(j))
+            pending.clear();
+            const auto& face = pSrcMesh->mFaces[i];
+            for(auto j=0u; j<3; ++j)
             {
-                auto pTexCorod = &(pSrcMesh->mTextureCoords[j][i]);
-                dstMesh.TexCoords[j][i] = asdx::EncodeHalf2(asdx::Vector2(pTexCorod->x, pTexCorod->y)).u;
+                auto v = face.mIndices[j];
+                for(auto k=0u; k<count; ++k)
+                {
+                    if (skin.BoneWeights[v * count + k] <= 0.0f)
+                    { continue; }
+
+                    auto bone = skin.BoneIndices[v * count + k];
+                    if (used[bone] == 0 && std::find(pending.begin(), pending.end(), bone) == pending.end())
+                    { pending.push_back(bone); }
+                }
             }
-        }
+        };
 
-        if (pSrcMesh->HasVertexColors(0))
+        collect();
+
+        // 収まらない場合は新しいグループを開始する.
+        if (palette.size() + pending.size() > paletteSize || i - offsets.back() >= faceLimit)
         {
-            auto pColor = &(pSrcMesh->mColors[0][i]);
-            dstMesh.Colors[i] = asdx::EncodeUnorm4(asdx::Vector4(pColor->r, pColor->g, pColor->b, pColor->a));
+            close(i);
+            collect();
         }
 
-        if (pSrcMesh->HasBones())
+        for(auto bone : pending)
         {
-            dstMesh.BoneIndices[i] = asdx::ResBoneIndex(0, 0, 0, 0);
-            dstMesh.BoneWeights[i] = asdx::Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+            used[bone] = 1;
+            palette.push_back(bone);
         }
     }
 
-    // ボーン番号と重みを設定する.
-    for(auto i=0u; i<pSrcMesh->mNumBones; ++i)
+    close(pSrcMesh->mNumFaces);
+}
+
+//-----------------------------------------------------------------------------
+//      接線空間をコンバータ側で生成する必要があるかどうか判定します.
+//-----------------------------------------------------------------------------
+bool NeedsTangentGeneration(const aiMesh* pSrcMesh)
+{
+    return pSrcMesh->HasNormals()
+        && !pSrcMesh->HasTangentsAndBitangents()
+        && pSrcMesh->HasTextureCoords(0);
+}
+
+//-----------------------------------------------------------------------------
+//      分割前の入力メッシュ全体で接線空間を生成します.
+//-----------------------------------------------------------------------------
+void GenerateSourceTangentSpaces(const aiMesh* pSrcMesh, std::vector<uint32_t>& tangentSpaces)
+{
+    const size_t kGrainSize = 4096;
+
+    auto vertexCount = size_t(pSrcMesh->mNumVertices);
+    auto faceCount   = size_t(pSrcMesh->mNumFaces);
+
+    // 分割しない場合と同様に重複除去してから累積する.
+    // 分割が必要なほど大きいメッシュなので，インデックスや頂点ストリームは複製せずに入力を直接参照する.
+    meshopt_Stream streams[3] = {};
+    streams[0].data   = pSrcMesh->mVertices;
+    streams[0].size   = sizeof(float) * 3;
+    streams[0].stride = sizeof(aiVector3D);
+    streams[1].data   = pSrcMesh->mNormals;
+    streams[1].size   = sizeof(float) * 3;
+    streams[1].stride = sizeof(aiVector3D);
+    streams[2].data   = pSrcMesh->mTextureCoords[0];
+    streams[2].size   = sizeof(float) * 2;
+    streams[2].stride = sizeof(aiVector3D);
+
+    std::vector<uint32_t> remap(vertexCount);
+    auto uniqueCount = meshopt_generateVertexRemapMulti(
+        remap.data(),
+        nullptr,
+        vertexCount,
+        vertexCount,
+        streams,
+        _countof(streams));
+
+    auto toVector3 = [](const aiVector3D& v) { return asdx::Vector3(v.x, v.y, v.z); };
+
+    // 三角形を1つずつ累積する. 三角形数は32bitに収まらないことがあるので size_t で数える.
+    TangentAccumulator accumulator;
+    accumulator.Init(uniqueCount);
+    for(size_t i=0; i<faceCount; ++i)
     {
-        for(auto j=0u; j<pSrcMesh->mBones[i]->mNumWeights; ++j)
+        const auto& face = pSrcMesh->mFaces[i];
+
+        uint32_t      slots    [3];
+        asdx::Vector3 positions[3];
+        asdx::Vector3 normals  [3];
+        asdx::Vector2 texcoords[3];
+        for(auto k=0; k<3; ++k)
         {
-            auto weight     = pSrcMesh->mBones[i]->mWeights[j];
-            auto srcBoneIndex  = uint16_t(i);
-            auto srcBoneWeight = weight.mWeight;
+            auto v = face.mIndices[k];
+            const auto& uv = pSrcMesh->mTextureCoords[0][v];
+            slots    [k] = remap[v];
+            positions[k] = toVector3(pSrcMesh->mVertices[v]);
+            normals  [k] = toVector3(pSrcMesh->mNormals[v]);
+            texcoords[k] = asdx::Vector2(uv.x, uv.y);
+        }
 
-            auto& dstBoneIndex = dstMesh.BoneIndices[weight.mVertexId];
-            auto& dstBoneWeight = dstMesh.BoneWeights[weight.mVertexId];
-            auto detect = false;
+        accumulator.AddFace(slots, positions, normals, texcoords);
+    }
 
-            if (dstBoneWeight.x == 0.0f)
-            {
-                dstBoneIndex.Index0 = srcBoneIndex;
-                dstBoneWeight.x     = srcBoneWeight;
-                detect = true;
-            }
-            else if (dstBoneWeight.y == 0.0f)
-            {
-                dstBoneIndex.Index1 = srcBoneIndex;
-                dstBoneWeight.y     = srcBoneWeight;
-                detect = true;
-            }
-            else if (dstBoneWeight.z == 0.0f)
-            {
-                dstBoneIndex.Index2 = srcBoneIndex;
-                dstBoneWeight.z     = srcBoneWeight;
-                detect = true;
-            }
-            else if (dstBoneWeight.w == 0.0f)
-            {
-                dstBoneIndex.Index3 = srcBoneIndex;
-                dstBoneWeight.z     = srcBoneWeight;
-                detect = true;
-            }
+    // 入力の頂点番号で引けるようにする. 重複除去した頂点は同じ結果になる.
+    tangentSpaces.resize(vertexCount);
+    ParallelFor(vertexCount, kGrainSize, [&](size_t begin, size_t end)
+    {
+        for(auto i=begin; i<end; ++i)
+        { tangentSpaces[i] = accumulator.Resolve(remap[i], toVector3(pSrcMesh->mNormals[i])); }
+    });
+}
 
-            // いっぱいだった場合は，重みが一番小さい所に入れる.
-            if (!detect)
-            {
-                auto mini = dstBoneWeight.x;
-                auto idx = 0;
-                if (mini > dstBoneWeight.y)
-                {
-                    mini = dstBoneWeight.y;
-                    idx = 1;
-                }
-                if (mini > dstBoneWeight.z)
-                {
-                    mini = dstBoneWeight.z;
-                    idx = 2;
-                }
-                if (mini > dstBoneWeight.w)
-                {
-                    mini = dstBoneWeight.w;
-                    idx = 3;
-                }
+//-----------------------------------------------------------------------------
+//      三角形を重心のモートン順に並べ替えます.
+//-----------------------------------------------------------------------------
+void SortTrianglesSpatially
+(
+    const std::vector<uint32_t>&        triangles,
+    const std::vector<asdx::Vector3>&   positions,
+    size_t                              partitionCount,
+    std::vector<uint32_t>&              sorted
+)
+{
+    const size_t kMaxResolution = 64;   // 1軸あたりの最大セル数.
+    const size_t kGrainSize     = 4096;
 
-                // 入力データの方が重みが小さい場合は処理しない.
-                if (mini > srcBoneWeight)
-                { continue; }
+    auto faceCount = triangles.size() / 3;
 
-                if (idx == 0)
-                {
-                    dstBoneIndex.Index0 = srcBoneIndex;
-                    dstBoneWeight.x     = srcBoneWeight;
-                }
-                else if (idx == 1)
-                {
-                    dstBoneIndex.Index1 = srcBoneIndex;
-                    dstBoneWeight.y     = srcBoneWeight;
-                }
-                else if (idx == 2)
-                {
-                    dstBoneIndex.Index2 = srcBoneIndex;
-                    dstBoneWeight.z     = srcBoneWeight;
-                }
-                else if (idx == 3)
-                {
-                    dstBoneIndex.Index3 = srcBoneIndex;
-                    dstBoneWeight.w     = srcBoneWeight;
-                }
-            }
-        }
+    // バウンディングボックスを求める.
+    auto mini = positions[0];
+    auto maxi = positions[0];
+    for(size_t i=1; i<positions.size(); ++i)
+    {
+        const auto& p = positions[i];
+        mini.x = std::min(mini.x, p.x); maxi.x = std::max(maxi.x, p.x);
+        mini.y = std::min(mini.y, p.y); maxi.y = std::max(maxi.y, p.y);
+        mini.z = std::min(mini.z, p.z); maxi.z = std::max(maxi.z, p.z);
     }
 
-    // 頂点インデックスのメモリを確保.
-    std::vector<uint32_t>   vertexIndices;
-    vertexIndices.resize(pSrcMesh->mNumFaces * 3);
+    // 1区画あたり数セルになる解像度にする.
+    size_t resolution = 1;
+    while(resolution < kMaxResolution && resolution * resolution * resolution < partitionCount * 8)
+    { resolution *= 2; }
 
-    for(auto i=0u; i<pSrcMesh->mNumFaces; ++i)
+    auto cellCount = resolution * resolution * resolution;
+    auto scale = [&](float value, float lo, float hi)
     {
-        const auto& face = pSrcMesh->mFaces[i];
-        assert(face.mNumIndices == 3);  // 三角形化しているので必ず3になっている.
+        auto extent = hi - lo;
+        if (extent <= 0.0f)
+        { return 0u; }
+        auto cell = uint32_t((value - lo) / extent * float(resolution));
+        return std::min(cell, uint32_t(resolution - 1));
+    };
+
+    // セル番号を並列に求める.
+    std::vector<uint32_t> cells(faceCount);
+    ParallelFor(faceCount, kGrainSize, [&](size_t begin, size_t end)
+    {
+        for(auto i=begin; i<end; ++i)
+        {
+            const auto& p0 = positions[triangles[i * 3 + 0]];
+            const auto& p1 = positions[triangles[i * 3 + 1]];
+            const auto& p2 = positions[triangles[i * 3 + 2]];
+
+            cells[i] = EncodeMorton3(
+                scale((p0.x + p1.x + p2.x) / 3.0f, mini.x, maxi.x),
+                scale((p0.y + p1.y + p2.y) / 3.0f, mini.y, maxi.y),
+                scale((p0.z + p1.z + p2.z) / 3.0f, mini.z, maxi.z));
+        }
+    });
 
-        vertexIndices[i * 3 + 0] = face.mIndices[0];
-        vertexIndices[i * 3 + 1] = face.mIndices[1];
-        vertexIndices[i * 3 + 2] = face.mIndices[2];
+    std::vector<size_t> cellOffsets(cellCount + 1, 0);
+    for(size_t i=0; i<faceCount; ++i)
+    { cellOffsets[cells[i] + 1]++; }
+
+    for(size_t i=0; i<cellCount; ++i)
+    { cellOffsets[i + 1] += cellOffsets[i]; }
+
+    // 計数ソートは安定なので，セル内では頂点キャッシュ最適化済みの順番が保たれる.
+    sorted.resize(triangles.size());
+    for(size_t i=0; i<faceCount; ++i)
+    {
+        auto dst = cellOffsets[cells[i]]++;
+        sorted[dst * 3 + 0] = triangles[i * 3 + 0];
+        sorted[dst * 3 + 1] = triangles[i * 3 + 1];
+        sorted[dst * 3 + 2] = triangles[i * 3 + 2];
     }
+}
 
-    // 最適化.
+//-----------------------------------------------------------------------------
+//      区画内の三角形からメッシュレットを生成します.
+//-----------------------------------------------------------------------------
+void BuildPartitionMeshlets
+(
+    const uint32_t*                 pTriangles,
+    size_t                          indexCount,
+    std::vector<meshopt_Meshlet>&   meshlets
+)
+{
+    // 区画で参照する頂点だけに詰めて，作業領域をメッシュ全体の頂点数に比例させない.
+    std::vector<uint32_t> vertices(pTriangles, pTriangles + indexCount);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+    std::vector<uint32_t> local(indexCount);
+    for(size_t i=0; i<indexCount; ++i)
+    { local[i] = uint32_t(std::lower_bound(vertices.begin(), vertices.end(), pTriangles[i]) - vertices.begin()); }
+
+    meshlets.resize(
+        meshopt_buildMeshletsBound(
+            indexCount,
+            kMeshletMaxVertices,
+            kMeshletMaxPrimitives));
+    meshlets.resize(
+        meshopt_buildMeshlets(
+            meshlets.data(),
+            local.data(),
+            local.size(),
+            vertices.size(),
+            kMeshletMaxVertices,
+            kMeshletMaxPrimitives));
+
+    // メッシュ全体の頂点番号に戻す.
+    for(auto& meshlet : meshlets)
     {
-        std::vector<uint32_t> remap(vertexIndices.size());
+        for(auto i=0u; i<meshlet.vertex_count; ++i)
+        { meshlet.vertices[i] = vertices[meshlet.vertices[i]]; }
+    }
+}
 
-        // 重複データを削除するための再マッピング用インデックスを生成.
-        meshopt_Stream streams[9] = {};
-        streams[0].data     = dstMesh.Positions.data();
-        streams[0].size     = sizeof(dstMesh.Positions[0]);
-        streams[0].stride   = sizeof(dstMesh.Positions[0]);
+//-----------------------------------------------------------------------------
+//      メッシュレットを構築します.
+//-----------------------------------------------------------------------------
+void BuildMeshlets
+(
+    const std::vector<uint32_t>&            triangles,
+    const std::vector<asdx::Vector3>&       positions,
+    std::vector<uint32_t>&                  indices,
+    std::vector<asdx::ResPrimitive>&        primitives,
+    std::vector<asdx::ResMeshlet>&          dstMeshlets,
+    std::vector<asdx::ResCullingInfo>&      cullingInfos
+)
+{
+    auto faceCount = triangles.size() / 3;
 
-        auto idx = 1;
-        if (!dstMesh.TangentSpaces.empty())
-        {
-            streams[idx].data   = dstMesh.TangentSpaces.data();
-            streams[idx].size   = sizeof(dstMesh.TangentSpaces[0]);
-            streams[idx].stride = sizeof(dstMesh.TangentSpaces[0]);
-            idx++;
-        }
+    // 大きなメッシュは空間分割して区画ごとに並列に生成する.
+    std::vector<std::vector<meshopt_Meshlet>> partitions;
+    if (faceCount <= kParallelMeshletFaceCount)
+    {
+        partitions.resize(1);
+        auto& meshlets = partitions[0];
+        meshlets.resize(
+            meshopt_buildMeshletsBound(
+                triangles.size(),
+                kMeshletMaxVertices,
+                kMeshletMaxPrimitives));
+        meshlets.resize(
+            meshopt_buildMeshlets(
+                meshlets.data(),
+                triangles.data(),
+                triangles.size(),
+                positions.size(),
+                kMeshletMaxVertices,
+                kMeshletMaxPrimitives));
+    }
+    else
+    {
+        auto partitionCount = (faceCount + kMeshletPartitionFaceCount - 1) / kMeshletPartitionFaceCount;
 
-        if (!dstMesh.Colors.empty())
-        {
-            streams[idx].data   = dstMesh.Colors.data();
-            streams[idx].size   = sizeof(dstMesh.Colors[0]);
-            streams[idx].stride = sizeof(dstMesh.Colors[0]);
-            idx++;
-        }
+        std::vector<uint32_t> sorted;
+        SortTrianglesSpatially(triangles, positions, partitionCount, sorted);
 
-        for(auto i=0; i<4; ++i)
+        partitions.resize(partitionCount);
+        ParallelFor(partitionCount, 1, [&](size_t begin, size_t end)
         {
-            if (!dstMesh.TexCoords[i].empty())
+            for(auto i=begin; i<end; ++i)
             {
-                streams[idx].data   = dstMesh.TexCoords[i].data();
-                streams[idx].size   = sizeof(dstMesh.TexCoords[i][0]);
-                streams[idx].stride = sizeof(dstMesh.TexCoords[i][0]);
-                idx++;
+                auto first = i * kMeshletPartitionFaceCount;
+                auto count = std::min(kMeshletPartitionFaceCount, faceCount - first);
+                BuildPartitionMeshlets(sorted.data() + first * 3, count * 3, partitions[i]);
             }
-        }
+        });
+    }
 
-        if (!dstMesh.BoneIndices.empty())
+    // 区画ごとの書き込み先を決める.
+    std::vector<size_t> meshletOffsets  (partitions.size() + 1, dstMeshlets.size());
+    std::vector<size_t> vertexOffsets   (partitions.size() + 1, indices    .size());
+    std::vector<size_t> primitiveOffsets(partitions.size() + 1, primitives .size());
+    for(size_t i=0; i<partitions.size(); ++i)
+    {
+        size_t vertexCount    = 0;
+        size_t primitiveCount = 0;
+        for(auto& meshlet : partitions[i])
         {
-            streams[idx].data   = dstMesh.BoneIndices.data();
-            streams[idx].size   = sizeof(dstMesh.BoneIndices[0]);
-            streams[idx].stride = sizeof(dstMesh.BoneIndices[0]);
-            idx++;
+            vertexCount    += meshlet.vertex_count;
+            primitiveCount += meshlet.triangle_count;
         }
 
-        if (!dstMesh.BoneWeights.empty())
-        {
-            streams[idx].data   = dstMesh.BoneWeights.data();
-            streams[idx].size   = sizeof(dstMesh.BoneWeights[0]);
-            streams[idx].stride = sizeof(dstMesh.BoneWeights[0]);
-            idx++;
-        }
+        meshletOffsets  [i + 1] = meshletOffsets  [i] + partitions[i].size();
+        vertexOffsets   [i + 1] = vertexOffsets   [i] + vertexCount;
+        primitiveOffsets[i + 1] = primitiveOffsets[i] + primitiveCount;
+    }
 
-        auto vertexCount = meshopt_generateVertexRemapMulti(
-            remap.data(),
-            vertexIndices.data(),
-            vertexIndices.size(),
-            dstMesh.Positions.size(),
-            streams,
-            idx
-        );
+    // 三角形数を制限しているので32bitを超えることはない.
+    assert(vertexOffsets   .back() <= UINT32_MAX);
+    assert(primitiveOffsets.back() <= UINT32_MAX);
 
+    indices     .resize(vertexOffsets   .back());
+    primitives  .resize(primitiveOffsets.back());
+    dstMeshlets .resize(meshletOffsets  .back());
+    cullingInfos.resize(meshletOffsets  .back());
 
-        // 位置座標.
+    // バウンディングの計算と書き込みも区画ごとに並列に行う.
+    ParallelFor(partitions.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(auto i=begin; i<end; ++i)
         {
-            meshopt_remapVertexBuffer(
-                dstMesh.Positions.data(),
-                dstMesh.Positions.data(),
-                dstMesh.Positions.size(),
-                sizeof(dstMesh.Positions[0]),
-                remap.data());
+            auto meshletOffset   = meshletOffsets  [i];
+            auto vertexOffset    = vertexOffsets   [i];
+            auto primitiveOffset = primitiveOffsets[i];
 
-            dstMesh.Positions.resize(vertexCount);
-            dstMesh.Positions.shrink_to_fit();
-        }
+            for(auto& meshlet : partitions[i])
+            {
+                for(auto j=0u; j<meshlet.vertex_count; ++j)
+                { indices[vertexOffset + j] = meshlet.vertices[j]; }
 
-        // 接線空間.
-        if (!dstMesh.TangentSpaces.empty())
-        {
-            meshopt_remapVertexBuffer(
-                dstMesh.TangentSpaces.data(),
-                dstMesh.TangentSpaces.data(),
-                dstMesh.TangentSpaces.size(),
-                sizeof(dstMesh.TangentSpaces[0]),
-                remap.data());
+                for(auto j=0; j<meshlet.triangle_count; ++j)
+                {
+                    auto& tris = primitives[primitiveOffset + j];
+                    tris = {};
+                    tris.Index1 = meshlet.indices[j][0];
+                    tris.Index0 = meshlet.indices[j][1];
+                    tris.Index2 = meshlet.indices[j][2];
+                }
 
-            dstMesh.TangentSpaces.resize(vertexCount);
-            dstMesh.TangentSpaces.shrink_to_fit();
+                auto bounds = meshopt_computeMeshletBounds(
+                    &meshlet,
+                    &positions[0].x,
+                    positions.size(),
+                    sizeof(positions[0]));
+
+                // メッシュレットデータ設定.
+                auto& m = dstMeshlets[meshletOffset];
+                m = {};
+                m.VertexCount       = meshlet.vertex_count;
+                m.VertexOffset      = uint32_t(vertexOffset);
+                m.PrimitiveCount    = meshlet.triangle_count;
+                m.PrimitiveOffset   = uint32_t(primitiveOffset);
+
+                // カリングデータ設定.
+                auto normalCone = asdx::Vector4(
+                    bounds.cone_axis[0] * 0.5f + 0.5f,
+                    bounds.cone_axis[1] * 0.5f + 0.5f,
+                    bounds.cone_axis[2] * 0.5f + 0.5f,
+                    bounds.cone_cutoff * 0.5f + 0.5f);
+
+                auto& c = cullingInfos[meshletOffset];
+                c = {};
+                c.BoundingSphere = asdx::Vector4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius);
+                c.NormalCone     = asdx::EncodeUnorm4(normalCone);
+
+                meshletOffset++;
+                vertexOffset    += meshlet.vertex_count;
+                primitiveOffset += meshlet.triangle_count;
+            }
         }
+    });
+}
 
-        // 頂点カラー.
-        if (!dstMesh.Colors.empty())
+///////////////////////////////////////////////////////////////////////////////
+// ContentHasher class
+///////////////////////////////////////////////////////////////////////////////
+class ContentHasher
+{
+public:
+    //-------------------------------------------------------------------------
+    //      値を追加します(FNV-1a 32bit).
+    //-------------------------------------------------------------------------
+    void Add(const void* pData, size_t size)
+    {
+        auto pBytes = static_cast<const uint8_t*>(pData);
+        for(size_t i=0; i<size; ++i)
         {
-            meshopt_remapVertexBuffer(
-                dstMesh.Colors.data(),
-                dstMesh.Colors.data(),
-                dstMesh.Colors.size(),
-                sizeof(dstMesh.Colors[0]),
-                remap.data());
-
-            dstMesh.Colors.resize(vertexCount);
-            dstMesh.Colors.shrink_to_fit();
+            m_Hash ^= pBytes[i];
+            m_Hash *= 16777619u;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      整数値を追加します.
+    //-------------------------------------------------------------------------
+    void Add(uint32_t value)
+    { Add(&value, sizeof(value)); }
+
+    //-------------------------------------------------------------------------
+    //      浮動小数値を追加します. -0 は 0 として扱います.
+    //-------------------------------------------------------------------------
+    void Add(float value)
+    {
+        if (value == 0.0f)
+        { value = 0.0f; }
+        Add(&value, sizeof(value));
+    }
+
+    //-------------------------------------------------------------------------
+    //      ハッシュ値を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetHash() const
+    { return m_Hash; }
+
+private:
+    uint32_t m_Hash = 2166136261u;
+};
+
+//-----------------------------------------------------------------------------
+//      マテリアルの内容ハッシュを求めます.
+//-----------------------------------------------------------------------------
+uint32_t CalcContentHash(const Material& material)
+{
+    ContentHasher hasher;
+    hasher.Add(material.BaseColor.x);
+    hasher.Add(material.BaseColor.y);
+    hasher.Add(material.BaseColor.z);
+    hasher.Add(material.BaseColor.w);
+    hasher.Add(material.Emissive.x);
+    hasher.Add(material.Emissive.y);
+    hasher.Add(material.Emissive.z);
+    hasher.Add(material.Metallic);
+    hasher.Add(material.Roughness);
+    hasher.Add(uint32_t(material.AlphaMode));
+    hasher.Add((material.AlphaMode == ALPHA_MODE_MASK) ? material.AlphaCutoff : 0.0f);
+    hasher.Add(uint32_t(material.TwoSided ? 1 : 0));
+    hasher.Add(material.UVScale.x);
+    hasher.Add(material.UVScale.y);
+    hasher.Add(material.UVOffset.x);
+    hasher.Add(material.UVOffset.y);
+    hasher.Add(material.UVRotation);
+
+    // テクスチャの格納順には依存させない.
+    std::vector<std::pair<uint32_t, uint32_t>> textures;
+    textures.reserve(material.Textures.size());
+    for(auto& texture : material.Textures)
+    { textures.push_back(std::make_pair(uint32_t(texture.Usage), texture.PathId)); }
+    std::sort(textures.begin(), textures.end());
+
+    hasher.Add(uint32_t(textures.size()));
+    for(auto& texture : textures)
+    {
+        hasher.Add(texture.first);
+        hasher.Add(texture.second);
+    }
+
+    return hasher.GetHash();
+}
+
+//-----------------------------------------------------------------------------
+//      非圧縮の埋め込みテクスチャを TGA 形式にします.
+//-----------------------------------------------------------------------------
+void EncodeTga(uint32_t width, uint32_t height, const aiTexel* pTexels, std::vector<uint8_t>& data)
+{
+    // aiTexel は BGRA の順なので，そのまま32bitの画素として書き込める.
+    uint8_t header[18] = {};
+    header[2]  = 2;                         // 非圧縮フルカラー.
+    header[12] = uint8_t(width  & 0xff);
+    header[13] = uint8_t(width  >> 8);
+    header[14] = uint8_t(height & 0xff);
+    header[15] = uint8_t(height >> 8);
+    header[16] = 32;                        // ビット深度.
+    header[17] = 0x28;                      // アルファ8bit, 左上原点.
+
+    auto size = size_t(width) * size_t(height) * sizeof(aiTexel);
+    data.resize(sizeof(header) + size);
+    memcpy(data.data(), header, sizeof(header));
+    memcpy(data.data() + sizeof(header), pTexels, size);
+}
+
+//-----------------------------------------------------------------------------
+//      統合可能な頂点属性の組み合わせを表すキーを求めます.
+//-----------------------------------------------------------------------------
+uint64_t GetMergeKey(const aiMesh* pSrcMesh, uint32_t matHash)
+{
+    uint32_t layout = 0;
+    if (pSrcMesh->HasNormals())
+    { layout |= 0x1; }
+    if (pSrcMesh->HasTangentsAndBitangents())
+    { layout |= 0x2; }
+    if (pSrcMesh->HasVertexColors(0))
+    { layout |= 0x4; }
+    for(auto i=0; i<4; ++i)
+    {
+        if (pSrcMesh->HasTextureCoords(i))
+        { layout |= 0x8 << i; }
+    }
+
+    // マテリアルを統合した場合は番号が異なっても同じハッシュになるので，ハッシュで束ねる.
+    return (uint64_t(matHash) << 32) | layout;
+}
+
+//-----------------------------------------------------------------------------
+//      配列を連結します.
+//-----------------------------------------------------------------------------
+template<typename T>
+T* ConcatArray(const aiScene* pScene, const std::vector<uint32_t>& meshes, size_t count, T* aiMesh::* member)
+{
+    auto pResult = new T[count];
+    size_t offset = 0;
+    for(auto index : meshes)
+    {
+        auto pMesh = pScene->mMeshes[index];
+        memcpy(pResult + offset, pMesh->*member, sizeof(T) * pMesh->mNumVertices);
+        offset += pMesh->mNumVertices;
+    }
+    return pResult;
+}
+
+//-----------------------------------------------------------------------------
+//      同じマテリアルと頂点属性を持つメッシュを1つに統合します.
+//-----------------------------------------------------------------------------
+aiMesh* MergeMeshes(const aiScene* pScene, const std::vector<uint32_t>& meshes, const char* name)
+{
+    auto pFirst = pScene->mMeshes[meshes.front()];
+
+    size_t vertexCount = 0;
+    size_t faceCount   = 0;
+    for(auto index : meshes)
+    {
+        vertexCount += pScene->mMeshes[index]->mNumVertices;
+        faceCount   += pScene->mMeshes[index]->mNumFaces;
+    }
+
+    // aiMesh のデストラクタで解放されるように new[] で確保する.
+    auto pResult = new aiMesh();
+    pResult->mName.Set(name);
+    pResult->mMaterialIndex  = pFirst->mMaterialIndex;
+    pResult->mPrimitiveTypes = pFirst->mPrimitiveTypes;
+    pResult->mNumVertices    = uint32_t(vertexCount);
+    pResult->mNumFaces       = uint32_t(faceCount);
+
+    pResult->mVertices = ConcatArray(pScene, meshes, vertexCount, &aiMesh::mVertices);
+    if (pFirst->HasNormals())
+    { pResult->mNormals = ConcatArray(pScene, meshes, vertexCount, &aiMesh::mNormals); }
+    if (pFirst->HasTangentsAndBitangents())
+    {
+        pResult->mTangents   = ConcatArray(pScene, meshes, vertexCount, &aiMesh::mTangents);
+        pResult->mBitangents = ConcatArray(pScene, meshes, vertexCount, &aiMesh::mBitangents);
+    }
+
+    if (pFirst->HasVertexColors(0))
+    {
+        pResult->mColors[0] = new aiColor4D[vertexCount];
+        size_t offset = 0;
+        for(auto index : meshes)
+        {
+            auto pMesh = pScene->mMeshes[index];
+            memcpy(pResult->mColors[0] + offset, pMesh->mColors[0], sizeof(aiColor4D) * pMesh->mNumVertices);
+            offset += pMesh->mNumVertices;
+        }
+    }
+
+    for(auto i=0; i<4; ++i)
+    {
+        if (!pFirst->HasTextureCoords(i))
+        { continue; }
+
+        pResult->mNumUVComponents[i] = pFirst->mNumUVComponents[i];
+        pResult->mTextureCoords  [i] = new aiVector3D[vertexCount];
+        size_t offset = 0;
+        for(auto index : meshes)
+        {
+            auto pMesh = pScene->mMeshes[index];
+            memcpy(pResult->mTextureCoords[i] + offset, pMesh->mTextureCoords[i], sizeof(aiVector3D) * pMesh->mNumVertices);
+            offset += pMesh->mNumVertices;
+        }
+    }
+
+    // 頂点番号をずらして三角形を連結する.
+    pResult->mFaces = new aiFace[faceCount];
+    {
+        size_t faceOffset   = 0;
+        uint32_t baseVertex = 0;
+        for(auto index : meshes)
+        {
+            auto pMesh = pScene->mMeshes[index];
+            for(auto i=0u; i<pMesh->mNumFaces; ++i)
+            {
+                const auto& srcFace = pMesh->mFaces[i];
+                auto& dstFace = pResult->mFaces[faceOffset + i];
+                dstFace.mNumIndices = srcFace.mNumIndices;
+                dstFace.mIndices    = new unsigned int[srcFace.mNumIndices];
+                for(auto j=0u; j<srcFace.mNumIndices; ++j)
+                { dstFace.mIndices[j] = srcFace.mIndices[j] + baseVertex; }
+            }
+            faceOffset += pMesh->mNumFaces;
+            baseVertex += pMesh->mNumVertices;
+        }
+    }
+
+    return pResult;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+MeshLoader::MeshLoader()
+: m_pScene(nullptr)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MeshLoader::~MeshLoader()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      メッシュをロードします.
+//-----------------------------------------------------------------------------
+bool MeshLoader::Load
+(
+    const char*             filename,
+    asdx::ResModel&         model,
+    const MeshLoaderOption& option
+)
+{
+    if (filename == nullptr)
+    { return false; }
+
+    return LoadCore(filename, nullptr, 0, model, option);
+}
+
+//-----------------------------------------------------------------------------
+//      メモリ上のファイルイメージからモデルをロードします.
+//-----------------------------------------------------------------------------
+bool MeshLoader::Load
+(
+    const void*             pData,
+    size_t                  size,
+    const char*             name,
+    asdx::ResModel&         model,
+    const MeshLoaderOption& option
+)
+{
+    if (pData == nullptr || size == 0 || name == nullptr)
+    { return false; }
+
+    return LoadCore(name, pData, size, model, option);
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルまたはメモリからモデルをロードします.
+//-----------------------------------------------------------------------------
+bool MeshLoader::LoadCore
+(
+    const char*             filename,
+    const void*             pData,
+    size_t                  size,
+    asdx::ResModel&         model,
+    const MeshLoaderOption& option
+)
+{
+    m_Option   = option;
+    m_Canceled = false;
+
+    // 埋め込みテクスチャの命名に使う.
+    m_EmbeddedIds.clear();
+    {
+        std::string path(filename);
+        auto begin = path.find_last_of("/\\");
+        begin = (begin == std::string::npos) ? 0 : begin + 1;
+        auto end = path.find_last_of('.');
+        if (end == std::string::npos || end < begin)
+        { end = path.size(); }
+        m_ModelName = path.substr(begin, end - begin);
+    }
+
+    // プールから取得した場合はローダーとポストプロセスの登録を省略できる.
+    ScopedImporter scopedImporter(m_Option.pImporterPool);
+    auto& importer = scopedImporter.Get();
+    uint32_t flag = GetImportFlags(m_Option.Profile);
+    flag |= m_Option.EnableFlags;
+    flag &= ~m_Option.DisableFlags;
+
+    // PreTransformVertices はボーンを破棄するので，アニメーションを変換できない.
+    if (m_Option.ParseAnimation && (flag & aiProcess_PreTransformVertices))
+    {
+        ELOGA("Error : Animation Requires Profile Without PreTransformVertices. Use -profile skinned.");
+        return false;
+    }
+
+    if (m_Option.Progress)
+    {
+        scopedImporter.SetProgress([this](uint32_t done)
+        { return Report(PROGRESS_STAGE_IMPORT, done, 100); });
+    }
+
+    // メモリから読み込む場合は拡張子をフォーマットのヒントにする.
+    std::string hint;
+    if (pData != nullptr)
+    {
+        auto pos = std::string(filename).find_last_of('.');
+        if (pos != std::string::npos)
+        { hint = filename + pos + 1; }
+    }
+
+    auto read = [&](uint32_t flags)
+    {
+        return (pData != nullptr)
+            ? importer.ReadFileFromMemory(pData, size, flags, hint.c_str())
+            : importer.ReadFile(filename, flags);
+    };
+
+    if (m_Option.MeasureTime)
+    {
+        // ファイルを読み込み.
+        {
+            StageTimer timer(true, "ReadFile");
+            m_pScene = read(0);
+        }
+
+        // コストが分かるように1ステップずつ適用する.
+        for(auto i=0u; i<_countof(kPostProcessSteps) && m_pScene != nullptr; ++i)
+        {
+            const auto& step = kPostProcessSteps[i];
+            if ((flag & step.Flag) == 0)
+            { continue; }
+
+            StageTimer timer(true, step.Name);
+            m_pScene = importer.ApplyPostProcessing(step.Flag);
+        }
+    }
+    else
+    {
+        // ファイルを読み込み.
+        m_pScene = read(flag);
+    }
+
+    // チェック.
+    if (m_pScene == nullptr)
+    {
+        if (m_Canceled)
+        { return false; }
+
+        ELOGA("Error : Assimp::Importer::ReadFile() Failed. reason = %s", importer.GetErrorString());
+        return false;
+    }
+
+    // スケルトンとアニメーションを変換.
+    // メッシュのボーン番号を関節番号に揃えるため，メッシュより先に処理する.
+    m_Skeleton.Joints.clear();
+    m_Animations.clear();
+    if (m_Option.ParseAnimation && Report(PROGRESS_STAGE_ANIMATION, 0, 1))
+    {
+        StageTimer timer(m_Option.MeasureTime, "ParseAnimation");
+        if (!ParseAnimation())
+        { return false; }
+        Report(PROGRESS_STAGE_ANIMATION, 1, 1);
+    }
+
+    // マテリアルデータを変換.
+    // メッシュを逐次出力できるように，メッシュより先にマテリアルハッシュを確定させる.
+    m_MaterialRemap.clear();
+    if (!m_Canceled)
+    {
+        StageTimer timer(m_Option.MeasureTime, "ParseMaterial");
+        for(auto i=0u; i<m_pScene->mNumMaterials; ++i)
+        {
+            if (!Report(PROGRESS_STAGE_MATERIAL, i, m_pScene->mNumMaterials))
+            { break; }
+
+            const auto pMaterial = m_pScene->mMaterials[i];
+            ParseMaterial(pMaterial);
+        }
+        if (m_Option.MergeMaterials)
+        { MergeMaterials(); }
+
+        m_Materials.shrink_to_fit();
+        Report(PROGRESS_STAGE_MATERIAL, m_pScene->mNumMaterials, m_pScene->mNumMaterials);
+    }
+
+    // メッシュデータを変換.
+    auto succeeded = true;
+    m_MeshMaterials.clear();
+    if (!m_Canceled)
+    {
+        StageTimer timer(m_Option.MeasureTime, "ParseMesh");
+        if (m_Option.MergeMeshes)
+        {
+            if (Report(PROGRESS_STAGE_MESH, 0, 1))
+            {
+                succeeded = ParseMergedMeshes(model);
+                Report(PROGRESS_STAGE_MESH, 1, 1);
+            }
+        }
+        else
+        {
+            for(auto i=0u; i<m_pScene->mNumMeshes; ++i)
+            {
+                if (!Report(PROGRESS_STAGE_MESH, i, m_pScene->mNumMeshes))
+                { break; }
+
+                const auto pMesh = m_pScene->mMeshes[i];
+                if (!ParseMesh(model, pMesh))
+                {
+                    succeeded = false;
+                    break;
+                }
+            }
+            Report(PROGRESS_STAGE_MESH, m_pScene->mNumMeshes, m_pScene->mNumMeshes);
+        }
+        model.Meshes.shrink_to_fit();
+    }
+
+    if (!m_Canceled && succeeded)
+    { BuildTextureDependencies(); }
+
+    // 不要になったのでクリア.
+    // シーンは Assimp 側のヒープで確保されているので，個別に delete せず必ずインポーター経由で解放する.
+    // Assimp 4.1 にはメッシュ単位で解放するAPIが無いため，メッシュごとの早期解放は行わない.
+    importer.FreeScene();
+    m_pScene = nullptr;
+
+    // 中断された場合は途中までの結果を返さない.
+    if (m_Canceled || !succeeded)
+    { return false; }
+
+    // 正常終了.
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      進捗コールバックにより中断されたかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool MeshLoader::IsCanceled() const
+{ return m_Canceled; }
+
+//-----------------------------------------------------------------------------
+//      進捗を通知します.
+//-----------------------------------------------------------------------------
+bool MeshLoader::Report(PROGRESS_STAGE stage, uint32_t done, uint32_t total)
+{
+    if (m_Canceled)
+    { return false; }
+
+    if (m_Option.Progress && !m_Option.Progress(stage, done, total))
+    {
+        ILOGA("Info : Load Canceled. stage = %d", int(stage));
+        m_Canceled = true;
+    }
+
+    return !m_Canceled;
+}
+
+//-----------------------------------------------------------------------------
+//      出力するマテリアルハッシュを取得します.
+//-----------------------------------------------------------------------------
+uint32_t MeshLoader::GetMaterialHash(uint32_t matId) const
+{
+    // 統合したマテリアルは内容ハッシュで参照する.
+    // 名前が同じでも内容が異なる場合があるので，シーン内のマテリアル番号で引く.
+    if (matId < m_MaterialRemap.size())
+    { return m_MaterialRemap[matId]; }
+
+    uint32_t matHash = matId;
+
+    auto pMaterial = m_pScene->mMaterials[matId];
+    aiString matName;
+    if (pMaterial->Get(AI_MATKEY_NAME, matName) == AI_SUCCESS)
+    { matHash = asdx::Fnv1a(matName.C_Str()).GetHash(); }
+
+    return matHash;
+}
+
+//-----------------------------------------------------------------------------
+//      スケルトンとアニメーションを解析します.
+//-----------------------------------------------------------------------------
+bool MeshLoader::ParseAnimation()
+{
+    // アニメーションの出力が要求されているので，スケルトンが無い場合は失敗とする.
+    if (!BuildSkeleton(m_pScene, m_Skeleton))
+    {
+        ELOGA("Error : Skeleton Not Found.");
+        return false;
+    }
+
+    ILOGA("Info : Skeleton Built. joints = %zu", m_Skeleton.Joints.size());
+
+    m_Animations.resize(m_pScene->mNumAnimations);
+    for(auto i=0u; i<m_pScene->mNumAnimations; ++i)
+    {
+        auto& clip = m_Animations[i];
+        ConvertAnimation(m_pScene->mAnimations[i], m_Skeleton, m_Option.AnimationCompress, clip);
+
+        auto ratio = (clip.SourceKeyCount > 0)
+            ? double(clip.KeyCount) / double(clip.SourceKeyCount) * 100.0
+            : 0.0;
+
+        ILOGA("Info : Animation Converted. name = %s, duration = %f sec, tracks = %zu, keys = %zu / %zu (%.1f%%)",
+            clip.Name.c_str(),
+            clip.Duration,
+            clip.Tracks.size(),
+            clip.KeyCount,
+            clip.SourceKeyCount,
+            ratio);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      マテリアル単位でメッシュを統合して解析します.
+//-----------------------------------------------------------------------------
+bool MeshLoader::ParseMergedMeshes(asdx::ResModel& model)
+{
+    // 出現順を維持してグループ化する.
+    struct Group
+    {
+        size_t                  VertexCount = 0;
+        size_t                  FaceCount   = 0;
+        std::vector<uint32_t>   Meshes;
+    };
+
+    std::vector<uint64_t>                                   keys;
+    std::unordered_map<uint64_t, std::vector<Group>>        groups;
+
+    for(auto i=0u; i<m_pScene->mNumMeshes; ++i)
+    {
+        auto pMesh = m_pScene->mMeshes[i];
+
+        // スキンメッシュはボーン番号の付け替えが必要になるので統合しない.
+        if (pMesh->HasBones())
+        {
+            if (!ParseMesh(model, pMesh))
+            { return false; }
+            continue;
+        }
+
+        auto key = GetMergeKey(pMesh, GetMaterialHash(pMesh->mMaterialIndex));
+        auto itr = groups.find(key);
+        if (itr == groups.end())
+        {
+            keys.push_back(key);
+            itr = groups.insert(std::make_pair(key, std::vector<Group>(1))).first;
+        }
+
+        // 頂点数と三角形数が aiMesh の32bitのカウンタに収まるようにグループを分ける.
+        const auto& last = itr->second.back();
+        if (!last.Meshes.empty()
+          && (last.VertexCount + pMesh->mNumVertices > UINT32_MAX
+           || last.FaceCount   + pMesh->mNumFaces    > UINT32_MAX))
+        { itr->second.emplace_back(); }
+
+        auto& group = itr->second.back();
+        group.VertexCount += pMesh->mNumVertices;
+        group.FaceCount   += pMesh->mNumFaces;
+        group.Meshes.push_back(i);
+    }
+
+    size_t mergedCount = 0;
+    for(auto key : keys)
+    {
+        for(auto& group : groups[key])
+        {
+            if (group.Meshes.size() == 1)
+            {
+                if (!ParseMesh(model, m_pScene->mMeshes[group.Meshes.front()]))
+                { return false; }
+                continue;
+            }
+
+            // 統合後のメッシュ名はマテリアル番号と頂点属性から決める.
+            auto name = "merged_" + std::to_string(key >> 32)
+                      + "_" + std::to_string(key & 0xffffffff)
+                      + "_" + std::to_string(mergedCount);
+
+            std::unique_ptr<aiMesh> pMerged(MergeMeshes(m_pScene, group.Meshes, name.c_str()));
+
+            if (!ParseMesh(model, pMerged.get()))
+            { return false; }
+            mergedCount++;
+        }
+    }
+
+    ILOGA("Info : Mesh Merged. source meshes = %u, output meshes = %zu", m_pScene->mNumMeshes, m_MeshMaterials.size());
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      静的メッシュデータを解析します.
+//-----------------------------------------------------------------------------
+bool MeshLoader::ParseMesh(asdx::ResModel& model, const aiMesh* pSrcMesh)
+{
+    auto matHash  = GetMaterialHash(pSrcMesh->mMaterialIndex);
+    auto meshHash = asdx::Fnv1a(pSrcMesh->mName.C_Str()).GetHash();
+
+    // ボーン番号と重みを設定する.
+    SkinSource skin;
+    if (pSrcMesh->HasBones() && !ParseSkin(pSrcMesh, skin))
+    { return false; }
+
+    // 作業メモリの目安と32bitインデックスの範囲.
+    // Assimp のシーンは全体が読み込まれたままなので，ピークメモリを上限で抑えるものではない.
+    // 指定があれば大きなメッシュを空間分割する.
+    auto faceLimit = GetFaceLimit(EstimateFaceLimit(pSrcMesh, m_Option.WorkingSetBudget), m_Option.MaxFaceCount);
+
+    std::vector<uint32_t>               faces;
+    std::vector<size_t>                 offsets;
+    std::vector<std::vector<uint16_t>>  palettes;
+    std::vector<uint32_t>               tangentSpaces;
+
+    if (pSrcMesh->HasBones() && m_Option.BonePaletteSize > 0)
+    {
+        // 1三角形が参照するボーンは必ず収まるようにする.
+        auto paletteSize = std::min<size_t>(m_Option.BonePaletteSize, kMaxBonePaletteSize);
+        paletteSize = std::max<size_t>(paletteSize, skin.Stream.InfluenceCount * 3);
+
+        // ボーンパレットに収まる単位で分割する.
+        PartitionFacesByBones(pSrcMesh, skin.Packed, skin.BoneCount, paletteSize, faceLimit, faces, offsets, palettes);
+    }
+    else if (pSrcMesh->mNumFaces <= faceLimit)
+    {
+        // 収まるなら一括で処理.
+        BuildMesh(model, pSrcMesh, nullptr, pSrcMesh->mNumFaces, meshHash, matHash, skin, nullptr, nullptr);
+        return true;
+    }
+    else
+    {
+        // 空間分割してチャンク単位で処理する.
+        PartitionFaces(pSrcMesh, faceLimit, faces, offsets);
+    }
+
+    // チャンクごとに生成すると境界の頂点で接線が食い違うので，分割前に全体で生成しておく.
+    if (NeedsTangentGeneration(pSrcMesh))
+    { GenerateSourceTangentSpaces(pSrcMesh, tangentSpaces); }
+
+    for(size_t i=0; i + 1<offsets.size(); ++i)
+    {
+        if (m_Canceled)
+        { break; }
+
+        auto name = std::string(pSrcMesh->mName.C_Str()) + "#" + std::to_string(i);
+        auto hash = asdx::Fnv1a(name.c_str()).GetHash();
+
+        BuildMesh(
+            model,
+            pSrcMesh,
+            faces.data() + offsets[i],
+            offsets[i + 1] - offsets[i],
+            hash,
+            matHash,
+            skin,
+            palettes.empty() ? nullptr : &palettes[i],
+            tangentSpaces.empty() ? nullptr : &tangentSpaces);
+    }
+
+    ILOGA("Info : Mesh Partitioned. name = %s, faces = %u, chunks = %zu",
+        pSrcMesh->mName.C_Str(), pSrcMesh->mNumFaces, offsets.size() - 1);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      スキニング情報を解析します.
+//-----------------------------------------------------------------------------
+bool MeshLoader::ParseSkin(const aiMesh* pSrcMesh, SkinSource& skin)
+{
+    const auto count = std::max(1u, std::min(m_Option.SkinInfluenceCount, 8u));
+
+    // スケルトンがある場合はボーン番号を関節番号に揃える.
+    std::vector<uint16_t> boneMap;
+    skin.BoneCount = pSrcMesh->mNumBones;
+    if (!m_Skeleton.Joints.empty())
+    {
+        boneMap.resize(pSrcMesh->mNumBones, 0);
+        for(auto i=0u; i<pSrcMesh->mNumBones; ++i)
+        {
+            // 見つからないボーンを根に割り当てると，その頂点が根に追従してしまう.
+            auto joint = m_Skeleton.Find(asdx::Fnv1a(pSrcMesh->mBones[i]->mName.C_Str()).GetHash());
+            if (joint < 0)
+            {
+                ELOGA("Error : Bone Not Found In Skeleton. mesh = %s, bone = %s",
+                    pSrcMesh->mName.C_Str(), pSrcMesh->mBones[i]->mName.C_Str());
+                return false;
+            }
+            boneMap[i] = uint16_t(joint);
+        }
+        skin.BoneCount = m_Skeleton.Joints.size();
+    }
+
+    // 頂点優先に並べ替えて上位の影響を選択.
+    auto& packed = skin.Packed;
+    PackSkinWeights(pSrcMesh, count, packed, boneMap.empty() ? nullptr : boneMap.data());
+
+    auto& boneIndices = skin.BoneIndices;
+    auto& boneWeights = skin.BoneWeights;
+
+    // ResMesh には上位4つまでを格納する.
+    boneIndices.resize(pSrcMesh->mNumVertices);
+    boneWeights.resize(pSrcMesh->mNumVertices);
+
+    for(size_t i=0; i<pSrcMesh->mNumVertices; ++i)
+    {
+        uint16_t indices[4] = {};
+        float    weights[4] = {};
+
+        auto sum = 0.0f;
+        for(auto k=0u; k<count && k<4; ++k)
+        {
+            indices[k] = packed.BoneIndices[i * count + k];
+            weights[k] = packed.BoneWeights[i * count + k];
+            sum += weights[k];
+        }
+
+        // 4つを超える場合は再正規化する.
+        if (count > 4 && sum > 0.0f)
+        {
+            for(auto k=0; k<4; ++k)
+            { weights[k] /= sum; }
+        }
+
+        boneIndices[i] = asdx::ResBoneIndex(indices[0], indices[1], indices[2], indices[3]);
+        boneWeights[i] = asdx::Vector4(weights[0], weights[1], weights[2], weights[3]);
+    }
+
+    // 指定された影響数とフォーマットでエンコード.
+    auto& stream = skin.Stream;
+    stream.InfluenceCount   = count;
+    stream.WeightFormat     = m_Option.SkinWeightFormat;
+    stream.IndexSize        = sizeof(uint16_t);
+    stream.Stride           = GetSkinStride(count, m_Option.SkinWeightFormat, stream.IndexSize);
+    auto quantizeError      = EncodeSkin(packed, m_Option.SkinWeightFormat, stream.Data);
+
+    auto avgDropped = (packed.TruncatedVertexCount > 0)
+        ? packed.SumDroppedWeight / double(packed.TruncatedVertexCount)
+        : 0.0;
+
+    ILOGA("Info : Skin Packed. name = %s, influences = %u, truncated vertices = %zu / %u, dropped weight (max = %f, avg = %f), quantize error = %f",
+        pSrcMesh->mName.C_Str(),
+        count,
+        packed.TruncatedVertexCount,
+        pSrcMesh->mNumVertices,
+        packed.MaxDroppedWeight,
+        avgDropped,
+        quantizeError);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュを構築します.
+//-----------------------------------------------------------------------------
+void MeshLoader::BuildMesh
+(
+    asdx::ResModel&                         model,
+    const aiMesh*                           pSrcMesh,
+    const uint32_t*                         pFaces,
+    size_t                                  faceCount,
+    uint32_t                                meshHash,
+    uint32_t                                matHash,
+    const SkinSource&                       skin,
+    const std::vector<uint16_t>*            pPalette,
+    const std::vector<uint32_t>*            pTangentSpaces
+)
+{
+    if (faceCount == 0)
+    { return; }
+
+    asdx::ResMesh dstMesh;
+    dstMesh.MeshHash        = meshHash;
+    dstMesh.MatrerialHash   = matHash;
+
+    // 頂点インデックスのメモリを確保.
+    std::vector<uint32_t>   vertexIndices;
+    vertexIndices.resize(faceCount * 3);
+
+    for(size_t i=0; i<faceCount; ++i)
+    {
+        const auto& face = pSrcMesh->mFaces[(pFaces != nullptr) ? pFaces[i] : i];
+        assert(face.mNumIndices == 3);  // 三角形化しているので必ず3になっている.
+
+        vertexIndices[i * 3 + 0] = face.mIndices[0];
+        vertexIndices[i * 3 + 1] = face.mIndices[1];
+        vertexIndices[i * 3 + 2] = face.mIndices[2];
+    }
+
+    // 部分メッシュの場合は参照している頂点だけを取り出す.
+    std::vector<uint32_t> vertexMap;
+    if (pFaces != nullptr)
+    {
+        vertexMap = vertexIndices;
+        std::sort(vertexMap.begin(), vertexMap.end());
+        vertexMap.erase(std::unique(vertexMap.begin(), vertexMap.end()), vertexMap.end());
+        vertexMap.shrink_to_fit();
+
+        for(auto& index : vertexIndices)
+        { index = uint32_t(std::lower_bound(vertexMap.begin(), vertexMap.end(), index) - vertexMap.begin()); }
+    }
+
+    const size_t vertexCount = (pFaces != nullptr) ? vertexMap.size() : pSrcMesh->mNumVertices;
+
+    // Assimpが接線を出力していない場合は重複除去後にコンバータ側で生成する.
+    // 分割前に生成済みの場合はそれを使う.
+    auto generateTangent = NeedsTangentGeneration(pSrcMesh) && (pTangentSpaces == nullptr);
+
+    std::vector<asdx::Vector3> normals;
+    std::vector<asdx::Vector2> texcoords;
+
+    // 頂点データのメモリを確保.
+    dstMesh.Positions.resize(vertexCount);
+    if (generateTangent)
+    {
+        normals  .resize(vertexCount);
+        texcoords.resize(vertexCount);
+    }
+    else if (pSrcMesh->HasNormals())
+    { dstMesh.TangentSpaces.resize(vertexCount); }
+
+    if (pTangentSpaces != nullptr)
+    {
+        for(size_t i=0; i<vertexCount; ++i)
+        { dstMesh.TangentSpaces[i] = (*pTangentSpaces)[(pFaces != nullptr) ? vertexMap[i] : i]; }
+    }
+
+    for(auto i=0; i<4; ++i)
+    {
+        if (pSrcMesh->HasTextureCoords(i))
+        { dstMesh.TexCoords[i].resize(vertexCount); }
+    }
+
+    if (pSrcMesh->HasVertexColors(0))
+    { dstMesh.Colors.resize(vertexCount); }
+
+    if (!skin.BoneIndices.empty())
+    {
+        dstMesh.BoneIndices.resize(vertexCount);
+        dstMesh.BoneWeights.resize(vertexCount);
+    }
+
+    // ボーンパレットを使う場合はスキニングデータのみパレット内の番号に変換する.
+    // パレットはスキニングデータにしか格納されないので，ResMesh のボーン番号は全体の番号のまま残す.
+    std::vector<uint8_t> paletteMap;
+    if (pPalette != nullptr)
+    {
+        paletteMap.resize(skin.BoneCount, 0);
+        for(size_t i=0; i<pPalette->size(); ++i)
+        { paletteMap[(*pPalette)[i]] = uint8_t(i); }
+    }
+
+    auto toLocal = [&](uint16_t bone, float weight)
+    {
+        // 未使用のスロットはパレット外のボーンを指さないように0にする.
+        if (paletteMap.empty())
+        { return bone; }
+        return (weight > 0.0f) ? uint16_t(paletteMap[bone]) : uint16_t(0);
+    };
+
+    const auto& srcSkin = skin.Stream;
+
+    SkinStream dstSkin;
+    if (!srcSkin.Data.empty())
+    {
+        dstSkin.MeshHash        = meshHash;
+        dstSkin.InfluenceCount  = srcSkin.InfluenceCount;
+        dstSkin.WeightFormat    = srcSkin.WeightFormat;
+        dstSkin.IndexSize       = (pPalette != nullptr) ? sizeof(uint8_t) : srcSkin.IndexSize;
+        dstSkin.Stride          = GetSkinStride(dstSkin.InfluenceCount, dstSkin.WeightFormat, dstSkin.IndexSize);
+        dstSkin.Data.resize(vertexCount * dstSkin.Stride);
+
+        if (pPalette != nullptr)
+        { dstSkin.BonePalette = *pPalette; }
+    }
+
+    for(size_t i=0; i<vertexCount; ++i)
+    {
+        auto v = (pFaces != nullptr) ? vertexMap[i] : uint32_t(i);
+
+        auto pPosition  = &(pSrcMesh->mVertices[v]);
+        dstMesh.Positions[i] = asdx::Vector3(pPosition->x, pPosition->y, pPosition->z);
+
+        if (pSrcMesh->HasNormals() && pSrcMesh->HasTangentsAndBitangents())
+        {
+            auto pNormal = &(pSrcMesh->mNormals[v]);
+            auto pTangent = &(pSrcMesh->mTangents[v]);
+
+            auto N = asdx::Vector3(pNormal->x, pNormal->y, pNormal->z);
+            auto T = asdx::Vector3(pTangent->x, pTangent->y, pTangent->z);
+
+            dstMesh.TangentSpaces[i] = EncodeTBN(N, T, 0);
+        }
+
+        if (generateTangent)
+        {
+            auto pNormal   = &(pSrcMesh->mNormals[v]);
+            auto pTexCoord = &(pSrcMesh->mTextureCoords[0][v]);
+            normals  [i] = asdx::Vector3(pNormal->x, pNormal->y, pNormal->z);
+            texcoords[i] = asdx::Vector2(pTexCoord->x, pTexCoord->y);
+        }
+        else if (pSrcMesh->HasNormals() && !pSrcMesh->HasTangentsAndBitangents() && pTangentSpaces == nullptr)
+        {
+            auto pNormal = &(pSrcMesh->mNormals[v]);
+            auto N = asdx::Vector3(pNormal->x, pNormal->y, pNormal->z);
+            asdx::Vector3 T, B;
+            asdx::CalcONB(N, T, B);
+
+            dstMesh.TangentSpaces[i] = EncodeTBN(N, T, 0);
+        }
+
+        for(auto j=0; j<4; ++j)
+        {
+            if (pSrcMesh->HasTextureCoords(j))
+            {
+                auto pTexCorod = &(pSrcMesh->mTextureCoords[j][v]);
+                dstMesh.TexCoords[j][i] = asdx::EncodeHalf2(asdx::Vector2(pTexCorod->x, pTexCorod->y)).u;
+            }
+        }
+
+        if (pSrcMesh->HasVertexColors(0))
+        {
+            auto pColor = &(pSrcMesh->mColors[0][v]);
+            dstMesh.Colors[i] = asdx::EncodeUnorm4(asdx::Vector4(pColor->r, pColor->g, pColor->b, pColor->a));
+        }
+
+        if (!skin.BoneIndices.empty())
+        {
+            const auto& index  = skin.BoneIndices[v];
+            const auto& weight = skin.BoneWeights[v];
+
+            dstMesh.BoneIndices[i] = index;
+            dstMesh.BoneWeights[i] = weight;
+        }
+
+        if (!dstSkin.Data.empty())
+        {
+            auto pSrc = &srcSkin.Data[v * srcSkin.Stride];
+            auto pDst = &dstSkin.Data[i * dstSkin.Stride];
+
+            if (pPalette == nullptr)
+            { memcpy(pDst, pSrc, srcSkin.Stride); }
+            else
+            {
+                // ボーン番号を8bitのパレット番号に詰め直し，重みはそのままコピー.
+                auto count = srcSkin.InfluenceCount;
+                for(auto k=0u; k<count; ++k)
+                {
+                    uint16_t bone;
+                    memcpy(&bone, pSrc + k * sizeof(uint16_t), sizeof(bone));
+                    pDst[k] = uint8_t(toLocal(bone, skin.Packed.BoneWeights[v * count + k]));
+                }
+
+                memcpy(
+                    pDst + count * sizeof(uint8_t),
+                    pSrc + count * sizeof(uint16_t),
+                    count * GetSkinWeightSize(srcSkin.WeightFormat));
+            }
+        }
+    }
+
+    // 最適化.
+    {
+        std::vector<uint32_t> remap(dstMesh.Positions.size());
+
+        // 重複データを削除するための再マッピング用インデックスを生成.
+        meshopt_Stream streams[10] = {};
+        streams[0].data     = dstMesh.Positions.data();
+        streams[0].size     = sizeof(dstMesh.Positions[0]);
+        streams[0].stride   = sizeof(dstMesh.Positions[0]);
+
+        auto idx = 1;
+        if (!dstMesh.TangentSpaces.empty())
+        {
+            streams[idx].data   = dstMesh.TangentSpaces.data();
+            streams[idx].size   = sizeof(dstMesh.TangentSpaces[0]);
+            streams[idx].stride = sizeof(dstMesh.TangentSpaces[0]);
+            idx++;
+        }
+
+        if (!normals.empty())
+        {
+            streams[idx].data   = normals.data();
+            streams[idx].size   = sizeof(normals[0]);
+            streams[idx].stride = sizeof(normals[0]);
+            idx++;
+        }
+
+        if (!dstMesh.Colors.empty())
+        {
+            streams[idx].data   = dstMesh.Colors.data();
+            streams[idx].size   = sizeof(dstMesh.Colors[0]);
+            streams[idx].stride = sizeof(dstMesh.Colors[0]);
+            idx++;
         }
 
-        // テクスチャ座標.
         for(auto i=0; i<4; ++i)
         {
             if (!dstMesh.TexCoords[i].empty())
             {
-                meshopt_remapVertexBuffer(
-                    dstMesh.TexCoords[i].data(),
-                    dstMesh.TexCoords[i].data(),
-                    dstMesh.TexCoords[i].size(),
-                    sizeof(dstMesh.TexCoords[i][0]),
-                    remap.data());
-
-                dstMesh.TexCoords[i].resize(vertexCount);
-                dstMesh.TexCoords[i].shrink_to_fit();
+                streams[idx].data   = dstMesh.TexCoords[i].data();
+                streams[idx].size   = sizeof(dstMesh.TexCoords[i][0]);
+                streams[idx].stride = sizeof(dstMesh.TexCoords[i][0]);
+                idx++;
             }
         }
 
-        // ボーン番号.
         if (!dstMesh.BoneIndices.empty())
         {
-            meshopt_remapVertexBuffer(
-                dstMesh.BoneIndices.data(),
-                dstMesh.BoneIndices.data(),
-                dstMesh.BoneIndices.size(),
-                sizeof(dstMesh.BoneIndices[0]),
-                remap.data());
-
-            dstMesh.BoneIndices.resize(vertexCount);
-            dstMesh.BoneIndices.shrink_to_fit();
+            streams[idx].data   = dstMesh.BoneIndices.data();
+            streams[idx].size   = sizeof(dstMesh.BoneIndices[0]);
+            streams[idx].stride = sizeof(dstMesh.BoneIndices[0]);
+            idx++;
         }
 
-        // ボーンウェイト.
         if (!dstMesh.BoneWeights.empty())
         {
-            meshopt_remapVertexBuffer(
-                dstMesh.BoneWeights.data(),
-                dstMesh.BoneWeights.data(),
-                dstMesh.BoneWeights.size(),
-                sizeof(dstMesh.BoneWeights[0]),
-                remap.data());
-
-            dstMesh.BoneWeights.resize(vertexCount);
-            dstMesh.BoneWeights.shrink_to_fit();
+            streams[idx].data   = dstMesh.BoneWeights.data();
+            streams[idx].size   = sizeof(dstMesh.BoneWeights[0]);
+            streams[idx].stride = sizeof(dstMesh.BoneWeights[0]);
+            idx++;
         }
 
-        std::vector<uint32_t> indices(vertexIndices.size());
+        if (!dstSkin.Data.empty())
+        {
+            streams[idx].data   = dstSkin.Data.data();
+            streams[idx].size   = dstSkin.Stride;
+            streams[idx].stride = dstSkin.Stride;
+            idx++;
+        }
 
-        // 頂点インデックスを再マッピング.
-        meshopt_remapIndexBuffer(
-            indices.data(),
+        auto vertexCount = meshopt_generateVertexRemapMulti(
+            remap.data(),
             vertexIndices.data(),
             vertexIndices.size(),
-            remap.data());
+            dstMesh.Positions.size(),
+            streams,
+            idx
+        );
 
-        // 頂点フェッチ最適化.
-        meshopt_optimizeVertexFetchRemap(
-            remap.data(),
-            indices.data(),
-            indices.size(),
-            vertexCount);
+        // 重複を除去.
+        RemapVertexStreams(dstMesh, remap.data(), vertexCount);
+        RemapStream(dstSkin.Data, dstSkin.Stride, remap.data(), vertexCount);
+        RemapStream(normals,   remap.data(), vertexCount);
+        RemapStream(texcoords, remap.data(), vertexCount);
 
-        // もう一度実行する.
+        // 頂点インデックスを再マッピング.
         meshopt_remapIndexBuffer(
             vertexIndices.data(),
-            indices.data(),
-            indices.size(),
+            vertexIndices.data(),
+            vertexIndices.size(),
             remap.data());
 
-        // 不要になったメモリを解放.
-        indices.clear();
-        indices.shrink_to_fit();
+        // 接線空間を生成.
+        if (generateTangent)
+        {
+            dstMesh.TangentSpaces.resize(vertexCount);
+            GenerateTangentSpaces(
+                vertexCount,
+                dstMesh.Positions.data(),
+                normals.data(),
+                texcoords.data(),
+                vertexIndices.size(),
+                vertexIndices.data(),
+                dstMesh.TangentSpaces.data());
+
+            // 不要になったメモリを解放.
+            normals  .clear();
+            normals  .shrink_to_fit();
+            texcoords.clear();
+            texcoords.shrink_to_fit();
+        }
 
         // 頂点キャッシュ最適化.
         meshopt_optimizeVertexCache(
@@ -457,85 +1929,121 @@ void MeshLoader::ParseMesh(asdx::ResModel& model, const aiMesh* pSrcMesh)
             vertexIndices.data(),
             vertexIndices.size(),
             vertexCount);
-    }
-
-    // メッシュレット生成.
-    {
-        // see. https://developer.nvidia.com/blog/introduction-turing-mesh-shaders/
-        const size_t kMaxVertices   = 64;
-        const size_t kMaxPrimitives = 126;
 
-        std::vector<meshopt_Meshlet> meshlets(
-            meshopt_buildMeshletsBound(
-                vertexIndices.size(),
-                kMaxVertices,
-                kMaxPrimitives));
-        meshlets.resize(
-            meshopt_buildMeshlets(
-                meshlets.data(),
-                vertexIndices.data(),
-                vertexIndices.size(),
-                dstMesh.Positions.size(),
-                kMaxVertices,
-                kMaxPrimitives));
-
-        // 最大値でメモリを予約.
-        dstMesh.Indices     .reserve(meshlets.size() * kMaxVertices);
-        dstMesh.Primitives  .reserve(meshlets.size() * kMaxPrimitives);
-
-        for(auto& meshlet : meshlets)
-        {
-            auto vertexOffset    = uint32_t(dstMesh.Indices     .size());
-            auto primitiveOffset = uint32_t(dstMesh.Primitives  .size());
+        // 頂点フェッチ最適化.
+        meshopt_optimizeVertexFetchRemap(
+            remap.data(),
+            vertexIndices.data(),
+            vertexIndices.size(),
+            vertexCount);
 
-            for(auto i=0u; i<meshlet.vertex_count; ++i)
-            { dstMesh.Indices.push_back(meshlet.vertices[i]); }
+        // 頂点データとインデックスの両方に適用する.
+        RemapVertexStreams(dstMesh, remap.data(), vertexCount);
+        RemapStream(dstSkin.Data, dstSkin.Stride, remap.data(), vertexCount);
 
-            for(auto i=0; i<meshlet.triangle_count; ++i)
-            {
-                asdx::ResPrimitive tris = {};
-                tris.Index1 = meshlet.indices[i][0];
-                tris.Index0 = meshlet.indices[i][1];
-                tris.Index2 = meshlet.indices[i][2];
-                dstMesh.Primitives.push_back(tris);
-            }
+        meshopt_remapIndexBuffer(
+            vertexIndices.data(),
+            vertexIndices.data(),
+            vertexIndices.size(),
+            remap.data());
+    }
 
-            auto bounds = meshopt_computeMeshletBounds(
-                &meshlet, 
-                &dstMesh.Positions[0].x,
-                dstMesh.Positions.size(),
-                sizeof(dstMesh.Positions[0]));
+    // メッシュレット生成.
+    BuildMeshlets(
+        vertexIndices,
+        dstMesh.Positions,
+        dstMesh.Indices,
+        dstMesh.Primitives,
+        dstMesh.Meshlets,
+        dstMesh.CullingInfos);
 
-            // メッシュレットデータ設定.
-            asdx::ResMeshlet m = {};
-            m.VertexCount       = meshlet.vertex_count;
-            m.VertexOffset      = vertexOffset;
-            m.PrimitiveCount    = meshlet.triangle_count;
-            m.PrimitiveOffset   = primitiveOffset;
+    // 深度・シャドウパス用に位置座標のみで溶接したメッシュを生成.
+    // スキンメッシュは重みの異なる頂点を溶接できないため対象外.
+    if (m_Option.GenerateShadowMesh && dstMesh.BoneIndices.empty() && dstSkin.Data.empty())
+    { BuildShadowMesh(dstMesh, vertexIndices); }
 
-            dstMesh.Meshlets.push_back(m);
+    if (!dstSkin.Data.empty())
+    { m_Skins.push_back(std::move(dstSkin)); }
 
-            // カリングデータ設定.
-            auto normalCone = asdx::Vector4(
-                bounds.cone_axis[0] * 0.5f + 0.5f,
-                bounds.cone_axis[1] * 0.5f + 0.5f,
-                bounds.cone_axis[2] * 0.5f + 0.5f,
-                bounds.cone_cutoff * 0.5f + 0.5f);
+    m_MeshMaterials.push_back(std::make_pair(dstMesh.MeshHash, dstMesh.MatrerialHash));
 
-            asdx::ResCullingInfo c = {};
-            c.BoundingSphere = asdx::Vector4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius);
-            c.NormalCone     = asdx::EncodeUnorm4(normalCone);
-            dstMesh.CullingInfos.push_back(c);
+    if (m_Option.MeshOutput)
+    {
+        // 出力したら破棄して，構築中のメッシュをメモリに残さない.
+        // シャドウメッシュとスキニングデータは蓄積されるので呼び出し側で併用を制限する.
+        if (!m_Option.MeshOutput(dstMesh))
+        {
+            ELOGA("Error : Mesh Output Failed. mesh = 0x%08x", dstMesh.MeshHash);
+            m_Canceled = true;
         }
-
-        // サイズ最適化.
-        dstMesh.Indices     .shrink_to_fit();
-        dstMesh.Primitives  .shrink_to_fit();
-        dstMesh.Meshlets    .shrink_to_fit();
-        dstMesh.CullingInfos.shrink_to_fit();
     }
+    else
+    { model.Meshes.push_back(std::move(dstMesh)); }
+}
 
-    model.Meshes.push_back(dstMesh);
+//-----------------------------------------------------------------------------
+//      位置座標のみで溶接したメッシュを構築します.
+//-----------------------------------------------------------------------------
+void MeshLoader::BuildShadowMesh(const asdx::ResMesh& mesh, const std::vector<uint32_t>& triangles)
+{
+    if (mesh.Positions.empty() || triangles.empty())
+    { return; }
+
+    ShadowMesh shadow;
+    shadow.MeshHash = mesh.MeshHash;
+
+    // UVや法線の継ぎ目で分かれた頂点を位置座標が同じものどうしで統合する.
+    std::vector<uint32_t> remap(mesh.Positions.size());
+    auto vertexCount = meshopt_generateVertexRemap(
+        remap.data(),
+        triangles.data(),
+        triangles.size(),
+        &mesh.Positions[0].x,
+        mesh.Positions.size(),
+        sizeof(mesh.Positions[0]));
+
+    std::vector<asdx::Vector3> positions(vertexCount);
+    meshopt_remapVertexBuffer(
+        positions.data(),
+        mesh.Positions.data(),
+        mesh.Positions.size(),
+        sizeof(mesh.Positions[0]),
+        remap.data());
+
+    shadow.TriangleIndices.resize(triangles.size());
+    meshopt_remapIndexBuffer(
+        shadow.TriangleIndices.data(),
+        triangles.data(),
+        triangles.size(),
+        remap.data());
+
+    // 頂点キャッシュ最適化.
+    meshopt_optimizeVertexCache(
+        shadow.TriangleIndices.data(),
+        shadow.TriangleIndices.data(),
+        shadow.TriangleIndices.size(),
+        vertexCount);
+
+    // 頂点フェッチ最適化.
+    shadow.Positions.resize(vertexCount);
+    shadow.Positions.resize(
+        meshopt_optimizeVertexFetch(
+            shadow.Positions.data(),
+            shadow.TriangleIndices.data(),
+            shadow.TriangleIndices.size(),
+            positions.data(),
+            vertexCount,
+            sizeof(positions[0])));
+
+    BuildMeshlets(
+        shadow.TriangleIndices,
+        shadow.Positions,
+        shadow.Indices,
+        shadow.Primitives,
+        shadow.Meshlets,
+        shadow.CullingInfos);
+
+    m_ShadowMeshes.push_back(std::move(shadow));
 }
 
 //-----------------------------------------------------------------------------
@@ -556,7 +2064,7 @@ void MeshLoader::ParseMaterial(const aiMaterial* pSrcMaterial)
     }
 
     // テクスチャ取得.
-    for(uint32_t t = aiTextureType_NONE; t < aiTextureType_UNKNOWN; ++t)
+    for(uint32_t t = aiTextureType_NONE; t <= aiTextureType_UNKNOWN; ++t)
     {
         auto type = aiTextureType(t);
         auto count = pSrcMaterial->GetTextureCount(type);
@@ -568,19 +2076,537 @@ void MeshLoader::ParseMaterial(const aiMaterial* pSrcMaterial)
             {
                 TextureInfo texture;
                 texture.Usage   = TEXTURE_USAGE(type);
-                texture.Path    = path.C_Str();
-                dstMaterial.Textures.push_back(texture);
+                texture.PathId  = AddTexture(path.C_Str());
+
+                // glTF はベースカラーを2つのスロットに同じパスで格納するので重複を除く.
+                auto itr = std::find_if(dstMaterial.Textures.begin(), dstMaterial.Textures.end(),
+                    [&](const TextureInfo& info)
+                    { return info.Usage == texture.Usage && info.PathId == texture.PathId; });
+                if (itr == dstMaterial.Textures.end())
+                { dstMaterial.Textures.push_back(texture); }
             }
         }
     }
 
+    // パラメータ取得.
+    ParseMaterialParam(pSrcMaterial, dstMaterial);
+    dstMaterial.ContentHash = CalcContentHash(dstMaterial);
+
     dstMaterial.Textures.shrink_to_fit();
     m_Materials.push_back(dstMaterial);
 }
 
+//-----------------------------------------------------------------------------
+//      マテリアルパラメータを解析します.
+//-----------------------------------------------------------------------------
+void MeshLoader::ParseMaterialParam(const aiMaterial* pSrcMaterial, Material& dstMaterial)
+{
+    auto hasTexture = [&](TEXTURE_USAGE usage)
+    {
+        for(auto& texture : dstMaterial.Textures)
+        {
+            if (texture.Usage == usage)
+            { return true; }
+        }
+        return false;
+    };
+
+    // ベースカラー. glTF の値を優先する.
+    aiColor4D color;
+    if (pSrcMaterial->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_BASE_COLOR_FACTOR, color) == AI_SUCCESS)
+    { dstMaterial.BaseColor = asdx::Vector4(color.r, color.g, color.b, color.a); }
+    else if (pSrcMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS)
+    { dstMaterial.BaseColor = asdx::Vector4(color.r, color.g, color.b, 1.0f); }
+
+    auto isGltf = false;
+    {
+        float metallic;
+        if (pSrcMaterial->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLIC_FACTOR, metallic) == AI_SUCCESS)
+        {
+            dstMaterial.Metallic = metallic;
+            isGltf = true;
+        }
+
+        float roughness;
+        if (pSrcMaterial->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_ROUGHNESS_FACTOR, roughness) == AI_SUCCESS)
+        {
+            dstMaterial.Roughness = roughness;
+            isGltf = true;
+        }
+    }
+
+    // 従来形式の場合は光沢度から粗さを求める(Blinn-Phong からの近似).
+    if (!isGltf)
+    {
+        float shininess;
+        if (pSrcMaterial->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS && shininess > 0.0f)
+        { dstMaterial.Roughness = std::min(1.0f, sqrtf(2.0f / (shininess + 2.0f))); }
+
+        float opacity;
+        if (pSrcMaterial->Get(AI_MATKEY_OPACITY, opacity) == AI_SUCCESS)
+        { dstMaterial.BaseColor.w = opacity; }
+    }
+
+    aiColor3D emissive;
+    if (pSrcMaterial->Get(AI_MATKEY_COLOR_EMISSIVE, emissive) == AI_SUCCESS)
+    { dstMaterial.Emissive = asdx::Vector3(emissive.r, emissive.g, emissive.b); }
+
+    // アルファモード.
+    aiString alphaMode;
+    if (pSrcMaterial->Get(AI_MATKEY_GLTF_ALPHAMODE, alphaMode) == AI_SUCCESS)
+    {
+        if (strcmp(alphaMode.C_Str(), "MASK") == 0)
+        { dstMaterial.AlphaMode = ALPHA_MODE_MASK; }
+        else if (strcmp(alphaMode.C_Str(), "BLEND") == 0)
+        { dstMaterial.AlphaMode = ALPHA_MODE_BLEND; }
+
+        float cutoff;
+        if (pSrcMaterial->Get(AI_MATKEY_GLTF_ALPHACUTOFF, cutoff) == AI_SUCCESS)
+        { dstMaterial.AlphaCutoff = cutoff; }
+    }
+    else if (dstMaterial.BaseColor.w < 1.0f)
+    { dstMaterial.AlphaMode = ALPHA_MODE_BLEND; }
+    else if (hasTexture(TEXTURE_USAGE_OPACITY))
+    { dstMaterial.AlphaMode = ALPHA_MODE_MASK; }
+
+    int twoSided;
+    if (pSrcMaterial->Get(AI_MATKEY_TWOSIDED, twoSided) == AI_SUCCESS)
+    { dstMaterial.TwoSided = (twoSided != 0); }
+
+    // UV変換はベースカラーテクスチャのものを代表とする.
+    aiUVTransform transform;
+    if (pSrcMaterial->Get(AI_MATKEY_UVTRANSFORM(aiTextureType_DIFFUSE, 0), transform) == AI_SUCCESS)
+    {
+        dstMaterial.UVScale    = asdx::Vector2(transform.mScaling.x, transform.mScaling.y);
+        dstMaterial.UVOffset   = asdx::Vector2(transform.mTranslation.x, transform.mTranslation.y);
+        dstMaterial.UVRotation = transform.mRotation;
+    }
+
+    // シェーダバリエーション選択用の特徴フラグ.
+    uint32_t features = 0;
+    if (hasTexture(TEXTURE_USAGE_DIFFUSE))
+    { features |= MATERIAL_FEATURE_BASE_COLOR_MAP; }
+    if (hasTexture(TEXTURE_USAGE_NORMAL))
+    { features |= MATERIAL_FEATURE_NORMAL_MAP; }
+    if (hasTexture(TEXTURE_USAGE_UNKNOWN))
+    { features |= MATERIAL_FEATURE_METALLIC_ROUGHNESS_MAP; }
+    if (hasTexture(TEXTURE_USAGE_SPECULAR))
+    { features |= MATERIAL_FEATURE_SPECULAR_MAP; }
+    if (hasTexture(TEXTURE_USAGE_LIGHTMAP) || hasTexture(TEXTURE_USAGE_AMBIENT))
+    { features |= MATERIAL_FEATURE_OCCLUSION_MAP; }
+    if (hasTexture(TEXTURE_USAGE_EMISSIVE))
+    { features |= MATERIAL_FEATURE_EMISSIVE_MAP | MATERIAL_FEATURE_EMISSIVE; }
+    if (dstMaterial.Emissive.x > 0.0f || dstMaterial.Emissive.y > 0.0f || dstMaterial.Emissive.z > 0.0f)
+    { features |= MATERIAL_FEATURE_EMISSIVE; }
+    if (hasTexture(TEXTURE_USAGE_OPACITY))
+    { features |= MATERIAL_FEATURE_OPACITY_MAP; }
+    if (dstMaterial.AlphaMode == ALPHA_MODE_MASK)
+    { features |= MATERIAL_FEATURE_ALPHA_TEST; }
+    if (dstMaterial.AlphaMode == ALPHA_MODE_BLEND)
+    { features |= MATERIAL_FEATURE_ALPHA_BLEND; }
+    if (dstMaterial.TwoSided)
+    { features |= MATERIAL_FEATURE_TWO_SIDED; }
+    if (dstMaterial.UVScale.x != 1.0f || dstMaterial.UVScale.y != 1.0f
+     || dstMaterial.UVOffset.x != 0.0f || dstMaterial.UVOffset.y != 0.0f
+     || dstMaterial.UVRotation != 0.0f)
+    { features |= MATERIAL_FEATURE_UV_TRANSFORM; }
+
+    dstMaterial.Features = features;
+}
+
+//-----------------------------------------------------------------------------
+//      内容が同じマテリアルを統合します.
+//-----------------------------------------------------------------------------
+void MeshLoader::MergeMaterials()
+{
+    // シーン内のマテリアル番号から内容ハッシュへの対応表.
+    // m_Materials はシーンと同じ順番で格納されている.
+    auto& remap = m_MaterialRemap;
+    remap.resize(m_Materials.size());
+    std::unordered_map<uint32_t, size_t> unique;
+
+    std::vector<Material> merged;
+    merged.reserve(m_Materials.size());
+
+    for(size_t i=0; i<m_Materials.size(); ++i)
+    {
+        auto& material = m_Materials[i];
+        remap[i] = material.ContentHash;
+
+        // 最初に見つかったものの名前を残す.
+        if (unique.find(material.ContentHash) != unique.end())
+        { continue; }
+
+        unique[material.ContentHash] = merged.size();
+        merged.push_back(std::move(material));
+        merged.back().Hash = merged.back().ContentHash;
+    }
+
+    ILOGA("Info : Material Merged. count = %zu -> %zu", m_Materials.size(), merged.size());
+    m_Materials = std::move(merged);
+}
+
+//-----------------------------------------------------------------------------
+//      テクスチャパスを登録します.
+//-----------------------------------------------------------------------------
+uint32_t MeshLoader::AddTexture
+(
+    const char*                                         path,
+    const std::shared_ptr<const std::vector<uint8_t>>&  pEmbedded
+)
+{
+    if (path[0] == '*' && pEmbedded == nullptr)
+    { return AddEmbeddedTexture(uint32_t(atoi(path + 1))); }
+
+    auto id = asdx::Fnv1a(path).GetHash();
+
+    auto itr = m_TextureIndices.find(id);
+    if (itr != m_TextureIndices.end())
+    {
+        // IDは安定させたいので衝突は報告のみ行う.
+        const auto& entry = m_Textures[itr->second];
+        if (entry.Path != path)
+        { ELOGA("Error : Texture Path Hash Collision. id = %u, path = %s, %s", id, entry.Path.c_str(), path); }
+        return id;
+    }
+
+    TextureEntry entry;
+    entry.Id       = id;
+    entry.Path     = path;
+    entry.Embedded = pEmbedded;
+
+    m_TextureIndices[id] = uint32_t(m_Textures.size());
+    m_Textures.push_back(entry);
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+//      埋め込みテクスチャを登録します.
+//-----------------------------------------------------------------------------
+uint32_t MeshLoader::AddEmbeddedTexture(uint32_t index)
+{
+    auto itr = m_EmbeddedIds.find(index);
+    if (itr != m_EmbeddedIds.end())
+    { return itr->second; }
+
+    if (index >= m_pScene->mNumTextures)
+    {
+        ELOGA("Error : Embedded Texture Not Found. index = %u", index);
+        return AddTexture(("*" + std::to_string(index)).c_str(), std::make_shared<std::vector<uint8_t>>());
+    }
+
+    // シーンを解放する前にファイルイメージとして複製しておく.
+    auto pSrcTexture = m_pScene->mTextures[index];
+    auto pData = std::make_shared<std::vector<uint8_t>>();
+    std::string ext;
+    if (pSrcTexture->mHeight == 0)
+    {
+        // 圧縮済みの場合は mWidth がバイト数.
+        auto pBytes = reinterpret_cast<const uint8_t*>(pSrcTexture->pcData);
+        pData->assign(pBytes, pBytes + pSrcTexture->mWidth);
+
+        for(auto i=0; i<4 && pSrcTexture->achFormatHint[i] != '\0'; ++i)
+        { ext += char(tolower(pSrcTexture->achFormatHint[i])); }
+
+        if (ext == "jpeg")
+        { ext = "jpg"; }
+        if (ext.empty())
+        { ext = "bin"; }
+    }
+    else
+    {
+        // 非圧縮の場合はそのまま読めるように TGA にする.
+        EncodeTga(pSrcTexture->mWidth, pSrcTexture->mHeight, pSrcTexture->pcData, *pData);
+        ext = "tga";
+    }
+
+    // 外部ファイルと区別できるように入力ファイル名を付ける.
+    auto path = m_ModelName + "_embedded" + std::to_string(index) + "." + ext;
+
+    if (!m_Option.EmbeddedTextureDir.empty())
+    {
+        auto dir = m_Option.EmbeddedTextureDir;
+        if (dir.back() != '/' && dir.back() != '\\')
+        { dir += "/"; }
+        path = dir + path;
+
+        FILE* pFile;
+        auto err = fopen_s(&pFile, path.c_str(), "wb");
+        if (err != 0)
+        { ELOGA("Error : File Open Failed. path = %s", path.c_str()); }
+        else
+        {
+            fwrite(pData->data(), 1, pData->size(), pFile);
+            fclose(pFile);
+            ILOGA("Info : Embedded Texture Extracted. index = %u, path = %s", index, path.c_str());
+        }
+    }
+
+    auto id = AddTexture(path.c_str(), pData);
+    m_EmbeddedIds[index] = id;
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+//      テクスチャの参照元を構築します.
+//-----------------------------------------------------------------------------
+void MeshLoader::BuildTextureDependencies()
+{
+    std::unordered_map<uint32_t, const Material*> materials;
+    for(auto& material : m_Materials)
+    { materials[material.Hash] = &material; }
+
+    // 同じテクスチャを複数の用途で参照していても1回だけ登録する.
+    auto addUnique = [](std::vector<uint32_t>& values, uint32_t value)
+    {
+        if (std::find(values.begin(), values.end(), value) == values.end())
+        { values.push_back(value); }
+    };
+
+    for(auto& material : m_Materials)
+    {
+        for(auto& texture : material.Textures)
+        { addUnique(m_Textures[m_TextureIndices[texture.PathId]].Materials, material.Hash); }
+    }
+
+    // メッシュは逐次出力されている場合があるので記録したハッシュを使う.
+    for(auto& mesh : m_MeshMaterials)
+    {
+        auto itr = materials.find(mesh.second);
+        if (itr == materials.end())
+        { continue; }
+
+        for(auto& texture : itr->second->Textures)
+        { addUnique(m_Textures[m_TextureIndices[texture.PathId]].Meshes, mesh.first); }
+    }
+
+    for(auto& entry : m_Textures)
+    {
+        entry.Materials.shrink_to_fit();
+        entry.Meshes   .shrink_to_fit();
+    }
+    m_Textures.shrink_to_fit();
+}
+
 //-----------------------------------------------------------------------------
 //      マテリアルを取得します.
 //-----------------------------------------------------------------------------
 const std::vector<Material>& MeshLoader::GetMaterials() const
 { return m_Materials; }
 
+//-----------------------------------------------------------------------------
+//      スキニングデータを取得します.
+//-----------------------------------------------------------------------------
+const std::vector<SkinStream>& MeshLoader::GetSkins() const
+{ return m_Skins; }
+
+//-----------------------------------------------------------------------------
+//      シャドウメッシュを取得します.
+//-----------------------------------------------------------------------------
+const std::vector<ShadowMesh>& MeshLoader::GetShadowMeshes() const
+{ return m_ShadowMeshes; }
+
+//-----------------------------------------------------------------------------
+//      テクスチャを取得します.
+//-----------------------------------------------------------------------------
+const std::vector<TextureEntry>& MeshLoader::GetTextures() const
+{ return m_Textures; }
+
+//-----------------------------------------------------------------------------
+//      テクスチャを検索します.
+//-----------------------------------------------------------------------------
+const TextureEntry* MeshLoader::FindTexture(uint32_t id) const
+{
+    auto itr = m_TextureIndices.find(id);
+    if (itr == m_TextureIndices.end())
+    { return nullptr; }
+
+    return &m_Textures[itr->second];
+}
+
+//-----------------------------------------------------------------------------
+//      スケルトンを取得します.
+//-----------------------------------------------------------------------------
+const Skeleton& MeshLoader::GetSkeleton() const
+{ return m_Skeleton; }
+
+//-----------------------------------------------------------------------------
+//      アニメーションクリップを取得します.
+//-----------------------------------------------------------------------------
+const std::vector<AnimationClip>& MeshLoader::GetAnimations() const
+{ return m_Animations; }
+
+//-----------------------------------------------------------------------------
+//      インポートプロファイルに対応するポストプロセスフラグを取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetImportFlags(IMPORT_PROFILE profile)
+{
+    // 接線空間は重複除去後にコンバータ側で生成するため aiProcess_CalcTangentSpace は含めない.
+    uint32_t flag = 0;
+
+    switch(profile)
+    {
+    case IMPORT_PROFILE_FAST:
+        {
+            // 接線空間とUV生成はコンバータ側に任せる.
+            // 法線は他のプロファイルと見た目と頂点数が揃うようにスムーズで生成する.
+            flag |= aiProcess_Triangulate;
+            flag |= aiProcess_PreTransformVertices;
+            flag |= aiProcess_GenSmoothNormals;
+        }
+        break;
+
+    case IMPORT_PROFILE_QUALITY:
+        {
+            flag |= aiProcess_Triangulate;
+            flag |= aiProcess_PreTransformVertices;
+            flag |= aiProcess_GenSmoothNormals;
+            flag |= aiProcess_GenUVCoords;
+            flag |= aiProcess_RemoveRedundantMaterials;
+            flag |= aiProcess_OptimizeMeshes;
+            flag |= aiProcess_SortByPType;
+            flag |= aiProcess_FindDegenerates;
+            flag |= aiProcess_FindInvalidData;
+            flag |= aiProcess_ValidateDataStructure;
+        }
+        break;
+
+    case IMPORT_PROFILE_SKINNED:
+        {
+            // ボーンとアニメーションを維持するため PreTransformVertices は使わない.
+            flag |= aiProcess_Triangulate;
+            flag |= aiProcess_GenSmoothNormals;
+            flag |= aiProcess_RemoveRedundantMaterials;
+        }
+        break;
+
+    case IMPORT_PROFILE_SCAN:
+        {
+            // 大規模な点群由来のメッシュなのでUVや接線空間は生成しない.
+            flag |= aiProcess_Triangulate;
+            flag |= aiProcess_PreTransformVertices;
+            flag |= aiProcess_SortByPType;
+            flag |= aiProcess_FindDegenerates;
+            flag |= aiProcess_GenSmoothNormals;
+        }
+        break;
+
+    case IMPORT_PROFILE_DEFAULT:
+    default:
+        {
+            flag |= aiProcess_Triangulate;
+            flag |= aiProcess_PreTransformVertices;
+            flag |= aiProcess_GenSmoothNormals;
+            flag |= aiProcess_GenUVCoords;
+            flag |= aiProcess_RemoveRedundantMaterials;
+            flag |= aiProcess_OptimizeMeshes;
+        }
+        break;
+    }
+
+    return flag;
+}
+
+//-----------------------------------------------------------------------------
+//      文字列からインポートプロファイルを検索します.
+//-----------------------------------------------------------------------------
+bool FindImportProfile(const char* name, IMPORT_PROFILE& profile)
+{
+    if (name == nullptr)
+    { return false; }
+
+    struct Entry
+    {
+        const char*     Name;
+        IMPORT_PROFILE  Profile;
+    };
+
+    static const Entry kTable[] = {
+        { "default",    IMPORT_PROFILE_DEFAULT },
+        { "fast",       IMPORT_PROFILE_FAST    },
+        { "quality",    IMPORT_PROFILE_QUALITY },
+        { "skinned",    IMPORT_PROFILE_SKINNED },
+        { "scan",       IMPORT_PROFILE_SCAN    },
+    };
+
+    for(auto i=0u; i<_countof(kTable); ++i)
+    {
+        if (_stricmp(name, kTable[i].Name) == 0)
+        {
+            profile = kTable[i].Profile;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      1チャンクあたりの最大三角形数を求めます.
+//-----------------------------------------------------------------------------
+size_t GetFaceLimit(size_t workingSetLimit, uint32_t maxFaceCount)
+{
+    auto limit = std::min(workingSetLimit, kMaxFaceCount);
+    if (maxFaceCount > 0)
+    { limit = std::min<size_t>(limit, maxFaceCount); }
+    return std::max<size_t>(limit, 1);
+}
+
+//-----------------------------------------------------------------------------
+//      セル毎の三角形数の累積からチャンクの区切りを求めます.
+//-----------------------------------------------------------------------------
+void BuildChunkOffsets
+(
+    const std::vector<size_t>&  cellOffsets,
+    size_t                      faceLimit,
+    std::vector<size_t>&        offsets
+)
+{
+    offsets.clear();
+    offsets.push_back(0);
+    if (cellOffsets.empty())
+    { return; }
+
+    for(size_t i=0; i + 1<cellOffsets.size(); ++i)
+    {
+        auto begin = cellOffsets[i];
+        auto end   = cellOffsets[i + 1];
+
+        while(end - offsets.back() > faceLimit)
+        {
+            // セルの手前で区切れるならセル単位で区切り，
+            // 1セルで上限を超える場合はセル内で分割する.
+            auto start = offsets.back();
+            auto split = (begin > start) ? begin : start + faceLimit;
+            offsets.push_back(split);
+        }
+    }
+
+    if (offsets.back() != cellOffsets.back())
+    { offsets.push_back(cellOffsets.back()); }
+}
+
+//-----------------------------------------------------------------------------
+//      文字列からポストプロセスフラグを検索します.
+//-----------------------------------------------------------------------------
+bool FindPostProcessFlag(const char* name, uint32_t& flag)
+{
+    if (name == nullptr)
+    { return false; }
+
+    // 接頭辞は省略可能.
+    const char* prefix = "aiProcess_";
+    if (strncmp(name, prefix, strlen(prefix)) == 0)
+    { name += strlen(prefix); }
+
+    for(auto i=0u; i<_countof(kPostProcessSteps); ++i)
+    {
+        if (_stricmp(name, kPostProcessSteps[i].Name) == 0)
+        {
+            flag = kPostProcessSteps[i].Flag;
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
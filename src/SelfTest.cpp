@@ -0,0 +1,264 @@
+﻿//-----------------------------------------------------------------------------
+// File : SelfTest.cpp
+// Desc : Self Test.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <SelfTest.h>
+#include <MeshLoader.h>
+#include <asdxLogger.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace /* anonymous */ {
+
+using Triangle = std::array<int, 9>;
+
+//-----------------------------------------------------------------------------
+//      格子状のメッシュをOBJ形式で生成します.
+//-----------------------------------------------------------------------------
+std::string BuildGridObj(int size, std::vector<Triangle>& triangles)
+{
+    std::string text;
+    char line[128];
+
+    for(auto y=0; y<=size; ++y)
+    {
+        for(auto x=0; x<=size; ++x)
+        {
+            sprintf_s(line, "v %d %d 0\nvt %f %f\n", x, y, float(x) / size, float(y) / size);
+            text += line;
+        }
+    }
+
+    auto addTriangle = [&](int a, int b, int c)
+    {
+        // OBJの頂点番号は1始まり.
+        sprintf_s(line, "f %d/%d %d/%d %d/%d\n", a + 1, a + 1, b + 1, b + 1, c + 1, c + 1);
+        text += line;
+
+        auto w = size + 1;
+        triangles.push_back(Triangle{ a % w, a / w, 0, b % w, b / w, 0, c % w, c / w, 0 });
+    };
+
+    for(auto y=0; y<size; ++y)
+    {
+        for(auto x=0; x<size; ++x)
+        {
+            auto v0 = y * (size + 1) + x;
+            auto v1 = v0 + 1;
+            auto v2 = v0 + (size + 1);
+            auto v3 = v2 + 1;
+            addTriangle(v0, v1, v3);
+            addTriangle(v0, v3, v2);
+        }
+    }
+
+    return text;
+}
+
+//-----------------------------------------------------------------------------
+//      巻き順を無視して比較できるように頂点を並べ替えます.
+//-----------------------------------------------------------------------------
+Triangle Canonicalize(const Triangle& value)
+{
+    std::array<std::array<int, 3>, 3> corners = {{
+        {{ value[0], value[1], value[2] }},
+        {{ value[3], value[4], value[5] }},
+        {{ value[6], value[7], value[8] }},
+    }};
+    std::sort(corners.begin(), corners.end());
+
+    Triangle result;
+    for(auto i=0; i<3; ++i)
+    {
+        for(auto j=0; j<3; ++j)
+        { result[i * 3 + j] = corners[i][j]; }
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      三角形数の上限を超えるメッシュの分割を検証します.
+//-----------------------------------------------------------------------------
+bool TestPartitionFaceLimit()
+{
+    const int      kGridSize     = 32;
+    const uint32_t kMaxFaceCount = 100;
+
+    std::vector<Triangle> expected;
+    auto text = BuildGridObj(kGridSize, expected);
+
+    // 32bitの上限の代わりに小さな上限を与えて分割経路を通す.
+    MeshLoaderOption option;
+    option.MaxFaceCount = kMaxFaceCount;
+
+    asdx::ResModel model;
+    MeshLoader loader;
+    if (!loader.Load(text.data(), text.size(), "grid.obj", model, option))
+    {
+        ELOGA("Error : [SelfTest] Load Failed.");
+        return false;
+    }
+
+    auto result = true;
+    auto check = [&](bool condition, const char* message, size_t mesh)
+    {
+        if (!condition)
+        {
+            ELOGA("Error : [SelfTest] %s mesh = %zu", message, mesh);
+            result = false;
+        }
+        return condition;
+    };
+
+    check(model.Meshes.size() > 1, "Mesh Not Partitioned.", 0);
+
+    std::vector<Triangle> actual;
+    for(size_t i=0; i<model.Meshes.size(); ++i)
+    {
+        const auto& mesh = model.Meshes[i];
+        check(mesh.Primitives.size() <= kMaxFaceCount, "Face Limit Exceeded.", i);
+
+        for(auto& meshlet : mesh.Meshlets)
+        {
+            // オフセットと個数が各配列の範囲に収まっていること.
+            auto valid = check(uint64_t(meshlet.VertexOffset)    + meshlet.VertexCount    <= mesh.Indices.size(),    "Meshlet Vertex Range Overflow.", i)
+                      && check(uint64_t(meshlet.PrimitiveOffset) + meshlet.PrimitiveCount <= mesh.Primitives.size(), "Meshlet Primitive Range Overflow.", i);
+            if (!valid)
+            { continue; }
+
+            for(auto j=0u; j<meshlet.PrimitiveCount; ++j)
+            {
+                const auto& prim = mesh.Primitives[meshlet.PrimitiveOffset + j];
+                uint32_t local[3] = { prim.Index0, prim.Index1, prim.Index2 };
+
+                Triangle tri;
+                for(auto k=0; k<3; ++k)
+                {
+                    if (!check(local[k] < meshlet.VertexCount, "Primitive Index Out Of Range.", i))
+                    { return false; }
+
+                    auto index = mesh.Indices[meshlet.VertexOffset + local[k]];
+                    if (!check(index < mesh.Positions.size(), "Vertex Index Out Of Range.", i))
+                    { return false; }
+
+                    const auto& p = mesh.Positions[index];
+                    tri[k * 3 + 0] = int(std::lround(p.x));
+                    tri[k * 3 + 1] = int(std::lround(p.y));
+                    tri[k * 3 + 2] = int(std::lround(p.z));
+                }
+                actual.push_back(Canonicalize(tri));
+            }
+        }
+    }
+
+    // 出力した三角形の和集合が入力と一致すること.
+    for(auto& tri : expected)
+    { tri = Canonicalize(tri); }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual  .begin(), actual  .end());
+    check(expected == actual, "Output Triangles Differ From Input.", 0);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      32bitを超える三角形数でチャンクの区切りを検証します.
+//-----------------------------------------------------------------------------
+bool TestChunkOffsets64()
+{
+    auto result = true;
+    auto check = [&](bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            ELOGA("Error : [SelfTest] %s", message);
+            result = false;
+        }
+    };
+
+    // 頂点インデックス数が32bitに収まる上限になること.
+    auto faceLimit = GetFaceLimit(SIZE_MAX, 0);
+    check(faceLimit == UINT32_MAX / 3,              "Face Limit Is Not UINT32_MAX / 3.");
+    check(uint64_t(faceLimit) * 3 <= UINT32_MAX,    "Face Limit Overflows 32bit Indices.");
+    check(GetFaceLimit(SIZE_MAX, 100) == 100,       "Max Face Count Is Ignored.");
+    check(GetFaceLimit(50, 100) == 50,              "Working Set Limit Is Ignored.");
+
+    // 実際にメモリを確保せず，UINT32_MAX / 3 を超える三角形数のセル累積を与える.
+    // 3倍すると32bitを超えるので，32bitで計算すると区切りやインデックス数が壊れる.
+    const size_t kSmall = 1000;
+    const size_t kLarge = faceLimit * 2 + 123;
+    const size_t kTail  = 5;
+    std::vector<size_t> cellOffsets = { 0, kSmall, kSmall + kLarge, kSmall + kLarge + kTail };
+    auto faceCount = cellOffsets.back();
+    check(faceCount > UINT32_MAX / 3, "Face Count Does Not Exceed UINT32_MAX / 3.");
+
+    std::vector<size_t> offsets;
+    BuildChunkOffsets(cellOffsets, faceLimit, offsets);
+
+    // セルの手前で区切り，上限を超えるセルはセル内で分割する.
+    std::vector<size_t> expected = {
+        0,
+        kSmall,
+        kSmall + faceLimit,
+        kSmall + faceLimit * 2,
+        faceCount,
+    };
+    check(offsets == expected, "Chunk Offsets Differ From Expected.");
+
+    for(size_t i=0; i + 1<offsets.size(); ++i)
+    {
+        auto count = offsets[i + 1] - offsets[i];
+        check(offsets[i] < offsets[i + 1],          "Chunk Offsets Not Increasing.");
+        check(count <= faceLimit,                   "Chunk Face Limit Exceeded.");
+        check(uint64_t(count) * 3 <= UINT32_MAX,    "Chunk Index Count Overflows 32bit.");
+    }
+
+    // 末尾のチャンクの先頭インデックスは32bitを超えるので size_t で扱えていること.
+    check(uint64_t(offsets[offsets.size() - 2]) * 3 > UINT32_MAX, "Index Offset Does Not Exceed 32bit.");
+
+    return result;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      自己テストを実行します.
+//-----------------------------------------------------------------------------
+int RunSelfTest()
+{
+    struct TestCase
+    {
+        const char* Name;
+        bool        (*Func)();
+    };
+
+    static const TestCase kTests[] = {
+        { "PartitionFaceLimit", TestPartitionFaceLimit },
+        { "ChunkOffsets64",     TestChunkOffsets64     },
+    };
+
+    auto failed = 0;
+    for(auto& test : kTests)
+    {
+        if (test.Func())
+        { ILOGA("Info : [SelfTest] %s ... OK", test.Name); }
+        else
+        {
+            ELOGA("Error : [SelfTest] %s ... NG", test.Name);
+            failed++;
+        }
+    }
+
+    return (failed == 0) ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,386 @@
+﻿//-----------------------------------------------------------------------------
+// File : Server.cpp
+// Desc : Conversion Server.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <winsock2.h>
+#include <afunix.h>
+#include <Server.h>
+#include <Converter.h>
+#include <ImporterPool.h>
+#include <ThreadPool.h>
+#include <asdxLogger.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "ws2_32.lib")
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const uint32_t kProtocolMagic    = 0x56524353;   // 'SCRV'
+static const uint32_t kMaxArgCount      = 256;          // 1リクエストの最大引数数.
+static const uint32_t kMaxStringLength  = 4096;         // 1引数の最大文字数.
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ResponseHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct ResponseHeader
+{
+    uint32_t        Magic;          //!< マジックです.
+    int32_t         Result;         //!< 終了コードです.
+    ConvertStats    Stats;          //!< 統計情報です.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WinsockScope class
+///////////////////////////////////////////////////////////////////////////////
+class WinsockScope
+{
+public:
+    WinsockScope()
+    {
+        WSADATA data;
+        m_Valid = (WSAStartup(MAKEWORD(2, 2), &data) == 0);
+    }
+
+    ~WinsockScope()
+    {
+        if (m_Valid)
+        { WSACleanup(); }
+    }
+
+    bool IsValid() const
+    { return m_Valid; }
+
+private:
+    bool m_Valid = false;
+};
+
+//-----------------------------------------------------------------------------
+//      ソケットアドレスを設定します.
+//-----------------------------------------------------------------------------
+bool SetAddress(const char* socketPath, sockaddr_un& addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    auto len = strlen(socketPath);
+    if (len == 0 || len >= sizeof(addr.sun_path))
+    {
+        ELOGA("Error : Invalid Socket Path. path = %s", socketPath);
+        return false;
+    }
+
+    memcpy(addr.sun_path, socketPath, len);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      指定サイズを全て送信します.
+//-----------------------------------------------------------------------------
+bool SendAll(SOCKET sock, const void* pData, size_t size)
+{
+    auto ptr = static_cast<const char*>(pData);
+    while (size > 0)
+    {
+        auto ret = send(sock, ptr, int(size), 0);
+        if (ret == SOCKET_ERROR || ret == 0)
+        { return false; }
+
+        ptr  += ret;
+        size -= size_t(ret);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      指定サイズを全て受信します.
+//-----------------------------------------------------------------------------
+bool RecvAll(SOCKET sock, void* pData, size_t size)
+{
+    auto ptr = static_cast<char*>(pData);
+    while (size > 0)
+    {
+        auto ret = recv(sock, ptr, int(size), 0);
+        if (ret == SOCKET_ERROR || ret == 0)
+        { return false; }
+
+        ptr  += ret;
+        size -= size_t(ret);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      長さ付き文字列を送信します.
+//-----------------------------------------------------------------------------
+bool SendString(SOCKET sock, const char* value)
+{
+    auto len = uint32_t(strlen(value));
+    if (!SendAll(sock, &len, sizeof(len)))
+    { return false; }
+
+    return SendAll(sock, value, len);
+}
+
+//-----------------------------------------------------------------------------
+//      長さ付き文字列を受信します.
+//-----------------------------------------------------------------------------
+bool RecvString(SOCKET sock, std::string& value)
+{
+    uint32_t len = 0;
+    if (!RecvAll(sock, &len, sizeof(len)))
+    { return false; }
+
+    if (len > kMaxStringLength)
+    { return false; }
+
+    value.resize(len);
+    if (len == 0)
+    { return true; }
+
+    return RecvAll(sock, &value[0], len);
+}
+
+//-----------------------------------------------------------------------------
+//      リクエストを受信します.
+//-----------------------------------------------------------------------------
+bool RecvRequest(SOCKET sock, std::string& workDir, std::vector<std::string>& args)
+{
+    uint32_t header[2] = {};
+    if (!RecvAll(sock, header, sizeof(header)))
+    { return false; }
+
+    if (header[0] != kProtocolMagic || header[1] > kMaxArgCount)
+    { return false; }
+
+    if (!RecvString(sock, workDir))
+    { return false; }
+
+    args.resize(header[1]);
+    for(auto& arg : args)
+    {
+        if (!RecvString(sock, arg))
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      1つの接続を処理します. 停止要求を受け取った場合は true を返却します.
+//-----------------------------------------------------------------------------
+bool HandleConnection(SOCKET sock, ImporterPool& importers)
+{
+    std::string workDir;
+    std::vector<std::string> args;
+    if (!RecvRequest(sock, workDir, args))
+    {
+        ELOGA("Error : Invalid Request.");
+        return false;
+    }
+
+    ResponseHeader response = {};
+    response.Magic  = kProtocolMagic;
+    response.Result = 0;
+
+    // 停止要求.
+    if (args.size() == 1 && args[0] == "-shutdown")
+    {
+        SendAll(sock, &response, sizeof(response));
+        return true;
+    }
+
+    std::vector<const char*> argv;
+    argv.reserve(args.size());
+    for(auto& arg : args)
+    { argv.push_back(arg.c_str()); }
+
+    ConvertArgs convertArgs;
+    if (!ParseArgs(int(argv.size()), argv.data(), convertArgs))
+    { response.Result = -1; }
+    else
+    {
+        ResolvePaths(workDir, convertArgs);
+        convertArgs.Option.pImporterPool = &importers;
+        ILOGA("Info : Convert Request. input = %s", convertArgs.Input.c_str());
+
+        if (!Convert(convertArgs, &response.Stats))
+        { response.Result = -1; }
+    }
+
+    SendAll(sock, &response, sizeof(response));
+    return false;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      変換サーバーを実行します.
+//-----------------------------------------------------------------------------
+int RunServer(const char* socketPath, uint32_t threadCount)
+{
+    WinsockScope winsock;
+    if (!winsock.IsValid())
+    {
+        ELOGA("Error : WSAStartup() Failed.");
+        return -1;
+    }
+
+    sockaddr_un addr;
+    if (!SetAddress(socketPath, addr))
+    { return -1; }
+
+    auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET)
+    {
+        ELOGA("Error : socket() Failed. error = %d", WSAGetLastError());
+        return -1;
+    }
+
+    // 前回異常終了した場合のソケットファイルが残っていると bind() に失敗する.
+    DeleteFileA(socketPath);
+
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR
+     || listen(listener, SOMAXCONN) == SOCKET_ERROR)
+    {
+        ELOGA("Error : Socket Listen Failed. path = %s, error = %d", socketPath, WSAGetLastError());
+        closesocket(listener);
+        return -1;
+    }
+
+    // ワーカーごとにインポーターを使い回す. ワーカーより後に破棄する.
+    ImporterPool importers;
+
+    ThreadPool pool;
+    if (!pool.Init(threadCount))
+    {
+        ELOGA("Error : ThreadPool::Init() Failed.");
+        closesocket(listener);
+        return -1;
+    }
+
+    ILOGA("Info : Server Start. path = %s, thread = %zu", socketPath, pool.GetThreadCount());
+
+    std::atomic<bool> shutdown(false);
+    while (!shutdown)
+    {
+        auto sock = accept(listener, nullptr, nullptr);
+        if (sock == INVALID_SOCKET)
+        {
+            // 停止要求でリスナーが閉じられた.
+            if (shutdown)
+            { break; }
+
+            ELOGA("Error : accept() Failed. error = %d", WSAGetLastError());
+            continue;
+        }
+
+        pool.Push([sock, listener, &shutdown, &importers]()
+        {
+            if (HandleConnection(sock, importers))
+            {
+                // 待機中の accept() を抜けるためにリスナーを閉じる.
+                if (!shutdown.exchange(true))
+                { closesocket(listener); }
+            }
+            closesocket(sock);
+        });
+    }
+
+    // 処理中の変換を完了させる.
+    pool.Wait();
+    pool.Term();
+
+    DeleteFileA(socketPath);
+
+    ILOGA("Info : Server Shutdown.");
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//      変換サーバーにリクエストを送信します.
+//-----------------------------------------------------------------------------
+int RunClient(const char* socketPath, int argc, const char* const* argv)
+{
+    if (argc < 0 || uint32_t(argc) > kMaxArgCount)
+    {
+        ELOGA("Error : Too Many Arguments. count = %d", argc);
+        return -1;
+    }
+
+    WinsockScope winsock;
+    if (!winsock.IsValid())
+    {
+        ELOGA("Error : WSAStartup() Failed.");
+        return -1;
+    }
+
+    sockaddr_un addr;
+    if (!SetAddress(socketPath, addr))
+    { return -1; }
+
+    auto sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET)
+    {
+        ELOGA("Error : socket() Failed. error = %d", WSAGetLastError());
+        return -1;
+    }
+
+    if (connect(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR)
+    {
+        ELOGA("Error : connect() Failed. path = %s, error = %d", socketPath, WSAGetLastError());
+        closesocket(sock);
+        return -1;
+    }
+
+    char workDir[MAX_PATH] = {};
+    GetCurrentDirectoryA(MAX_PATH, workDir);
+
+    // [マジック][引数の数][作業ディレクトリ][引数...]
+    uint32_t header[2] = { kProtocolMagic, uint32_t(argc) };
+    auto sent = SendAll(sock, header, sizeof(header))
+             && SendString(sock, workDir);
+    for(auto i=0; sent && i<argc; ++i)
+    { sent = SendString(sock, argv[i]); }
+
+    ResponseHeader response = {};
+    if (!sent || !RecvAll(sock, &response, sizeof(response)) || response.Magic != kProtocolMagic)
+    {
+        ELOGA("Error : Server Communication Failed. path = %s", socketPath);
+        closesocket(sock);
+        return -1;
+    }
+
+    closesocket(sock);
+
+    if (response.Result == 0 && argc > 0 && strcmp(argv[0], "-shutdown") != 0)
+    {
+        auto& stats = response.Stats;
+        ILOGA("Info : Convert OK! time = %.2lf[msec], mesh = %u, vertex = %llu, primitive = %llu, meshlet = %u, material = %u, texture = %u(failed = %u)",
+            stats.ElapsedMsec,
+            stats.MeshCount,
+            static_cast<unsigned long long>(stats.VertexCount),
+            static_cast<unsigned long long>(stats.PrimitiveCount),
+            stats.MeshletCount,
+            stats.MaterialCount,
+            stats.TextureCount,
+            stats.FailedTextureCount);
+    }
+
+    return response.Result;
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+﻿//-----------------------------------------------------------------------------
+// File : SkinPacker.cpp
+// Desc : Skin Weight Packer.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <SkinPacker.h>
+#include <ParallelFor.h>
+#include <assimp/scene.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const size_t kGrainSize = 16384;     // 1スレッドあたりの最低処理頂点数.
+static const size_t kMaxInfluenceCount = 8; // エンコード可能な最大影響数.
+
+///////////////////////////////////////////////////////////////////////////////
+// Influence structure
+///////////////////////////////////////////////////////////////////////////////
+struct Influence
+{
+    uint16_t    BoneIndex;  //!< ボーン番号です.
+    float       Weight;     //!< 重みです.
+};
+
+//-----------------------------------------------------------------------------
+//      重みの大きい順に並べるための比較関数です.
+//-----------------------------------------------------------------------------
+inline bool CompareInfluence(const Influence& lhs, const Influence& rhs)
+{
+    // 同じ重みの場合は結果が安定するようにボーン番号で比較.
+    if (lhs.Weight != rhs.Weight)
+    { return lhs.Weight > rhs.Weight; }
+
+    return lhs.BoneIndex < rhs.BoneIndex;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      スキニング情報を頂点優先に並べ替えてパッキングします.
+//-----------------------------------------------------------------------------
+void PackSkinWeights
+(
+    const aiMesh*   pSrcMesh,
+    uint32_t        influenceCount,
+    PackedSkin&     result,
+    const uint16_t* pBoneMap
+)
+{
+    const size_t vertexCount = pSrcMesh->mNumVertices;
+
+    result.InfluenceCount = influenceCount;
+    result.BoneIndices.assign(vertexCount * influenceCount, 0);
+    result.BoneWeights.assign(vertexCount * influenceCount, 0.0f);
+
+    if (vertexCount == 0 || influenceCount == 0)
+    { return; }
+
+    // 頂点ごとの影響数を数える.
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for(auto i=0u; i<pSrcMesh->mNumBones; ++i)
+    {
+        auto pBone = pSrcMesh->mBones[i];
+        for(auto j=0u; j<pBone->mNumWeights; ++j)
+        {
+            const auto& weight = pBone->mWeights[j];
+            if (weight.mWeight > 0.0f)
+            { offsets[weight.mVertexId + 1]++; }
+        }
+    }
+
+    for(size_t i=0; i<vertexCount; ++i)
+    { offsets[i + 1] += offsets[i]; }
+
+    // 頂点優先に並べ替える(計数ソート).
+    std::vector<Influence> influences(offsets[vertexCount]);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for(auto i=0u; i<pSrcMesh->mNumBones; ++i)
+        {
+            auto pBone = pSrcMesh->mBones[i];
+            for(auto j=0u; j<pBone->mNumWeights; ++j)
+            {
+                const auto& weight = pBone->mWeights[j];
+                if (weight.mWeight <= 0.0f)
+                { continue; }
+
+                auto& dst = influences[cursor[weight.mVertexId]++];
+                dst.BoneIndex = (pBoneMap != nullptr) ? pBoneMap[i] : uint16_t(i);
+                dst.Weight    = weight.mWeight;
+            }
+        }
+    }
+
+    // 頂点ごとに上位の影響を選択して正規化する.
+    // 頂点ごとの範囲は重ならないので並列に書き込める.
+    std::vector<float> dropped(vertexCount, 0.0f);
+    ParallelFor(vertexCount, kGrainSize, [&](size_t begin, size_t end)
+    {
+        for(auto v=begin; v<end; ++v)
+        {
+            auto first = influences.begin() + offsets[v];
+            auto last  = influences.begin() + offsets[v + 1];
+            auto count = std::min<size_t>(last - first, influenceCount);
+
+            std::partial_sort(first, first + count, last, CompareInfluence);
+
+            auto sum = 0.0f;
+            for(size_t k=0; k<count; ++k)
+            { sum += first[k].Weight; }
+
+            auto total = sum;
+            for(auto itr = first + count; itr != last; ++itr)
+            { total += itr->Weight; }
+
+            if (total > 0.0f)
+            { dropped[v] = (total - sum) / total; }
+
+            auto scale = (sum > 0.0f) ? 1.0f / sum : 0.0f;
+
+            auto pIndices = &result.BoneIndices[v * influenceCount];
+            auto pWeights = &result.BoneWeights[v * influenceCount];
+            for(size_t k=0; k<count; ++k)
+            {
+                pIndices[k] = first[k].BoneIndex;
+                pWeights[k] = first[k].Weight * scale;
+            }
+        }
+    });
+
+    // 切り捨ての統計を集計.
+    result.TruncatedVertexCount = 0;
+    result.MaxDroppedWeight     = 0.0f;
+    result.SumDroppedWeight     = 0.0;
+    for(size_t v=0; v<vertexCount; ++v)
+    {
+        if (offsets[v + 1] - offsets[v] <= influenceCount)
+        { continue; }
+
+        result.TruncatedVertexCount++;
+        result.MaxDroppedWeight  = std::max(result.MaxDroppedWeight, dropped[v]);
+        result.SumDroppedWeight += dropped[v];
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      重み1つあたりのバイト数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetSkinWeightSize(SKIN_WEIGHT_FORMAT format)
+{
+    switch(format)
+    {
+    case SKIN_WEIGHT_FORMAT_UNORM8:  return sizeof(uint8_t);
+    case SKIN_WEIGHT_FORMAT_UNORM16: return sizeof(uint16_t);
+    default:                         return sizeof(float);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      1頂点あたりのバイト数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetSkinStride
+(
+    uint32_t            influenceCount,
+    SKIN_WEIGHT_FORMAT  format,
+    uint32_t            indexSize
+)
+{
+    auto size = influenceCount * (indexSize + GetSkinWeightSize(format));
+    return (size + 3) & ~3u;
+}
+
+//-----------------------------------------------------------------------------
+//      パッキング結果を頂点単位のバイナリにエンコードします.
+//-----------------------------------------------------------------------------
+float EncodeSkin
+(
+    const PackedSkin&       skin,
+    SKIN_WEIGHT_FORMAT      format,
+    std::vector<uint8_t>&   data
+)
+{
+    const auto count  = skin.InfluenceCount;
+    const auto stride = GetSkinStride(count, format);
+    const auto vertexCount = (count > 0) ? skin.BoneIndices.size() / count : 0;
+
+    data.assign(vertexCount * stride, 0);
+    if (vertexCount == 0)
+    { return 0.0f; }
+
+    std::vector<float> errors(vertexCount, 0.0f);
+    ParallelFor(vertexCount, kGrainSize, [&](size_t begin, size_t end)
+    {
+        for(auto v=begin; v<end; ++v)
+        {
+            auto pSrcIndices = &skin.BoneIndices[v * count];
+            auto pSrcWeights = &skin.BoneWeights[v * count];
+            auto pDst        = &data[v * stride];
+
+            memcpy(pDst, pSrcIndices, sizeof(uint16_t) * count);
+            pDst += sizeof(uint16_t) * count;
+
+            if (format == SKIN_WEIGHT_FORMAT_FLOAT)
+            {
+                memcpy(pDst, pSrcWeights, sizeof(float) * count);
+                continue;
+            }
+
+            auto maxValue = (format == SKIN_WEIGHT_FORMAT_UNORM8) ? 255 : 65535;
+
+            // 量子化.
+            int values[kMaxInfluenceCount] = {};
+            auto sum = 0;
+            for(auto k=0u; k<count; ++k)
+            {
+                values[k] = int(pSrcWeights[k] * maxValue + 0.5f);
+                sum += values[k];
+            }
+
+            // 合計が最大値になるように一番大きい重みで補正する.
+            if (sum > 0)
+            { values[0] = std::max(0, values[0] + (maxValue - sum)); }
+
+            auto error = 0.0f;
+            for(auto k=0u; k<count; ++k)
+            {
+                error = std::max(error, fabsf(float(values[k]) / maxValue - pSrcWeights[k]));
+
+                if (format == SKIN_WEIGHT_FORMAT_UNORM8)
+                { pDst[k] = uint8_t(values[k]); }
+                else
+                {
+                    auto value = uint16_t(values[k]);
+                    memcpy(pDst + k * sizeof(uint16_t), &value, sizeof(value));
+                }
+            }
+            errors[v] = error;
+        }
+    });
+
+    return *std::max_element(errors.begin(), errors.end());
+}
\ No newline at end of file
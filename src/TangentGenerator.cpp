@@ -0,0 +1,297 @@
+﻿//-----------------------------------------------------------------------------
+// File : TangentGenerator.cpp
+// Desc : Tangent Space Generator.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <TangentGenerator.h>
+#include <ParallelFor.h>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const size_t kGrainSize = 4096;  // 1スレッドあたりの最低処理数.
+
+//-----------------------------------------------------------------------------
+//      減算します.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 Sub(const asdx::Vector3& a, const asdx::Vector3& b)
+{ return asdx::Vector3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+//-----------------------------------------------------------------------------
+//      内積を求めます.
+//-----------------------------------------------------------------------------
+inline float Dot(const asdx::Vector3& a, const asdx::Vector3& b)
+{ return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+//-----------------------------------------------------------------------------
+//      外積を求めます.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 Cross(const asdx::Vector3& a, const asdx::Vector3& b)
+{
+    return asdx::Vector3(
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x);
+}
+
+//-----------------------------------------------------------------------------
+//      接平面に射影します.
+//-----------------------------------------------------------------------------
+inline asdx::Vector3 Project(const asdx::Vector3& n, const asdx::Vector3& v)
+{
+    auto d = Dot(n, v);
+    return asdx::Vector3(v.x - n.x * d, v.y - n.y * d, v.z - n.z * d);
+}
+
+//-----------------------------------------------------------------------------
+//      正規化します. 長さがゼロの場合は false を返却します.
+//-----------------------------------------------------------------------------
+inline bool SafeNormalize(asdx::Vector3& v)
+{
+    auto len = sqrtf(Dot(v, v));
+    if (len <= 1e-12f)
+    { return false; }
+
+    v.x /= len;
+    v.y /= len;
+    v.z /= len;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FaceTangent structure
+///////////////////////////////////////////////////////////////////////////////
+struct FaceTangent
+{
+    asdx::Vector3   Tangent;    //!< 面接線(正規化済み)です.
+    asdx::Vector3   Binormal;   //!< 面従法線(正規化済み)です.
+    bool            Valid;      //!< UVが縮退していなければtrue.
+};
+
+//-----------------------------------------------------------------------------
+//      面接線を求めます.
+//-----------------------------------------------------------------------------
+FaceTangent CalcFaceTangent
+(
+    const asdx::Vector3& p0, const asdx::Vector3& p1, const asdx::Vector3& p2,
+    const asdx::Vector2& uv0, const asdx::Vector2& uv1, const asdx::Vector2& uv2
+)
+{
+    auto e1 = Sub(p1, p0);
+    auto e2 = Sub(p2, p0);
+
+    auto s1 = uv1.x - uv0.x;
+    auto t1 = uv1.y - uv0.y;
+    auto s2 = uv2.x - uv0.x;
+    auto t2 = uv2.y - uv0.y;
+
+    auto area = s1 * t2 - s2 * t1;
+    auto sign = (area < 0.0f) ? -1.0f : 1.0f;
+
+    FaceTangent face;
+    face.Tangent = asdx::Vector3(
+        (e1.x * t2 - e2.x * t1) * sign,
+        (e1.y * t2 - e2.y * t1) * sign,
+        (e1.z * t2 - e2.z * t1) * sign);
+    face.Binormal = asdx::Vector3(
+        (e2.x * s1 - e1.x * s2) * sign,
+        (e2.y * s1 - e1.y * s2) * sign,
+        (e2.z * s1 - e1.z * s2) * sign);
+
+    face.Valid = (fabsf(area) > 1e-20f)
+              && SafeNormalize(face.Tangent)
+              && SafeNormalize(face.Binormal);
+    return face;
+}
+
+//-----------------------------------------------------------------------------
+//      コーナー角で重み付けして面接線を累積します.
+//-----------------------------------------------------------------------------
+void AccumulateCorner
+(
+    const asdx::Vector3&    N,
+    const asdx::Vector3&    p0,
+    const asdx::Vector3&    p1,
+    const asdx::Vector3&    p2,
+    const FaceTangent&      ft,
+    asdx::Vector3&          T,
+    asdx::Vector3&          B
+)
+{
+    if (!ft.Valid)
+    { return; }
+
+    // コーナー角を求める.
+    auto d1 = Project(N, Sub(p1, p0));
+    auto d2 = Project(N, Sub(p2, p0));
+    if (!SafeNormalize(d1) || !SafeNormalize(d2))
+    { return; }
+
+    auto cosine = std::max(-1.0f, std::min(1.0f, Dot(d1, d2)));
+    auto weight = acosf(cosine);
+
+    auto ft_t = Project(N, ft.Tangent);
+    auto ft_b = Project(N, ft.Binormal);
+    SafeNormalize(ft_t);
+    SafeNormalize(ft_b);
+
+    T.x += ft_t.x * weight;
+    T.y += ft_t.y * weight;
+    T.z += ft_t.z * weight;
+
+    B.x += ft_b.x * weight;
+    B.y += ft_b.y * weight;
+    B.z += ft_b.z * weight;
+}
+
+//-----------------------------------------------------------------------------
+//      累積した接線と従法線から接線空間を求めます.
+//-----------------------------------------------------------------------------
+uint32_t ResolveTangentSpace(const asdx::Vector3& N, asdx::Vector3 T, const asdx::Vector3& B)
+{
+    // 直交化.
+    T = Project(N, T);
+    if (!SafeNormalize(T))
+    {
+        // UVが縮退している場合は任意の基底を使う.
+        asdx::Vector3 dummy;
+        asdx::CalcONB(N, T, dummy);
+        return EncodeTBN(N, T, 0);
+    }
+
+    // 従法線が N x T と逆向きならミラーリングされている.
+    uint8_t handedness = (Dot(Cross(N, T), B) < 0.0f) ? 1 : 0;
+    return EncodeTBN(N, T, handedness);
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      接線空間を生成します.
+//-----------------------------------------------------------------------------
+void GenerateTangentSpaces
+(
+    size_t                  vertexCount,
+    const asdx::Vector3*    pPositions,
+    const asdx::Vector3*    pNormals,
+    const asdx::Vector2*    pTexCoords,
+    size_t                  indexCount,
+    const uint32_t*         pIndices,
+    uint32_t*               pTangentSpaces
+)
+{
+    auto faceCount = indexCount / 3;
+
+    // 面接線を求める.
+    std::vector<FaceTangent> faces(faceCount);
+    ParallelFor(faceCount, kGrainSize, [&](size_t begin, size_t end)
+    {
+        for(auto i=begin; i<end; ++i)
+        {
+            auto i0 = pIndices[i * 3 + 0];
+            auto i1 = pIndices[i * 3 + 1];
+            auto i2 = pIndices[i * 3 + 2];
+
+            faces[i] = CalcFaceTangent(
+                pPositions[i0], pPositions[i1], pPositions[i2],
+                pTexCoords[i0], pTexCoords[i1], pTexCoords[i2]);
+        }
+    });
+
+    // 頂点からコーナーを引けるようにする(CSR形式).
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for(size_t i=0; i<indexCount; ++i)
+    { offsets[pIndices[i] + 1]++; }
+
+    for(size_t i=0; i<vertexCount; ++i)
+    { offsets[i + 1] += offsets[i]; }
+
+    std::vector<uint32_t> corners(indexCount);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for(size_t i=0; i<indexCount; ++i)
+        { corners[cursor[pIndices[i]]++] = uint32_t(i); }
+    }
+
+    // 頂点単位で集約する. 書き込み先が重複しないのでロック不要.
+    ParallelFor(vertexCount, kGrainSize, [&](size_t begin, size_t end)
+    {
+        for(auto v=begin; v<end; ++v)
+        {
+            const auto& N = pNormals[v];
+            asdx::Vector3 T(0.0f, 0.0f, 0.0f);
+            asdx::Vector3 B(0.0f, 0.0f, 0.0f);
+
+            for(auto c=offsets[v]; c<offsets[v + 1]; ++c)
+            {
+                auto corner = corners[c];
+                auto face   = corner / 3;
+                auto k      = corner % 3;
+
+                auto p0 = pPositions[pIndices[face * 3 + k]];
+                auto p1 = pPositions[pIndices[face * 3 + (k + 1) % 3]];
+                auto p2 = pPositions[pIndices[face * 3 + (k + 2) % 3]];
+                AccumulateCorner(N, p0, p1, p2, faces[face], T, B);
+            }
+
+            pTangentSpaces[v] = ResolveTangentSpace(N, T, B);
+        }
+    });
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TangentAccumulator class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      累積先を確保します.
+//-----------------------------------------------------------------------------
+void TangentAccumulator::Init(size_t slotCount)
+{
+    m_Tangents .assign(slotCount, asdx::Vector3(0.0f, 0.0f, 0.0f));
+    m_Binormals.assign(slotCount, asdx::Vector3(0.0f, 0.0f, 0.0f));
+}
+
+//-----------------------------------------------------------------------------
+//      三角形の寄与を累積します.
+//-----------------------------------------------------------------------------
+void TangentAccumulator::AddFace
+(
+    const uint32_t          slots    [3],
+    const asdx::Vector3     positions[3],
+    const asdx::Vector3     normals  [3],
+    const asdx::Vector2     texcoords[3]
+)
+{
+    auto ft = CalcFaceTangent(
+        positions[0], positions[1], positions[2],
+        texcoords[0], texcoords[1], texcoords[2]);
+
+    for(auto k=0; k<3; ++k)
+    {
+        AccumulateCorner(
+            normals[k],
+            positions[k],
+            positions[(k + 1) % 3],
+            positions[(k + 2) % 3],
+            ft,
+            m_Tangents [slots[k]],
+            m_Binormals[slots[k]]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      累積結果からエンコード済み接線空間を求めます.
+//-----------------------------------------------------------------------------
+uint32_t TangentAccumulator::Resolve(uint32_t slot, const asdx::Vector3& normal) const
+{ return ResolveTangentSpace(normal, m_Tangents[slot], m_Binormals[slot]); }
\ No newline at end of file
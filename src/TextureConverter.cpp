@@ -0,0 +1,368 @@
+﻿//-----------------------------------------------------------------------------
+// File : TextureConverter.cpp
+// Desc : Texture Converter.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <TextureConverter.h>
+#include <asdxLogger.h>
+#include <DirectXTex.h>
+#include <Windows.h>
+#include <set>
+#include <unordered_map>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      用途に応じた圧縮フォーマットを取得します.
+//-----------------------------------------------------------------------------
+DXGI_FORMAT GetCompressFormat(TEXTURE_USAGE usage)
+{
+    switch(usage)
+    {
+    // カラーは品質重視.
+    case TEXTURE_USAGE_DIFFUSE:
+    case TEXTURE_USAGE_REFLECTION:
+        return DXGI_FORMAT_BC7_UNORM_SRGB;
+
+    case TEXTURE_USAGE_EMISSIVE:
+    case TEXTURE_USAGE_AMBIENT:
+    case TEXTURE_USAGE_LIGHTMAP:
+        return DXGI_FORMAT_BC1_UNORM_SRGB;
+
+    // 法線はXYの2チャンネルのみ格納する.
+    case TEXTURE_USAGE_NORMAL:
+        return DXGI_FORMAT_BC5_UNORM;
+
+    // 不透明度は階調を残すためアルファ付き.
+    case TEXTURE_USAGE_OPACITY:
+        return DXGI_FORMAT_BC3_UNORM;
+
+    default:
+        return DXGI_FORMAT_BC1_UNORM;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      UTF-8文字列をワイド文字列に変換します.
+//-----------------------------------------------------------------------------
+std::wstring ToWide(const std::string& value)
+{
+    auto length = MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, nullptr, 0);
+    if (length <= 0)
+    { return std::wstring(); }
+
+    std::wstring result(size_t(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, &result[0], length);
+    result.resize(size_t(length - 1));
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      拡張子を除いたファイル名を取得します.
+//-----------------------------------------------------------------------------
+std::string GetStem(const std::string& path)
+{
+    auto begin = path.find_last_of("/\\");
+    begin = (begin == std::string::npos) ? 0 : begin + 1;
+
+    auto end = path.find_last_of('.');
+    if (end == std::string::npos || end < begin)
+    { end = path.size(); }
+
+    return path.substr(begin, end - begin);
+}
+
+//-----------------------------------------------------------------------------
+//      拡張子を取得します.
+//-----------------------------------------------------------------------------
+std::string GetExt(const std::string& path)
+{
+    auto pos = path.find_last_of('.');
+    if (pos == std::string::npos)
+    { return std::string(); }
+
+    return path.substr(pos + 1);
+}
+
+//-----------------------------------------------------------------------------
+//      絶対パスかどうか判定します.
+//-----------------------------------------------------------------------------
+bool IsAbsolutePath(const std::string& path)
+{
+    if (path.size() >= 2 && path[1] == ':')
+    { return true; }
+
+    return !path.empty() && (path[0] == '/' || path[0] == '\\');
+}
+
+//-----------------------------------------------------------------------------
+//      ディレクトリとファイル名を結合します.
+//-----------------------------------------------------------------------------
+std::string Combine(const std::string& dir, const std::string& name)
+{
+    if (dir.empty())
+    { return name; }
+
+    auto last = dir.back();
+    if (last == '/' || last == '\\')
+    { return dir + name; }
+
+    return dir + "/" + name;
+}
+
+//-----------------------------------------------------------------------------
+//      画像ファイルを読み込みます.
+//-----------------------------------------------------------------------------
+HRESULT LoadImageFile(const std::wstring& path, const std::string& ext, DirectX::ScratchImage& image)
+{
+    DirectX::TexMetadata metadata;
+
+    if (_stricmp(ext.c_str(), "dds") == 0)
+    { return DirectX::LoadFromDDSFile(path.c_str(), DirectX::DDS_FLAGS_NONE, &metadata, image); }
+
+    if (_stricmp(ext.c_str(), "tga") == 0)
+    { return DirectX::LoadFromTGAFile(path.c_str(), &metadata, image); }
+
+    if (_stricmp(ext.c_str(), "hdr") == 0)
+    { return DirectX::LoadFromHDRFile(path.c_str(), &metadata, image); }
+
+    // 色空間は用途で決めるので，ファイルの sRGB 指定は無視する.
+    return DirectX::LoadFromWICFile(path.c_str(), DirectX::WIC_FLAGS_IGNORE_SRGB, &metadata, image);
+}
+
+//-----------------------------------------------------------------------------
+//      メモリ上のファイルイメージから画像を読み込みます.
+//-----------------------------------------------------------------------------
+HRESULT LoadImageMemory(const std::vector<uint8_t>& data, const std::string& ext, DirectX::ScratchImage& image)
+{
+    DirectX::TexMetadata metadata;
+
+    if (data.empty())
+    { return E_FAIL; }
+
+    if (_stricmp(ext.c_str(), "dds") == 0)
+    { return DirectX::LoadFromDDSMemory(data.data(), data.size(), DirectX::DDS_FLAGS_NONE, &metadata, image); }
+
+    if (_stricmp(ext.c_str(), "tga") == 0)
+    { return DirectX::LoadFromTGAMemory(data.data(), data.size(), &metadata, image); }
+
+    if (_stricmp(ext.c_str(), "hdr") == 0)
+    { return DirectX::LoadFromHDRMemory(data.data(), data.size(), &metadata, image); }
+
+    return DirectX::LoadFromWICMemory(data.data(), data.size(), DirectX::WIC_FLAGS_IGNORE_SRGB, &metadata, image);
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+TextureConverter::~TextureConverter()
+{ End(); }
+
+//-----------------------------------------------------------------------------
+//      変換を開始します.
+//-----------------------------------------------------------------------------
+bool TextureConverter::Begin
+(
+    const std::vector<Material>&        materials,
+    const std::vector<TextureEntry>&    textures,
+    const TextureConvertOption&         option
+)
+{
+    m_Option   = option;
+    m_Textures = textures;
+    m_FailedCount = 0;
+    m_Jobs.clear();
+    m_Jobs.resize(m_Textures.size());
+
+    // 用途を決める. 法線として参照されていれば法線を優先する.
+    std::unordered_map<uint32_t, TEXTURE_USAGE> usages;
+    for(auto& material : materials)
+    {
+        for(auto& texture : material.Textures)
+        {
+            auto itr = usages.find(texture.PathId);
+            if (itr == usages.end() || texture.Usage == TEXTURE_USAGE_NORMAL)
+            { usages[texture.PathId] = texture.Usage; }
+        }
+    }
+
+    // 出力パスを確定する. 同名ファイルはIDを付けて区別する.
+    std::set<std::string> names;
+    for(size_t i=0; i<m_Textures.size(); ++i)
+    {
+        auto& entry = m_Textures[i];
+        auto& job   = m_Jobs[i];
+
+        auto itr = usages.find(entry.Id);
+        job.Usage    = (itr != usages.end()) ? itr->second : TEXTURE_USAGE_NONE;
+        job.SrcPath  = entry.Path;
+        job.Embedded = entry.Embedded;
+        job.Success  = false;
+
+        if (entry.Path.empty())
+        { continue; }
+
+        // 埋め込みテクスチャはメモリから直接読むので一時ファイルは作らない.
+        if (job.Embedded == nullptr && !IsAbsolutePath(job.SrcPath))
+        { job.SrcPath = Combine(m_Option.InputDir, job.SrcPath); }
+
+        auto name = GetStem(entry.Path);
+        if (!names.insert(name).second)
+        { name += "_" + std::to_string(entry.Id); }
+
+        job.DstPath = Combine(m_Option.OutputDir, name + ".dds");
+        entry.Path  = job.DstPath;
+    }
+
+    if (!m_Pool.Init(m_Option.ThreadCount))
+    {
+        ELOGA("Error : ThreadPool::Init() Failed.");
+        return false;
+    }
+
+    for(auto& job : m_Jobs)
+    {
+        if (job.DstPath.empty())
+        { continue; }
+
+        auto pJob = &job;
+        m_Pool.Push([this, pJob]() { Convert(*pJob); });
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全ての変換の完了を待機します.
+//-----------------------------------------------------------------------------
+size_t TextureConverter::End()
+{
+    if (m_Pool.GetThreadCount() == 0)
+    { return m_FailedCount; }
+
+    m_Pool.Wait();
+    m_Pool.Term();
+
+    // 失敗したものは元のパスのまま参照させる.
+    for(size_t i=0; i<m_Jobs.size(); ++i)
+    {
+        auto& job = m_Jobs[i];
+        if (!job.DstPath.empty() && !job.Success)
+        { m_Textures[i].Path = job.SrcPath; }
+    }
+
+    return m_FailedCount;
+}
+
+//-----------------------------------------------------------------------------
+//      出力パスに書き換えたテクスチャを取得します.
+//-----------------------------------------------------------------------------
+const std::vector<TextureEntry>& TextureConverter::GetTextures() const
+{ return m_Textures; }
+
+//-----------------------------------------------------------------------------
+//      1つのテクスチャを変換します.
+//-----------------------------------------------------------------------------
+void TextureConverter::Convert(Job& job)
+{
+    // WIC を使うためワーカースレッドごとに COM を初期化する.
+    auto hrCom = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    auto format  = GetCompressFormat(job.Usage);
+    auto srcPath = ToWide(job.SrcPath);
+    auto dstPath = ToWide(job.DstPath);
+
+    auto fail = [&](const char* stage, HRESULT hr)
+    {
+        ELOGA("Error : Texture Convert Failed. stage = %s, hr = 0x%08x, path = %s", stage, uint32_t(hr), job.SrcPath.c_str());
+        m_FailedCount++;
+    };
+
+    do
+    {
+        DirectX::ScratchImage image;
+        auto hr = (job.Embedded != nullptr)
+            ? LoadImageMemory(*job.Embedded, GetExt(job.SrcPath), image)
+            : LoadImageFile(srcPath, GetExt(job.SrcPath), image);
+        if (FAILED(hr))
+        { fail("Load", hr); break; }
+
+        // 圧縮済みのものは一旦展開する.
+        if (DirectX::IsCompressed(image.GetMetadata().format))
+        {
+            DirectX::ScratchImage decompressed;
+            hr = DirectX::Decompress(
+                image.GetImages(),
+                image.GetImageCount(),
+                image.GetMetadata(),
+                DXGI_FORMAT_UNKNOWN,
+                decompressed);
+            if (FAILED(hr))
+            { fail("Decompress", hr); break; }
+
+            image = std::move(decompressed);
+        }
+
+        // 用途で決めた色空間として扱う. ミップ生成時のフィルタも色空間に従う.
+        {
+            auto srcFormat = image.GetMetadata().format;
+            auto dstFormat = DirectX::IsSRGB(format)
+                ? DirectX::MakeSRGB(srcFormat)
+                : DirectX::MakeLinear(srcFormat);
+            image.OverrideFormat(dstFormat);
+        }
+
+        if (m_Option.GenerateMips && image.GetMetadata().mipLevels <= 1)
+        {
+            DirectX::ScratchImage mipChain;
+            hr = DirectX::GenerateMipMaps(
+                image.GetImages(),
+                image.GetImageCount(),
+                image.GetMetadata(),
+                DirectX::TEX_FILTER_DEFAULT,
+                0,
+                mipChain);
+            if (FAILED(hr))
+            { fail("GenerateMipMaps", hr); break; }
+
+            image = std::move(mipChain);
+        }
+
+        // テクスチャ単位で並列化しているので圧縮自体は単一スレッドで行う.
+        DirectX::ScratchImage compressed;
+        hr = DirectX::Compress(
+            image.GetImages(),
+            image.GetImageCount(),
+            image.GetMetadata(),
+            format,
+            DirectX::TEX_COMPRESS_DEFAULT,
+            DirectX::TEX_THRESHOLD_DEFAULT,
+            compressed);
+        if (FAILED(hr))
+        { fail("Compress", hr); break; }
+
+        hr = DirectX::SaveToDDSFile(
+            compressed.GetImages(),
+            compressed.GetImageCount(),
+            compressed.GetMetadata(),
+            DirectX::DDS_FLAGS_NONE,
+            dstPath.c_str());
+        if (FAILED(hr))
+        { fail("Save", hr); break; }
+
+        job.Success = true;
+        ILOGA("Info : Texture Converted. %s -> %s", job.SrcPath.c_str(), job.DstPath.c_str());
+    }
+    while(false);
+
+    if (SUCCEEDED(hrCom))
+    { CoUninitialize(); }
+}
\ No newline at end of file
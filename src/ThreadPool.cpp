@@ -0,0 +1,146 @@
+﻿//-----------------------------------------------------------------------------
+// File : ThreadPool.cpp
+// Desc : Thread Pool.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ThreadPool.h>
+#include <algorithm>
+
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool ThreadPool::Init(uint32_t threadCount, size_t maxQueueSize)
+{
+    if (!m_Threads.empty())
+    { return false; }
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    m_MaxQueueSize = maxQueueSize;
+    m_RunningCount = 0;
+    m_Terminate    = false;
+
+    m_Threads.reserve(threadCount);
+    for(auto i=0u; i<threadCount; ++i)
+    { m_Threads.emplace_back(&ThreadPool::Run, this); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void ThreadPool::Term()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Terminate = true;
+    }
+    m_PushCond.notify_all();
+    m_PopCond .notify_all();
+
+    for(auto& thread : m_Threads)
+    {
+        if (thread.joinable())
+        { thread.join(); }
+    }
+
+    m_Threads.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      ジョブを追加します.
+//-----------------------------------------------------------------------------
+bool ThreadPool::Push(std::function<void()> job)
+{
+    {
+        std::unique_lock<std::mutex> locker(m_Mutex);
+        m_PopCond.wait(locker, [&]
+        { return m_Terminate || m_MaxQueueSize == 0 || m_Jobs.size() < m_MaxQueueSize; });
+
+        if (m_Terminate)
+        { return false; }
+
+        m_Jobs.push_back(std::move(job));
+    }
+    m_PushCond.notify_one();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ブロックせずにジョブを追加します.
+//-----------------------------------------------------------------------------
+bool ThreadPool::TryPush(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        if (m_Terminate || (m_MaxQueueSize > 0 && m_Jobs.size() >= m_MaxQueueSize))
+        { return false; }
+
+        m_Jobs.push_back(std::move(job));
+    }
+    m_PushCond.notify_one();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全ジョブの完了を待機します.
+//-----------------------------------------------------------------------------
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> locker(m_Mutex);
+    m_IdleCond.wait(locker, [&]
+    { return m_Jobs.empty() && m_RunningCount == 0; });
+}
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッド数を取得します.
+//-----------------------------------------------------------------------------
+size_t ThreadPool::GetThreadCount() const
+{ return m_Threads.size(); }
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッドの処理です.
+//-----------------------------------------------------------------------------
+void ThreadPool::Run()
+{
+    for(;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> locker(m_Mutex);
+            m_PushCond.wait(locker, [&]
+            { return m_Terminate || !m_Jobs.empty(); });
+
+            // 終了要求があっても残っているジョブは実行する.
+            if (m_Jobs.empty())
+            { return; }
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+            m_RunningCount++;
+        }
+        m_PopCond.notify_one();
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            m_RunningCount--;
+            if (m_Jobs.empty() && m_RunningCount == 0)
+            { m_IdleCond.notify_all(); }
+        }
+    }
+}
\ No newline at end of file
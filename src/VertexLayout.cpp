@@ -0,0 +1,209 @@
+﻿//-----------------------------------------------------------------------------
+// File : VertexLayout.cpp
+// Desc : Interleaved Vertex Layout.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <VertexLayout.h>
+#include <asdxLogger.h>
+#include <meshoptimizer.h>
+#include <cstring>
+#include <string>
+
+
+namespace /* anonymous */ {
+
+///////////////////////////////////////////////////////////////////////////////
+// AttributeInfo structure
+///////////////////////////////////////////////////////////////////////////////
+struct AttributeInfo
+{
+    const char*         Name;       //!< 指定名です.
+    VERTEX_ATTRIBUTE    Attribute;  //!< 属性です.
+    uint32_t            Size;       //!< 1頂点あたりのバイト数です.
+};
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const AttributeInfo kAttributes[VERTEX_ATTRIBUTE_COUNT] = {
+    { "tangent",        VERTEX_ATTRIBUTE_TANGENT_SPACE, sizeof(uint32_t)            },
+    { "color",          VERTEX_ATTRIBUTE_COLOR,         sizeof(uint32_t)            },
+    { "uv0",            VERTEX_ATTRIBUTE_TEXCOORD0,     sizeof(uint32_t)            },
+    { "uv1",            VERTEX_ATTRIBUTE_TEXCOORD1,     sizeof(uint32_t)            },
+    { "uv2",            VERTEX_ATTRIBUTE_TEXCOORD2,     sizeof(uint32_t)            },
+    { "uv3",            VERTEX_ATTRIBUTE_TEXCOORD3,     sizeof(uint32_t)            },
+    { "bone_index",     VERTEX_ATTRIBUTE_BONE_INDEX,    sizeof(asdx::ResBoneIndex)  },
+    { "bone_weight",    VERTEX_ATTRIBUTE_BONE_WEIGHT,   sizeof(asdx::Vector4)       },
+};
+
+//-----------------------------------------------------------------------------
+//      属性のデータを取得します.
+//-----------------------------------------------------------------------------
+const uint8_t* GetAttributeData(const asdx::ResMesh& mesh, VERTEX_ATTRIBUTE attribute, size_t& count)
+{
+    switch(attribute)
+    {
+    case VERTEX_ATTRIBUTE_TANGENT_SPACE:
+        count = mesh.TangentSpaces.size();
+        return reinterpret_cast<const uint8_t*>(mesh.TangentSpaces.data());
+
+    case VERTEX_ATTRIBUTE_COLOR:
+        count = mesh.Colors.size();
+        return reinterpret_cast<const uint8_t*>(mesh.Colors.data());
+
+    case VERTEX_ATTRIBUTE_TEXCOORD0:
+    case VERTEX_ATTRIBUTE_TEXCOORD1:
+    case VERTEX_ATTRIBUTE_TEXCOORD2:
+    case VERTEX_ATTRIBUTE_TEXCOORD3:
+        {
+            auto& texcoords = mesh.TexCoords[attribute - VERTEX_ATTRIBUTE_TEXCOORD0];
+            count = texcoords.size();
+            return reinterpret_cast<const uint8_t*>(texcoords.data());
+        }
+
+    case VERTEX_ATTRIBUTE_BONE_INDEX:
+        count = mesh.BoneIndices.size();
+        return reinterpret_cast<const uint8_t*>(mesh.BoneIndices.data());
+
+    case VERTEX_ATTRIBUTE_BONE_WEIGHT:
+        count = mesh.BoneWeights.size();
+        return reinterpret_cast<const uint8_t*>(mesh.BoneWeights.data());
+
+    default:
+        count = 0;
+        return nullptr;
+    }
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      属性の並び順を解析します.
+//-----------------------------------------------------------------------------
+bool ParseVertexLayout(const char* value, std::vector<VERTEX_ATTRIBUTE>& order)
+{
+    order.clear();
+
+    std::string list(value);
+    size_t begin = 0;
+    while (begin <= list.size())
+    {
+        auto end = list.find(',', begin);
+        if (end == std::string::npos)
+        { end = list.size(); }
+
+        auto name = list.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (name.empty())
+        { continue; }
+
+        if (name == "all")
+        {
+            for(auto& info : kAttributes)
+            { order.push_back(info.Attribute); }
+            continue;
+        }
+
+        auto found = false;
+        for(auto& info : kAttributes)
+        {
+            if (name == info.Name)
+            {
+                order.push_back(info.Attribute);
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            ELOGA("Error : Unknown Vertex Attribute. name = %s", name.c_str());
+            return false;
+        }
+    }
+
+    return !order.empty();
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュに合わせて頂点レイアウトを決定します.
+//-----------------------------------------------------------------------------
+VertexLayout GetVertexLayout(const asdx::ResMesh& mesh, const std::vector<VERTEX_ATTRIBUTE>& order)
+{
+    VertexLayout layout;
+
+    auto vertexCount = mesh.Positions.size();
+    for(auto attribute : order)
+    {
+        // 重複指定と，メッシュが持たない属性は除外.
+        if ((layout.Mask & (0x1u << attribute)) != 0)
+        { continue; }
+
+        size_t count = 0;
+        GetAttributeData(mesh, attribute, count);
+        if (count == 0 || count != vertexCount)
+        { continue; }
+
+        layout.Offsets[attribute] = uint8_t(layout.Stride);
+        layout.Mask   |= (0x1u << attribute);
+        layout.Stride += kAttributes[attribute].Size;
+    }
+
+    return layout;
+}
+
+//-----------------------------------------------------------------------------
+//      インターリーブした頂点データを構築します.
+//-----------------------------------------------------------------------------
+void BuildInterleavedVertices
+(
+    const asdx::ResMesh&    mesh,
+    const VertexLayout&     layout,
+    std::vector<uint8_t>&   data
+)
+{
+    data.clear();
+    if (layout.Stride == 0)
+    { return; }
+
+    auto vertexCount = mesh.Positions.size();
+    data.resize(vertexCount * layout.Stride);
+
+    // 属性ごとに書き込むと読み込み側は連続アクセスになる.
+    for(auto i=0; i<VERTEX_ATTRIBUTE_COUNT; ++i)
+    {
+        if ((layout.Mask & (0x1u << i)) == 0)
+        { continue; }
+
+        size_t count = 0;
+        auto pSrc = GetAttributeData(mesh, VERTEX_ATTRIBUTE(i), count);
+        auto size = kAttributes[i].Size;
+        auto pDst = data.data() + layout.Offsets[i];
+
+        for(size_t v=0; v<vertexCount; ++v)
+        { memcpy(pDst + v * layout.Stride, pSrc + v * size, size); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      メッシュレットの頂点順で頂点フェッチの過剰読み込み率を求めます.
+//-----------------------------------------------------------------------------
+float AnalyzeVertexFetch(const asdx::ResMesh& mesh, uint32_t stride)
+{
+    if (mesh.Indices.empty() || stride == 0)
+    { return 0.0f; }
+
+    auto stats = meshopt_analyzeVertexFetch(
+        mesh.Indices.data(),
+        mesh.Indices.size(),
+        mesh.Positions.size(),
+        stride);
+
+    return stats.overfetch;
+}
\ No newline at end of file
@@ -0,0 +1,442 @@
+﻿//-----------------------------------------------------------------------------
+// File : Watcher.cpp
+// Desc : Source Directory Watcher.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <Watcher.h>
+#include <Converter.h>
+#include <ConvertCache.h>
+#include <ImporterPool.h>
+#include <ThreadPool.h>
+#include <asdxLogger.h>
+#include <assimp/Importer.hpp>
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using Clock = std::chrono::steady_clock;
+
+//-----------------------------------------------------------------------------
+// Global Variables.
+//-----------------------------------------------------------------------------
+std::atomic<bool>   g_StopRequested(false);
+
+
+//-----------------------------------------------------------------------------
+//      コンソールの制御イベントを処理します.
+//-----------------------------------------------------------------------------
+BOOL WINAPI OnConsoleCtrl(DWORD type)
+{
+    if (type == CTRL_C_EVENT || type == CTRL_BREAK_EVENT)
+    {
+        g_StopRequested = true;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+//-----------------------------------------------------------------------------
+//      UTF-8文字列をワイド文字列に変換します.
+//-----------------------------------------------------------------------------
+std::wstring ToWide(const std::string& value)
+{
+    auto length = MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, nullptr, 0);
+    if (length <= 0)
+    { return std::wstring(); }
+
+    std::wstring result(size_t(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, &result[0], length);
+    result.resize(size_t(length - 1));
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ワイド文字列をUTF-8文字列に変換します.
+//-----------------------------------------------------------------------------
+std::string ToUtf8(const wchar_t* value, int count)
+{
+    auto length = WideCharToMultiByte(CP_UTF8, 0, value, count, nullptr, 0, nullptr, nullptr);
+    if (length <= 0)
+    { return std::string(); }
+
+    std::string result(size_t(length), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, value, count, &result[0], length, nullptr, nullptr);
+
+    // 終端文字まで変換した場合は取り除く.
+    if (count < 0)
+    { result.pop_back(); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ディレクトリとファイル名を結合します.
+//-----------------------------------------------------------------------------
+std::string Combine(const std::string& dir, const std::string& name)
+{
+    if (dir.empty())
+    { return name; }
+
+    auto last = dir.back();
+    if (last == '/' || last == '\\')
+    { return dir + name; }
+
+    return dir + "\\" + name;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルの親ディレクトリを作成します.
+//-----------------------------------------------------------------------------
+void CreateParentDirectory(const std::string& path)
+{
+    if (path.empty())
+    { return; }
+
+    auto wide = ToWide(path);
+    for(size_t i=1; i<wide.size(); ++i)
+    {
+        if (wide[i] != L'/' && wide[i] != L'\\')
+        { continue; }
+
+        // ドライブ名はスキップ.
+        if (wide[i - 1] == L':')
+        { continue; }
+
+        CreateDirectoryW(wide.substr(0, i).c_str(), nullptr);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WatchContext class
+///////////////////////////////////////////////////////////////////////////////
+class WatchContext
+{
+public:
+    //-------------------------------------------------------------------------
+    //      コンストラクタです.
+    //-------------------------------------------------------------------------
+    WatchContext(const WatchOption& option, const ConvertArgs& args, uint64_t optionHash)
+    : m_Option      (option)
+    , m_Args        (args)
+    , m_OptionHash  (optionHash)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //      変換対象のファイルかどうか判定します.
+    //-------------------------------------------------------------------------
+    bool IsTarget(const std::string& path) const
+    {
+        auto pos = path.find_last_of('.');
+        if (pos == std::string::npos)
+        { return false; }
+
+        return m_Importer.IsExtensionSupported(path.substr(pos).c_str());
+    }
+
+    //-------------------------------------------------------------------------
+    //      変更を通知します.
+    //-------------------------------------------------------------------------
+    void Notify(const std::string& key)
+    {
+        if (!IsTarget(key))
+        { return; }
+
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Pending[key] = Clock::now();
+    }
+
+    //-------------------------------------------------------------------------
+    //      ディレクトリ以下の全ファイルを通知します.
+    //-------------------------------------------------------------------------
+    void NotifyAll(const std::string& relDir)
+    {
+        auto pattern = ToWide(Combine(Combine(m_Option.SourceDir, relDir), "*"));
+
+        WIN32_FIND_DATAW data;
+        auto handle = FindFirstFileW(pattern.c_str(), &data);
+        if (handle == INVALID_HANDLE_VALUE)
+        { return; }
+
+        do
+        {
+            if (wcscmp(data.cFileName, L".") == 0 || wcscmp(data.cFileName, L"..") == 0)
+            { continue; }
+
+            auto key = relDir.empty()
+                ? ToUtf8(data.cFileName, -1)
+                : Combine(relDir, ToUtf8(data.cFileName, -1));
+
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            { NotifyAll(key); }
+            else
+            { Notify(key); }
+        }
+        while (FindNextFileW(handle, &data));
+
+        FindClose(handle);
+    }
+
+    //-------------------------------------------------------------------------
+    //      待ち時間を過ぎたファイルの変換を開始します.
+    //-------------------------------------------------------------------------
+    void Dispatch(ThreadPool& pool)
+    {
+        auto now   = Clock::now();
+        auto delay = std::chrono::milliseconds(m_Option.DelayMsec);
+
+        std::lock_guard<std::mutex> locker(m_Mutex);
+
+        auto itr = m_Pending.begin();
+        while (itr != m_Pending.end())
+        {
+            // 書き込み中 または 変換中のファイルは次回に回す.
+            if (now - itr->second < delay || m_Running.count(itr->first) > 0)
+            {
+                ++itr;
+                continue;
+            }
+
+            auto key = itr->first;
+            if (!pool.TryPush([this, key]() { Convert(key); }))
+            { break; }  // キューが一杯なので空くまで待つ.
+
+            m_Running.insert(key);
+            itr = m_Pending.erase(itr);
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //      キャッシュを取得します.
+    //-------------------------------------------------------------------------
+    ConvertCache& GetCache()
+    { return m_Cache; }
+
+private:
+    const WatchOption&                  m_Option;       //!< 監視オプションです.
+    const ConvertArgs&                  m_Args;         //!< 変換引数のテンプレートです.
+    uint64_t                            m_OptionHash;   //!< 変換オプションのハッシュです.
+    Assimp::Importer                    m_Importer;     //!< 拡張子の判定に使います.
+    ImporterPool                        m_Importers;    //!< 変換ジョブで使い回すインポーターです.
+    ConvertCache                        m_Cache;        //!< 変換キャッシュです.
+    std::mutex                          m_Mutex;        //!< ミューテックスです.
+    std::map<std::string, Clock::time_point>    m_Pending;  //!< 最後に変更された時刻です.
+    std::set<std::string>               m_Running;      //!< 変換中のファイルです.
+
+    //-------------------------------------------------------------------------
+    //      1つのファイルを変換します.
+    //-------------------------------------------------------------------------
+    void Convert(const std::string& key)
+    {
+        auto args = m_Args;
+        args.Input = Combine(m_Option.SourceDir, key);
+        args.Option.pImporterPool = &m_Importers;
+
+        auto name = key.substr(0, key.find_last_of('.'));
+        ExpandPaths(name, args);
+
+        std::vector<std::string> outputs;
+        GetOutputPaths(args, outputs);
+
+        uint64_t fileHash = 0;
+        if (!CalcFileHash(args.Input.c_str(), fileHash))
+        {
+            // 削除されたか，まだ書き込み中.
+            ELOGA("Error : File Open Failed. path = %s", args.Input.c_str());
+            Finish(key);
+            return;
+        }
+
+        // 出力が消されている場合は内容が同じでも変換し直す.
+        auto exists = std::all_of(outputs.begin(), outputs.end(), [](const std::string& path)
+        { return GetFileAttributesW(ToWide(path).c_str()) != INVALID_FILE_ATTRIBUTES; });
+        if (exists && m_Cache.IsUpToDate(key, fileHash, m_OptionHash))
+        {
+            ILOGA("Info : Skip (Up To Date). path = %s", args.Input.c_str());
+            Finish(key);
+            return;
+        }
+
+        for(auto& path : outputs)
+        { CreateParentDirectory(path); }
+
+        ConvertStats stats;
+        if (::Convert(args, &stats))
+        {
+            ILOGA("Info : Convert OK! path = %s, time = %.2lf[msec]", args.Input.c_str(), stats.ElapsedMsec);
+            m_Cache.Update(key, fileHash, m_OptionHash);
+            if (!m_Option.CachePath.empty())
+            { m_Cache.Save(m_Option.CachePath.c_str()); }
+        }
+        else
+        { ELOGA("Error : Convert Failed. path = %s", args.Input.c_str()); }
+
+        Finish(key);
+    }
+
+    //-------------------------------------------------------------------------
+    //      変換中の状態を解除します.
+    //-------------------------------------------------------------------------
+    void Finish(const std::string& key)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Running.erase(key);
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      ディレクトリの変更通知を受け取ります.
+//-----------------------------------------------------------------------------
+void WatchDirectory(HANDLE handle, WatchContext& context, std::atomic<bool>& finished)
+{
+    const DWORD kFilter = FILE_NOTIFY_CHANGE_FILE_NAME
+                        | FILE_NOTIFY_CHANGE_DIR_NAME
+                        | FILE_NOTIFY_CHANGE_LAST_WRITE
+                        | FILE_NOTIFY_CHANGE_SIZE;
+
+    // FILE_NOTIFY_INFORMATION は DWORD 境界に配置する必要がある.
+    std::vector<DWORD> buffer(16 * 1024);
+
+    while (!g_StopRequested)
+    {
+        DWORD size = 0;
+        if (!ReadDirectoryChangesW(
+            handle,
+            buffer.data(),
+            DWORD(buffer.size() * sizeof(DWORD)),
+            TRUE,
+            kFilter,
+            &size,
+            nullptr,
+            nullptr))
+        {
+            // 終了時は CancelSynchronousIo() で中断されるので報告しない.
+            if (!g_StopRequested)
+            { ELOGA("Error : ReadDirectoryChangesW() Failed. error = %lu", GetLastError()); }
+            break;
+        }
+
+        // バッファが溢れた場合は変更を取りこぼしているので全体を走査し直す.
+        if (size == 0)
+        {
+            context.NotifyAll(std::string());
+            continue;
+        }
+
+        auto ptr = reinterpret_cast<const uint8_t*>(buffer.data());
+        for(;;)
+        {
+            auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(ptr);
+            if (info->Action == FILE_ACTION_ADDED
+             || info->Action == FILE_ACTION_MODIFIED
+             || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+            { context.Notify(ToUtf8(info->FileName, int(info->FileNameLength / sizeof(WCHAR)))); }
+
+            if (info->NextEntryOffset == 0)
+            { break; }
+
+            ptr += info->NextEntryOffset;
+        }
+    }
+
+    finished = true;
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------
+//      ディレクトリを監視して変更されたモデルを変換します.
+//-----------------------------------------------------------------------------
+int RunWatch(const WatchOption& option, int argc, const char* const* argv)
+{
+    ConvertArgs args;
+    if (!ParseArgs(argc, argv, args))
+    { return -1; }
+
+    if (!ValidateNamedOutputs(args))
+    { return -1; }
+
+    WatchContext context(option, args, CalcOptionHash(argc, argv));
+    if (!option.CachePath.empty())
+    { context.GetCache().Load(option.CachePath.c_str()); }
+
+    auto handle = CreateFileW(
+        ToWide(option.SourceDir).c_str(),
+        FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS,
+        nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        ELOGA("Error : Directory Open Failed. path = %s", option.SourceDir.c_str());
+        return -1;
+    }
+
+    ThreadPool pool;
+    if (!pool.Init(option.ThreadCount, std::max(option.MaxQueueSize, 1u)))
+    {
+        ELOGA("Error : ThreadPool::Init() Failed.");
+        CloseHandle(handle);
+        return -1;
+    }
+
+    g_StopRequested = false;
+    SetConsoleCtrlHandler(OnConsoleCtrl, TRUE);
+
+    // 監視開始前の変更はキャッシュと比較して取り込む.
+    context.NotifyAll(std::string());
+
+    std::atomic<bool> finished(false);
+    std::thread watcher(WatchDirectory, handle, std::ref(context), std::ref(finished));
+
+    ILOGA("Info : Watch Start. path = %s", option.SourceDir.c_str());
+
+    // 監視スレッドが終了した場合は変更を受け取れないので停止する.
+    while (!g_StopRequested && !finished)
+    {
+        context.Dispatch(pool);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    auto failed = !g_StopRequested;
+
+    // 待機中の ReadDirectoryChangesW() を中断する.
+    // 呼び出し直前だと取り消しが空振りするので，終了するまで繰り返す.
+    while (!finished)
+    {
+        CancelSynchronousIo(watcher.native_handle());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    watcher.join();
+
+    pool.Wait();
+    pool.Term();
+
+    CloseHandle(handle);
+    SetConsoleCtrlHandler(OnConsoleCtrl, FALSE);
+
+    if (failed)
+    {
+        ELOGA("Error : Watch Aborted. path = %s", option.SourceDir.c_str());
+        return -1;
+    }
+
+    ILOGA("Info : Watch Stop.");
+    return 0;
+}
\ No newline at end of file
@@ -7,71 +7,270 @@
 //-----------------------------------------------------------------------------
 // Includes
 //-----------------------------------------------------------------------------
-#include <MeshLoader.h>
+#include <Converter.h>
+#include <ImporterPool.h>
+#include <MappedModel.h>
+#include <SelfTest.h>
+#include <Server.h>
+#include <ThreadPool.h>
+#include <Watcher.h>
 #include <asdxLogger.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
 
 
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------
+//      従来形式とメモリマップ形式の読み込み時間を比較します.
+//-----------------------------------------------------------------------------
+int RunLoadBenchmark(const char* modelPath, const char* mappedPath, uint32_t count)
+{
+    using Clock = std::chrono::steady_clock;
+
+    double loadMsec  = 0.0;
+    double mapMsec   = 0.0;
+    double touchMsec = 0.0;
+
+    for(auto i=0u; i<count; ++i)
+    {
+        // 従来形式: ストリームごとに確保してコピーする.
+        {
+            auto begin = Clock::now();
+
+            asdx::ResModel model;
+            if (!asdx::LoadModel(modelPath, model))
+            {
+                ELOGA("Error : LoadModel() Failed. path = %s", modelPath);
+                return -1;
+            }
+
+            auto end = Clock::now();
+            loadMsec += std::chrono::duration<double, std::milli>(end - begin).count();
+
+            asdx::Dispose(model);
+        }
+
+        // メモリマップ形式: マップしてオフセットテーブルを検証するだけ.
+        {
+            auto begin = Clock::now();
+
+            MappedFile file;
+            if (!file.Open(mappedPath))
+            { return -1; }
+
+            if (GetMappedModel(file.GetData(), file.GetSize()) == nullptr)
+            {
+                ELOGA("Error : Invalid Mapped Model. path = %s", mappedPath);
+                return -1;
+            }
+
+            auto mapped = Clock::now();
+
+            // GPUへの転送時と同じく全ページに触れた場合のコストも計測する.
+            auto ptr = static_cast<const volatile uint8_t*>(file.GetData());
+            uint32_t sum = 0;
+            for(size_t offset=0; offset<file.GetSize(); offset+=4096)
+            { sum += ptr[offset]; }
+
+            auto end = Clock::now();
+            mapMsec   += std::chrono::duration<double, std::milli>(mapped - begin).count();
+            touchMsec += std::chrono::duration<double, std::milli>(end - begin).count();
+
+            (void)sum;
+        }
+    }
+
+    ILOGA("Info : [Bench] LoadModel          : %10.3f msec", loadMsec  / count);
+    ILOGA("Info : [Bench] Map + Validate     : %10.3f msec", mapMsec   / count);
+    ILOGA("Info : [Bench] Map + Touch Pages  : %10.3f msec", touchMsec / count);
+    return 0;
+}
+
 //-----------------------------------------------------------------------------
-//      テクスチャ用途を文字列にします.
+//      インポーターを毎回生成した場合と使い回した場合のロード時間を比較します.
 //-----------------------------------------------------------------------------
-const char* ToString(TEXTURE_USAGE usage)
+int RunImportBenchmark(int fileCount, const char* const* files, uint32_t count, uint32_t threadCount)
 {
-    const char* table[] = {
-        "NONE",
-        "DIFFUSE",
-        "SPECULAR",
-        "AMBIENT",
-        "EMISSIVE",
-        "HEIGHT",
-        "NORMAL",
-        "SHININESS",
-        "OPACITY",
-        "DISPLACEMENT",
-        "LIGHTMAP",
-        "REFLECTION"
+    using Clock = std::chrono::steady_clock;
+
+    ImporterPool importers;
+    ImporterPool parallelImporters;
+
+    MeshLoaderOption freshOption;
+    MeshLoaderOption pooledOption;
+    pooledOption.pImporterPool = &importers;
+
+    double freshMsec  = 0.0;
+    double pooledMsec = 0.0;
+
+    auto load = [](const char* path, const MeshLoaderOption& option, double& msec)
+    {
+        auto begin = Clock::now();
+
+        asdx::ResModel model;
+        MeshLoader loader;
+        if (!loader.Load(path, model, option))
+        {
+            ELOGA("Error : MeshLoader::Load() Failed. path = %s", path);
+            return false;
+        }
+
+        auto end = Clock::now();
+        msec += std::chrono::duration<double, std::milli>(end - begin).count();
+
+        asdx::Dispose(model);
+        return true;
+    };
+
+    // 小さなファイルほどインポーター生成のコストが目立つ.
+    for(auto i=0u; i<count; ++i)
+    {
+        for(auto j=0; j<fileCount; ++j)
+        {
+            if (!load(files[j], freshOption, freshMsec))
+            { return -1; }
+
+            if (!load(files[j], pooledOption, pooledMsec))
+            { return -1; }
+        }
+    }
+
+    // バッチ変換と同じくワーカーごとにインポーターを使い回して並列に読み込む.
+    // 1ファイルあたりの時間は全体の経過時間から求める.
+    auto parallelLoad = [&](const MeshLoaderOption& option, double& msec)
+    {
+        ThreadPool pool;
+        if (!pool.Init(threadCount))
+        {
+            ELOGA("Error : ThreadPool::Init() Failed.");
+            return false;
+        }
+
+        std::atomic<bool> succeeded(true);
+        auto begin = Clock::now();
+
+        for(auto i=0u; i<count; ++i)
+        {
+            for(auto j=0; j<fileCount; ++j)
+            {
+                auto path = files[j];
+                pool.Push([&, path]()
+                {
+                    double dummy = 0.0;
+                    if (!load(path, option, dummy))
+                    { succeeded = false; }
+                });
+            }
+        }
+
+        pool.Wait();
+        pool.Term();
+
+        auto end = Clock::now();
+        msec = std::chrono::duration<double, std::milli>(end - begin).count();
+        return bool(succeeded);
     };
 
-    return table[usage];
+    double parallelFreshMsec  = 0.0;
+    double parallelPooledMsec = 0.0;
+
+    MeshLoaderOption parallelOption;
+    parallelOption.pImporterPool = &parallelImporters;
+
+    if (!parallelLoad(freshOption, parallelFreshMsec))
+    { return -1; }
+
+    if (!parallelLoad(parallelOption, parallelPooledMsec))
+    { return -1; }
+
+    auto total = double(count) * fileCount;
+    ILOGA("Info : [Bench] Load (New Importer)             : %10.3f msec/file", freshMsec  / total);
+    ILOGA("Info : [Bench] Load (Pooled Importer)          : %10.3f msec/file", pooledMsec / total);
+    ILOGA("Info : [Bench] Parallel Load (New Importer)    : %10.3f msec/file", parallelFreshMsec  / total);
+    ILOGA("Info : [Bench] Parallel Load (Pooled Importer) : %10.3f msec/file", parallelPooledMsec / total);
+    ILOGA("Info : [Bench] Importer Count                  : %zu (parallel = %zu)", importers.GetCount(), parallelImporters.GetCount());
+    return 0;
 }
 
 //-----------------------------------------------------------------------------
-//      マテリアル情報をYAMLファイルに出力します.
+//      複数のモデルを並列に変換します.
 //-----------------------------------------------------------------------------
-bool ExportMaterialYaml(const char* name, const std::vector<Material>& materials)
+int RunBatch(const std::vector<const char*>& files, uint32_t threadCount, int argc, const char* const* argv)
 {
-    FILE* pFile;
-    auto err = fopen_s(&pFile, name, "w");
-    if (err != 0)
+    using Clock = std::chrono::steady_clock;
+
+    ConvertArgs args;
+    if (!ParseArgs(argc, argv, args))
+    { return -1; }
+
+    if (files.empty())
     {
-        ELOGA("Error : File Open Failed. path = %s", name);
-        return false;
+        ELOGA("Error : Missing Model Path.");
+        return -1;
     }
 
-    fprintf_s(pFile, "# Materials\n");
+    // 出力先が重ならないようにする.
+    if (files.size() > 1 && !ValidateNamedOutputs(args))
+    { return -1; }
 
-    for(size_t i=0; i<materials.size(); ++i)
+    // ワーカーごとにインポーターを1つ生成し，以降のファイルで使い回す.
+    ImporterPool importers;
+    ThreadPool   pool;
+    if (!pool.Init(threadCount))
     {
-        auto& mat = materials[i];
-        fprintf_s(pFile, "- name: %s\n", mat.Name.c_str());
-        fprintf_s(pFile, "  hash: %u\n", mat.Hash);
+        ELOGA("Error : ThreadPool::Init() Failed.");
+        return -1;
+    }
+
+    std::atomic<uint32_t> failedCount(0);
+    auto begin = Clock::now();
 
-        if (mat.Textures.size() > 0)
+    for(auto path : files)
+    {
+        pool.Push([&, path]()
         {
-            fprintf_s(pFile, "  textures:\n");
-            for(size_t j=0; j<mat.Textures.size(); ++j)
+            auto job = args;
+            job.Input = path;
+            job.Option.pImporterPool = &importers;
+
+            // {name} は入力ファイル名(拡張子なし)に置換.
+            std::string name = path;
+            auto pos = name.find_last_of("/\\");
+            if (pos != std::string::npos)
+            { name = name.substr(pos + 1); }
+            name = name.substr(0, name.find_last_of('.'));
+            ExpandPaths(name, job);
+
+            ConvertStats stats;
+            if (Convert(job, &stats))
+            { ILOGA("Info : Convert OK! path = %s, time = %.2lf[msec]", path, stats.ElapsedMsec); }
+            else
             {
-                auto& tex = mat.Textures[j];
-                fprintf_s(pFile, "    - usage: %s\n", ToString(tex.Usage));
-                fprintf_s(pFile, "      path: %s\n", tex.Path.c_str());
+                ELOGA("Error : Convert Failed. path = %s", path);
+                failedCount++;
             }
-        }
-        fprintf_s(pFile, "\n");
+        });
     }
 
-    fclose(pFile);
-    return true;
+    pool.Wait();
+    pool.Term();
+
+    auto end = Clock::now();
+    ILOGA("Info : Batch Done. files = %zu, failed = %u, importers = %zu, time = %.2lf[msec]",
+        files.size(),
+        uint32_t(failedCount),
+        importers.GetCount(),
+        std::chrono::duration<double, std::milli>(end - begin).count());
+
+    return (failedCount == 0) ? 0 : -1;
 }
 
+} // namespace /* anonymous */
+
+
 //-----------------------------------------------------------------------------
 //      メインエントリーポイントです.
 //-----------------------------------------------------------------------------
@@ -82,55 +281,169 @@ int main(int argc, char** argv)
         return 0;
     }
 
-    std::string input;
-    std::string output;
-    std::string matyaml;
+    // 自己テストを実行.
+    //  -selftest
+    if (strcmp(argv[1], "-selftest") == 0)
+    { return RunSelfTest(); }
 
-    for(auto i=0; i<argc; ++i)
+    // 常駐サーバーとして起動.
+    //  -server <socket path> [-thread <count>]
+    if (strcmp(argv[1], "-server") == 0)
     {
-        if (strcmp(argv[i], "-i") == 0)
+        if (argc < 3)
         {
-            i++;
-            input = argv[i];
+            ELOGA("Error : Missing Socket Path.");
+            return -1;
         }
-        else if (strcmp(argv[i], "-o") == 0)
+
+        uint32_t threadCount = 0;
+        if (argc >= 5 && strcmp(argv[3], "-thread") == 0)
+        { threadCount = uint32_t(strtoul(argv[4], nullptr, 10)); }
+
+        return RunServer(argv[2], threadCount);
+    }
+
+    // 常駐サーバーに変換を依頼.
+    //  -client <socket path> <通常の引数...>
+    if (strcmp(argv[1], "-client") == 0)
+    {
+        if (argc < 3)
         {
-            i++;
-            output = argv[i];
+            ELOGA("Error : Missing Socket Path.");
+            return -1;
         }
-        else if (strcmp(argv[i], "-m") == 0)
+
+        return RunClient(argv[2], argc - 3, argv + 3);
+    }
+
+    // 読み込み時間を比較.
+    //  -bench <model path> <mapped model path> [count]
+    if (strcmp(argv[1], "-bench") == 0)
+    {
+        if (argc < 4)
         {
-            i++;
-            matyaml = argv[i];
+            ELOGA("Error : Missing Benchmark Path.");
+            return -1;
         }
+
+        uint32_t count = 10;
+        if (argc >= 5)
+        { count = std::max(1u, uint32_t(strtoul(argv[4], nullptr, 10))); }
+
+        return RunLoadBenchmark(argv[2], argv[3], count);
     }
 
-    asdx::ResModel model;
-    MeshLoader loader;
-    if (!loader.Load(input.c_str(), model))
+    // インポーターの使い回しと並列読み込みによる差を計測.
+    //  -bench_import <count> [-thread <count>] <model path...>
+    if (strcmp(argv[1], "-bench_import") == 0)
     {
-        ELOGA("Error : MeshLoader::Load() Failed. path = %s", input.c_str());
-        return -1;
+        if (argc < 4)
+        {
+            ELOGA("Error : Missing Benchmark Path.");
+            return -1;
+        }
+
+        auto count = std::max(1u, uint32_t(strtoul(argv[2], nullptr, 10)));
+
+        auto first = 3;
+        uint32_t threadCount = 0;
+        if (argc >= 6 && strcmp(argv[3], "-thread") == 0)
+        {
+            threadCount = uint32_t(strtoul(argv[4], nullptr, 10));
+            first = 5;
+        }
+
+        return RunImportBenchmark(argc - first, argv + first, count, threadCount);
     }
 
-    if (!matyaml.empty())
+    // 複数のモデルをワーカーごとにインポーターを使い回して並列に変換.
+    //  -batch <model path...> [-batch_thread <count>] <通常の引数...>
+    //  出力パスの {name} は入力ファイル名(拡張子なし)に置換.
+    if (strcmp(argv[1], "-batch") == 0)
     {
-       if (ExportMaterialYaml(matyaml.c_str(), loader.GetMaterials()))
-       { ILOGA("Info : Material Save OK! output path = %s", matyaml.c_str()); }
-       else
-       {
-           ELOGA("Error : ExportMaterialYaml() Failed. path = %s", matyaml.c_str());
-           return -1;
-       }
+        std::vector<const char*> files;
+        auto i = 2;
+        for(; i<argc && argv[i][0] != '-'; ++i)
+        { files.push_back(argv[i]); }
+
+        uint32_t threadCount = 0;
+        std::vector<const char*> convertArgv;
+        for(; i<argc; ++i)
+        {
+            if (strcmp(argv[i], "-batch_thread") != 0)
+            {
+                convertArgv.push_back(argv[i]);
+                continue;
+            }
+
+            if (i + 1 >= argc)
+            {
+                ELOGA("Error : Missing Argument Value. option = %s", argv[i]);
+                return -1;
+            }
+
+            threadCount = uint32_t(strtoul(argv[i + 1], nullptr, 10));
+            i++;
+        }
+
+        return RunBatch(files, threadCount, int(convertArgv.size()), convertArgv.data());
     }
 
-    if (!asdx::SaveModel(output.c_str(), model))
+    // ディレクトリを監視して変更されたモデルを変換.
+    //  -watch <source dir> [-watch_delay <msec>] [-watch_thread <count>] [-watch_queue <count>] [-watch_cache <path>] <通常の引数...>
+    //  出力パスの {name} は監視ディレクトリからの相対パス(拡張子なし)に置換.
+    if (strcmp(argv[1], "-watch") == 0)
     {
-        ELOGA("Error : SaveModel() Fialed. path = %s", output.c_str());
-        return -1;
+        if (argc < 3)
+        {
+            ELOGA("Error : Missing Source Directory.");
+            return -1;
+        }
+
+        WatchOption option;
+        option.SourceDir = argv[2];
+
+        // 監視用の引数は変換オプションのハッシュに含めない.
+        std::vector<const char*> convertArgv;
+        for(auto i=3; i<argc; ++i)
+        {
+            auto isWatchArg = strcmp(argv[i], "-watch_delay")  == 0
+                           || strcmp(argv[i], "-watch_thread") == 0
+                           || strcmp(argv[i], "-watch_queue")  == 0
+                           || strcmp(argv[i], "-watch_cache")  == 0;
+            if (!isWatchArg)
+            {
+                convertArgv.push_back(argv[i]);
+                continue;
+            }
+
+            if (i + 1 >= argc)
+            {
+                ELOGA("Error : Missing Argument Value. option = %s", argv[i]);
+                return -1;
+            }
+
+            if (strcmp(argv[i], "-watch_delay") == 0)
+            { option.DelayMsec = uint32_t(strtoul(argv[i + 1], nullptr, 10)); }
+            else if (strcmp(argv[i], "-watch_thread") == 0)
+            { option.ThreadCount = uint32_t(strtoul(argv[i + 1], nullptr, 10)); }
+            else if (strcmp(argv[i], "-watch_queue") == 0)
+            { option.MaxQueueSize = uint32_t(strtoul(argv[i + 1], nullptr, 10)); }
+            else
+            { option.CachePath = argv[i + 1]; }
+
+            i++;
+        }
+
+        return RunWatch(option, int(convertArgv.size()), convertArgv.data());
     }
 
-    ILOGA("Info : Model Save OK! output path = %s", output.c_str());
+    ConvertArgs args;
+    if (!ParseArgs(argc, argv, args))
+    { return -1; }
+
+    if (!Convert(args))
+    { return -1; }
 
     return 0;
 }
\ No newline at end of file